@@ -4303,10 +4303,11 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
    tResult * result = new tResult();  // Create result
    stPage * currPage;
    stSlimNode * currNode;
-   ObjectType tmpObj;
+   typedef typename ObjectType::ViewType tObjectView;
    u_int32_t idx, numberOfEntries;
    double distance;
    #ifdef __stMAMVIEW__
+      ObjectType tmpObj;
       stMessageString title;
       stMessageString comment;
    #endif //__stMAMVIEW__
@@ -4360,17 +4361,19 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
 
          // For each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
-            // Rebuild the object
-            tmpObj.Unserialize(indexNode->GetObject(idx),
-                               indexNode->GetObjectSize(idx));
-            // Evaluate distance
-            distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+            // Read the object in place, without rebuilding it
+            tObjectView objView(indexNode->GetObject(idx),
+                                indexNode->GetObjectSize(idx));
 
             // Get resolution Diff
-            int resDiff = sample->GetResolution() - tmpObj.GetResolution();
+            int resDiff = sample->GetResolution() - objView.GetResolution();
+            double threshold = range + (indexNode->GetIndexEntry(idx).Radius/pow(2,resDiff));
+
+            // Evaluate distance, abandoning it once it exceeds the threshold
+            distance = this->myMetricEvaluator->GetDistance(objView, *sample, threshold);
 
             // test if this subtree qualifies.
-            if (distance <= range + (indexNode->GetIndexEntry(idx).Radius/pow(2,resDiff))){
+            if (distance <= threshold){
                // Yes! Analyze this subtree.
                this->RangeQuery(indexNode->GetIndexEntry(idx).PageID, result,
                                 sample, range, distance);
@@ -4398,15 +4401,15 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
          
          // For each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
-            // Rebuild the object
-            tmpObj.Unserialize(leafNode->GetObject(idx),
-                               leafNode->GetObjectSize(idx));
-            // Evaluate distance
-            distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+            // Read the object in place, without rebuilding it
+            tObjectView objView(leafNode->GetObject(idx),
+                                leafNode->GetObjectSize(idx));
+            // Evaluate distance, abandoning it once it exceeds the range
+            distance = this->myMetricEvaluator->GetDistance(objView, *sample, range);
             // is it a object that qualified?
             if (distance <= range){
-               // Yes! Put it in the result set.
-               result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+               // Yes! Rebuild it (or just its ID) and put it in the result set.
+               result->AddPair(objView.MaterializeResult(), distance);
             }//end if
          }//end for
       }//end else
@@ -4440,11 +4443,12 @@ void tmpl_stSlimTree::RangeQuery(
          double range, double distanceRepres){
    stPage * currPage;
    stSlimNode * currNode;
-   ObjectType tmpObj;
+   typedef typename ObjectType::ViewType tObjectView;
    double distance;
    u_int32_t idx;
    u_int32_t numberOfEntries;
    #ifdef __stMAMVIEW__
+      ObjectType tmpObj;
       stMessageString comment;
    #endif //__stMAMVIEW__
 
@@ -4486,19 +4490,19 @@ void tmpl_stSlimTree::RangeQuery(
             // use of the triangle inequality to cut a subtree
             // if ( fabs(distanceRepres - indexNode->GetIndexEntry(idx).Distance) <=
             //           range + indexNode->GetIndexEntry(idx).Radius){
-            // Get resolution diff
-            int resDiff = sample->GetResolution() - tmpObj.GetResolutionSerial(indexNode->GetObject(idx), indexNode->GetObjectSize(idx));
+            // Read the object in place and get resolution diff
+            tObjectView objView(indexNode->GetObject(idx),
+                                indexNode->GetObjectSize(idx));
+            int resDiff = sample->GetResolution() - objView.GetResolution();
             if ((distanceRepres - (indexNode->GetIndexEntry(idx).Distance/pow(2,resDiff)) <=
                          range + (indexNode->GetIndexEntry(idx).Radius/pow(2,resDiff)) && resDiff != 0) ||
                 ((fabs(distanceRepres - indexNode->GetIndexEntry(idx).Distance) <=
                           range + indexNode->GetIndexEntry(idx).Radius) && resDiff == 0)){
-               // Rebuild the object
-               tmpObj.Unserialize(indexNode->GetObject(idx),
-                                  indexNode->GetObjectSize(idx));
-               // Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+               // Evaluate distance, abandoning it once it exceeds the threshold
+               double threshold = range + (indexNode->GetIndexEntry(idx).Radius/pow(2,resDiff));
+               distance = this->myMetricEvaluator->GetDistance(objView, *sample, threshold);
                // is this a qualified subtree?
-               if (distance <= range + (indexNode->GetIndexEntry(idx).Radius/pow(2,resDiff))){
+               if (distance <= threshold){
                   // Yes! Analyze it!
                   this->RangeQuery(indexNode->GetIndexEntry(idx).PageID, result,
                                     sample, range, distance);
@@ -4549,20 +4553,19 @@ void tmpl_stSlimTree::RangeQuery(
             // if ( fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <=
             //           range){
             // Get resolution diff
-            stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
-            int resDiff = sample->GetResolution() - tmpObj.GetResolutionSerial(indexNode->GetObject(idx), indexNode->GetObjectSize(idx));
+            tObjectView objView(leafNode->GetObject(idx),
+                                leafNode->GetObjectSize(idx));
+            int resDiff = sample->GetResolution() - objView.GetResolution();
             if ((distanceRepres - (leafNode->GetLeafEntry(idx).Distance/pow(2,resDiff)) <=
                       range && resDiff != 0) ||
                 (fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <= range && resDiff == 0)){
-               // Rebuild the object
-               tmpObj.Unserialize(leafNode->GetObject(idx),
-                                  leafNode->GetObjectSize(idx));
-               // No, it is not a representative. Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+               // No, it is not a representative. Evaluate distance in place,
+               // abandoning it once it exceeds the range
+               distance = this->myMetricEvaluator->GetDistance(objView, *sample, range);
                // Is this a qualified object?
                if (distance <= range){
-                  // Yes! Put it in the result set.
-                  result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+                  // Yes! Rebuild it (or just its ID) and put it in the result set.
+                  result->AddPair(objView.MaterializeResult(), distance);
                }//end if
             }//end if
          }//end for
@@ -5153,7 +5156,7 @@ void stSlimTree<ObjectType, EvaluatorType>::NearestQuery(tResult * result,
    u_int32_t idx;
    stPage * currPage;
    stSlimNode * currNode;
-   ObjectType tmpObj;
+   typedef typename ObjectType::ViewType tObjectView;
    double distance;
    double distanceRepres = 0;
    u_int32_t numberOfEntries;
@@ -5161,6 +5164,7 @@ void stSlimTree<ObjectType, EvaluatorType>::NearestQuery(tResult * result,
    stQueryPriorityQueueValue pqTmpValue;
    bool stop;
    #ifdef __stMAMVIEW__
+      ObjectType tmpObj;
       stMessageString comment;
    #endif //__stMAMVIEW__   
 
@@ -5214,11 +5218,11 @@ void stSlimTree<ObjectType, EvaluatorType>::NearestQuery(tResult * result,
             // try to cut this subtree with the triangle inequality.
             if ( fabs(distanceRepres - indexNode->GetIndexEntry(idx).Distance) <=
                       rangeK + indexNode->GetIndexEntry(idx).Radius){
-               // Rebuild the object
-               tmpObj.Unserialize(indexNode->GetObject(idx),
-                                  indexNode->GetObjectSize(idx));
+               // Read the object in place, without rebuilding it
+               tObjectView objView(indexNode->GetObject(idx),
+                                   indexNode->GetObjectSize(idx));
                // Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+               distance = this->myMetricEvaluator->GetDistance(objView, *sample);
 
                if (distance <= rangeK + indexNode->GetIndexEntry(idx).Radius){
                   // Yes! I'm qualified! Put it in the queue.
@@ -5262,17 +5266,17 @@ void stSlimTree<ObjectType, EvaluatorType>::NearestQuery(tResult * result,
             // try to cut this object with the triangle inequality.
             if ( fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <=
                       rangeK){
-               // Rebuild the object
-               tmpObj.Unserialize(leafNode->GetObject(idx),
-                                  leafNode->GetObjectSize(idx));
+               // Read the object in place, without rebuilding it
+               tObjectView objView(leafNode->GetObject(idx),
+                                   leafNode->GetObjectSize(idx));
                // When this entry is a representative, it does not need to evaluate
                // a distance, because distanceRepres is iqual to distance.
                // Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+               distance = this->myMetricEvaluator->GetDistance(objView, *sample);
                //test if the object qualify
                if (distance <= rangeK){
-                  // Add the object.
-                  result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+                  // Rebuild (or just identify) and add the object.
+                  result->AddPair(objView.MaterializeResult(), distance);
                   // there is more than k elements?
                   if (result->GetNumOfEntries() >= k){
                      //cut if there is more than k elements
@@ -8411,104 +8415,76 @@ int tmpl_stSlimTree::BulkLoadSampled(ObjectType **objects, u_int32_t numObj, dou
    // get the first ones - @todo: Change this to get random
 
 
+   ObjectType *newObj; // Object
    u_int32_t newObjSize = 0;
-   for(int i=0;i<numOfSamples;i++) {
+   for(u_int32_t i=0;i<numOfSamples;i++) {
 
       newObj = objects[currObj];
       newObjSize = newObj->GetSerializedSize();
       // Insert the new object.
       samplePage[i] = this->NewPage();
-      sampleNode[i] = new SlimLeafNode(samplePage[i],true); // @todo: Change this to work
+      sampleNode[i] = new stSlimLeafNode(samplePage[i],true); // @todo: Change this to work
       insertIdx = sampleNode[i]->AddEntry(newObjSize,
                                           newObj->Serialize());
 
       currObj++; // @todo: Change this to get random
    }
 
-
-   // Current insertion object
-   newObj = objects[currObj];
-
-   // Number of objects in the current node
-   u_int32_t numObjNode = 0;
-
-
-   // While has space
-   //while((leafNode->GetFree()*leafNodeOccupancy>newObjSize+sizeof(stSlimLeafNode::stSlimLeafEntry))&&(currObj<numObj)) {
-
    // While has space in all sample nodes
-   while(true) {
+   while(currObj<numObj) {
+
+      // Current insertion object
+      newObj = objects[currObj];
 
       ObjectType rep; // Object
 
       double minDist = MAXDOUBLE;
-      u_int32_t sampleIdx;
+      u_int32_t sampleIdx = 0;
 
       //Choose the corret node to insert - @todo: Change this to get random
-      for(int i=0;i<numOfSamples;i++) {
+      for(u_int32_t i=0;i<numOfSamples;i++) {
          rep.Unserialize(sampleNode[i]->GetObject(0), // Rep is always the first element in this case
                             sampleNode[i]->GetObjectSize(0));
-         double distance = this->myMetricEvaluator->GetDistance(newObj, &rep);
+         double distance = this->myMetricEvaluator->GetDistance(*newObj, rep);
          if(distance < minDist) {
-            distance = minDist;
+            minDist = distance;
             sampleIdx = i;
          }
       }
 
+      #ifdef __stPRINTMSG__
+         cout << endl << "Inserting the following object #: " << currObj << endl;
+      #endif //__stPRINTMSG__
+
       newObjSize = newObj->GetSerializedSize();
-      insertIdx = sampleNode[i]->AddEntry(newObjSize,
-                                          newObj->Serialize());
+      insertIdx = sampleNode[sampleIdx]->AddEntry(newObjSize,
+                                                  newObj->Serialize());
       currObj++;
 
-      if(sampleNode[i]->GetFree()*leafNodeOccupancy<=newObjSize+sizeof(stSlimLeafNode::stSlimLeafEntry)) { // no space for other object with the same size
-         auxPage = samplePage[i];
-         delete sampleNode[i];
-		 sampleNode[i] = 0;
+      if(sampleNode[sampleIdx]->GetFree()*leafNodeOccupancy<=newObjSize+sizeof(stSlimLeafNode::stSlimLeafEntry)) { // no space for other object with the same size
+         auxPage = samplePage[sampleIdx];
+         delete sampleNode[sampleIdx];
+         sampleNode[sampleIdx] = 0;
          //Choose another - @todo: Change this to get random
          //@TODO!!!!!!!
          return currObj;
-
       }
 
+      #ifdef __stDEBUG__
+      // Test if the page size is too big to store an object.
+      if (insertIdx < 0){
+         // Oops. There is an error during the insertion.
+            cout << "The page size is too small for the first object. Increase it!\n";
+            // Throw an exception.
+            throw std::logic_error("The page size is too small to store the first object.");
+         // The new object was not inserted.
+         //return false;
+      } //end if
+      #endif //__stDEBUG__
 
+   } //end while
 
-         #ifdef __stPRINTMSG__
-            cout << endl << "Inserting the following object #: " << currObj << endl;
-         #endif //__stPRINTMSG__
-
-         // Insert the new object.
-         insertIdx = leafNode->AddEntry(newObj->GetSerializedSize(),
-                                        newObj->Serialize());
-
-         #ifdef __stPRINTMSG__
-            cout << endl << "Insertion OK! Object #: " << currObj << " " << *newObj << ". " << endl;
-         #endif //__stPRINTMSG__
-
-         currObj++; // Next object.
-         numObjNode++;
-
-         // Get the right object
-         if(currObj<numObj) {
-            newObj = objects[currObj];
-            newObjSize = newObj->GetSerializedSize();
-         } //end if
-
-
-         #ifdef __stDEBUG__
-         // Test if the page size is too big to store an object.
-         if (insertIdx < 0){
-            // Oops. There is an error during the insertion.
-               cout << "The page size is too small for the first object. Increase it!\n";
-               // Throw an exception.
-               throw std::logic_error("The page size is too small to store the first object.");
-            // The new object was not inserted.
-            //return false;
-         } //end if
-         #endif //__stDEBUG__
-
-      } //end while
-
-      return currObj;
+   return currObj;
 
 }
 
@@ -8516,9 +8492,7 @@ int tmpl_stSlimTree::BulkLoadSampled(ObjectType **objects, u_int32_t numObj, dou
 
 template <class ObjectType, class EvaluatorType>
 bool tmpl_stSlimTree::BulkLoadOrdered(ObjectType **objects, u_int32_t numObj, double leafNodeOccupancy, double indexNodeOccupancy, enum tBulkMethod method){
-   if(method == bulkRANDOM) {
-      randomize();
-   }
+   // bulkRANDOM draws with rand(), seeded by the caller like the rest of the tree
 
    int currObj = 0;  // Number of current object
 
@@ -8564,13 +8538,13 @@ bool tmpl_stSlimTree::BulkLoadOrdered(ObjectType **objects, u_int32_t numObj, do
                if(idx!=repIdx) {
                   obj.Unserialize(leafNode->GetObject(idx),
                                   leafNode->GetObjectSize(idx));
-                  distance = this->myMetricEvaluator->GetDistance(&obj, &rep);
+                  distance = this->myMetricEvaluator->GetDistance(obj, rep);
                } //end if
                leafNode->GetLeafEntry(idx).Distance = distance;
             }
             break;
          case bulkRANDOM: // random object
-            repIdx = numObjNode * random(RAND_MAX) / (RAND_MAX + 1);
+            repIdx = rand() % numObjNode;
             rep.Unserialize(leafNode->GetObject(repIdx),
                             leafNode->GetObjectSize(repIdx));
             //Update the distance
@@ -8578,7 +8552,7 @@ bool tmpl_stSlimTree::BulkLoadOrdered(ObjectType **objects, u_int32_t numObj, do
                if(idx!=repIdx) {
                   obj.Unserialize(leafNode->GetObject(idx),
                                   leafNode->GetObjectSize(idx));
-                  distance = this->myMetricEvaluator->GetDistance(&obj, &rep);
+                  distance = this->myMetricEvaluator->GetDistance(obj, rep);
                } else {
                   distance = 0;
                } //end if
@@ -8605,7 +8579,7 @@ bool tmpl_stSlimTree::BulkLoadOrdered(ObjectType **objects, u_int32_t numObj, do
                for(int j=i+1;j<numObjNode;j++) {
                   obj2.Unserialize(leafNode->GetObject(j),
                                    leafNode->GetObjectSize(j));
-                  distMatrix[i][j] = this->myMetricEvaluator->GetDistance(&obj1, &obj2);
+                  distMatrix[i][j] = this->myMetricEvaluator->GetDistance(obj1, obj2);
                   distMatrix[j][i] = distMatrix[i][j];
                   if(distMatrix[j][i] > maxDist) {
                      maxDist = distMatrix[j][i];
@@ -8707,7 +8681,7 @@ bool tmpl_stSlimTree::BulkLoadOrdered(ObjectType **objects, u_int32_t numObj, do
       for(int idx=0;idx<numberOfEntries;idx++) {
          tmpObj.Unserialize(currNode->GetObject(idx),
                             currNode->GetObjectSize(idx));
-         currNode->GetIndexEntry(idx).Distance = this->myMetricEvaluator->GetDistance(&tmpObj, &repObj);
+         currNode->GetIndexEntry(idx).Distance = this->myMetricEvaluator->GetDistance(tmpObj, repObj);
 
       }
 
@@ -8827,7 +8801,7 @@ bool tmpl_stSlimTree::BulkInsert(stSubtreeInfo & sub1, stSubtreeInfo & sub, doub
                if(idx!=bestIdx) {
                   tmpObj.Unserialize(currNode->GetObject(idx),
                                      currNode->GetObjectSize(idx));
-                  distance = this->myMetricEvaluator->GetDistance(&tmpObj, repObj);
+                  distance = this->myMetricEvaluator->GetDistance(tmpObj, *repObj);
                } else {
                   distance = 0;
                }
@@ -8835,7 +8809,7 @@ bool tmpl_stSlimTree::BulkInsert(stSubtreeInfo & sub1, stSubtreeInfo & sub, doub
             }
             break;
          case bulkRANDOM:
-            bestIdx = numberOfEntries * random(RAND_MAX) / (RAND_MAX + 1);
+            bestIdx = rand() % numberOfEntries;
 
             tmpObj.Unserialize(currNode->GetObject(bestIdx),
                                currNode->GetObjectSize(bestIdx));
@@ -8847,7 +8821,7 @@ bool tmpl_stSlimTree::BulkInsert(stSubtreeInfo & sub1, stSubtreeInfo & sub, doub
                if(idx!=bestIdx) {
                   tmpObj.Unserialize(currNode->GetObject(idx),
                                      currNode->GetObjectSize(idx));
-                  distance = this->myMetricEvaluator->GetDistance(&tmpObj, repObj);
+                  distance = this->myMetricEvaluator->GetDistance(tmpObj, *repObj);
                } else {
                   distance = 0;
                }
@@ -8876,7 +8850,7 @@ bool tmpl_stSlimTree::BulkInsert(stSubtreeInfo & sub1, stSubtreeInfo & sub, doub
                for(int j=i+1;j<numberOfEntries;j++) {
                   obj2.Unserialize(currNode->GetObject(j),
                                    currNode->GetObjectSize(j));
-                  distMatrix[i][j] = this->myMetricEvaluator->GetDistance(&obj1, &obj2);
+                  distMatrix[i][j] = this->myMetricEvaluator->GetDistance(obj1, obj2);
                   distMatrix[j][i] = distMatrix[i][j];
                   if(distMatrix[j][i] > maxDist) {
                      maxDist = distMatrix[j][i];
@@ -9136,7 +9110,7 @@ u_int32_t tmpl_stSlimTree::getNumLeafNodeObj(u_int32_t objSize) {
 } //end stSlimTree<ObjectType, EvaluatorType>::getNumLeafNodeObj
 
 
-bool searchIdx(int array[], u_int32_t size, u_int32_t value) {
+inline bool searchIdx(int array[], u_int32_t size, u_int32_t value) {
    u_int32_t tmpIdx = 0;
    for(;tmpIdx<size; tmpIdx++) {
       if(array[tmpIdx] == value) return true;
@@ -9259,7 +9233,7 @@ bool tmpl_stSlimTree::BulkLoadMemory(vector< SampleSon<ObjectType> > objects, in
                                                 newObj->Serialize());
 
          // distance calculation
-         leafNode->GetLeafEntry(insertIdx).Distance = this->myMetricEvaluator->GetDistance(newObj, objects[repIdx].getObject());
+         leafNode->GetLeafEntry(insertIdx).Distance = this->myMetricEvaluator->GetDistance(*newObj, *objects[repIdx].getObject());
 
       } //end for
 
@@ -9320,7 +9294,7 @@ bool tmpl_stSlimTree::BulkLoadMemory(vector< SampleSon<ObjectType> > objects, in
          double dist = 0.0;
          double distOld = 0.0;
 	 for(u_int32_t j=0;j<numObjects;j++) {
-	    dist = this->myMetricEvaluator->GetDistance(sample[j].getObject(), objects[i].getObject());
+	    dist = this->myMetricEvaluator->GetDistance(*sample[j].getObject(), *objects[i].getObject());
 	    if((choice == -1) || (dist < distOld)) {
 	       distOld = dist;
                choice = j;
@@ -9419,7 +9393,7 @@ bool tmpl_stSlimTree::BulkLoadMemory(vector< SampleSon<ObjectType> > objects, in
          double dist = 0.0;
          double distOld = 0.0;
 	 for(u_int32_t j=0;j<candidates.size();j++) {
-	    dist = this->myMetricEvaluator->GetDistance(sample[candidates[j]].getObject(), newObjs[i].getObject());
+	    dist = this->myMetricEvaluator->GetDistance(*sample[candidates[j]].getObject(), *newObjs[i].getObject());
 	    if((choice == -1) || (dist < distOld)) {
 	       distOld = dist;
                choice = candidates[j];
@@ -9434,7 +9408,7 @@ bool tmpl_stSlimTree::BulkLoadMemory(vector< SampleSon<ObjectType> > objects, in
                if(samplesVector[j].size()>numberObjBucket) {
                   continue;
                } //end if
-	       dist = this->myMetricEvaluator->GetDistance(sample[j].getObject(), newObjs[i].getObject());
+	       dist = this->myMetricEvaluator->GetDistance(*sample[j].getObject(), *newObjs[i].getObject());
 	       if((choice == -1) || (dist < distOld)) {
 	          distOld = dist;
                   choice = j;
@@ -9506,7 +9480,7 @@ bool tmpl_stSlimTree::BulkLoadMemory(vector< SampleSon<ObjectType> > objects, in
                    double distOld = 0.0;
                    for(u_int32_t j=0;j<numDiv;j++) {
 
-                      dist = this->myMetricEvaluator->GetDistance(samplesVector[i][j].getObject(), samplesVector[i][idx].getObject());
+                      dist = this->myMetricEvaluator->GetDistance(*samplesVector[i][j].getObject(), *samplesVector[i][idx].getObject());
                       if((choice == -1) || (dist < distOld)) {
                          distOld = dist;
                          if(newSamplesVector[j].size() < numberObjBucket)
@@ -9580,7 +9554,7 @@ bool tmpl_stSlimTree::BulkLoadMemory(vector< SampleSon<ObjectType> > objects, in
            uniRep = newIndexObj;
            indexNode->GetIndexEntry(insertIdx).Distance = 0;
         } else {
-           indexNode->GetIndexEntry(insertIdx).Distance = this->myMetricEvaluator->GetDistance(newIndexObj, uniRep);
+           indexNode->GetIndexEntry(insertIdx).Distance = this->myMetricEvaluator->GetDistance(*newIndexObj, *uniRep);
         } //end if
 
       } //end for
@@ -4,87 +4,366 @@
 #include <vector>              // Para std::vector
 #include <string>              // Para std::string
 #include <cstdio>              // Para snprintf
-#include <optional>            // Para std::optional (C++17)
+#include <cstring>             // Para memchr
+#include <charconv>            // Para std::from_chars
+#include <algorithm>           // Para std::min, std::max, std::count_if
+#include <thread>              // Para std::thread
+#include <functional>          // Para std::function
+
+#include <fcntl.h>             // Para open
+#include <sys/mman.h>          // Para mmap
+#include <sys/stat.h>          // Para fstat
+#include <unistd.h>            // Para close
 
 #include "VectorFileReader.hpp"
+#include "binary_dataset.h"
 #include "complex_object.h"
+#include "haar_transform.h"
+
+namespace {
+
+// Tamanho mínimo de cada bloco no modo automático (arquivos pequenos usam uma thread só)
+const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+// Resultado do parsing de uma linha
+enum LineStatus {
+    LINE_OK,          // label, resolução e doubles lidos
+    LINE_MALFORMED,   // label/resolução inválidos
+    LINE_NON_NUMERIC  // dado não numérico após os doubles
+};
+
+// Linha parseada por um bloco; os doubles ficam no buffer contíguo do bloco
+struct ParsedLine {
+    int localLine;            // Índice da linha dentro do bloco (0 = primeira)
+    LineStatus status;
+    const char* begin;        // Conteúdo da linha (sem o '\n')
+    const char* end;
+    const char* label;        // Label (aponta para dentro da linha)
+    size_t labelLength;
+    int resolution;
+    size_t valueBegin;        // Posição dos doubles no buffer do bloco
+    size_t valueCount;
+};
+
+// Linhas e doubles de um bloco do arquivo
+struct ParsedChunk {
+    const char* begin;
+    const char* end;
+    int lineCount;                    // Linhas do bloco (inclusive vazias)
+    std::vector<ParsedLine> lines;    // Apenas linhas não vazias
+    std::vector<double> values;       // Doubles de todas as linhas, em sequência
+};
+
+// Mesmo conjunto de espaços do operator>> no locale "C"
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
 
-// --- Implementação do Construtor ---
-VectorFileReader::VectorFileReader() : numLines(0), numElements(-1) {
-    // Inicializa os contadores. numElements = -1 indica que o tamanho ainda não foi definido.
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
 }
 
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
 
-std::optional<VectorEntry> VectorFileReader::parseLine(const std::string& line, int line_number) const {
-     // Ignora linhas vazias ou que contenham apenas espaços em branco (verificação extra)
-    if (line.empty() || line.find_first_not_of(" \t\n\v\f\r") == std::string::npos) {
-        return std::nullopt; // Linha vazia/whitespace, não é um erro, apenas ignora
+// Lê um int como o operator>>: aceita sinal '+' ou '-' antes dos dígitos
+inline const char* parseInt(const char* p, const char* end, int& value) {
+    if (p < end && *p == '+') {
+        ++p;
+        if (p < end && *p == '-') {
+            return nullptr;
+        }
     }
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return (result.ec == std::errc()) ? result.ptr : nullptr;
+}
 
-    std::stringstream ss(line);
-    std::string tempLabel;
-    int tempResolution;
+// Lê um double como o operator>>: aceita '+', mas não "inf"/"nan" nem hexadecimal
+inline const char* parseDouble(const char* p, const char* end, double& value) {
+    if (p < end && *p == '+') {
+        ++p;
+        if (p < end && *p == '-') {
+            return nullptr;
+        }
+    }
+    const char* digits = (p < end && *p == '-') ? p + 1 : p;
+    if (digits >= end || !(isDigit(*digits) || *digits == '.')) {
+        return nullptr;
+    }
+    std::from_chars_result result = std::from_chars(p, end, value, std::chars_format::general);
+    return (result.ec == std::errc()) ? result.ptr : nullptr;
+}
 
-    // Tenta ler o nome (string) e a resolução (int) da linha
-    if (!(ss >> tempLabel >> tempResolution)) {
-        // Formato inicial incorreto
-        std::cerr << "Aviso: Linha " << line_number << " mal formatada (label/resolution). Ignorando." << std::endl;
-        return std::nullopt; // Falha no parsing inicial
+/**
+ * Parseia a linha [p, end). Retorna false para linhas vazias ou só com espaços.
+ * Em caso de sucesso os doubles são acrescentados a 'values'.
+ */
+bool parseLineSpan(const char* p, const char* end, ParsedLine& line, std::vector<double>& values) {
+    line.begin = p;
+    line.end = end;
+    p = skipBlanks(p, end);
+    if (p == end) {
+        return false;
+    }
+
+    // Label: sequência de caracteres sem espaço
+    line.label = p;
+    while (p < end && !isBlank(*p)) {
+        ++p;
+    }
+    line.labelLength = static_cast<size_t>(p - line.label);
+
+    // Resolução
+    p = parseInt(skipBlanks(p, end), end, line.resolution);
+    if (p == nullptr) {
+        line.status = LINE_MALFORMED;
+        return true;
+    }
+
+    // Doubles restantes
+    line.valueBegin = values.size();
+    for (p = skipBlanks(p, end); p < end; p = skipBlanks(p, end)) {
+        double value;
+        p = parseDouble(p, end, value);
+        if (p == nullptr) {
+            values.resize(line.valueBegin);
+            line.status = LINE_NON_NUMERIC;
+            return true;
+        }
+        values.push_back(value);
     }
+    line.valueCount = values.size() - line.valueBegin;
+    line.status = LINE_OK;
+    return true;
+}
 
-    // Cria uma nova entrada temporária
-    VectorEntry entry;
-    entry.resolution = tempResolution;
-    snprintf(entry.label, sizeof(entry.label), "%s", tempLabel.c_str());
+// Número de threads para processar 'size' bytes (0 pedidas = automático)
+size_t chooseThreadCount(unsigned requested, size_t size) {
+    if (requested > 0) {
+        return requested;
+    }
+    return std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), size / MIN_CHUNK_BYTES));
+}
 
-    // Lê os valores double restantes na linha
-    double dataValue;
-    while (ss >> dataValue) {
-        entry.data.push_back(dataValue);
+void parseChunk(ParsedChunk& chunk, int targetResolution) {
+    chunk.lineCount = 0;
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* newline = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(chunk.end - p)));
+        const char* lineEnd = (newline != nullptr) ? newline : chunk.end;
+
+        ParsedLine line;
+        line.localLine = chunk.lineCount++;
+        if (parseLineSpan(p, lineEnd, line, chunk.values)) {
+            if (line.status == LINE_OK && chunk.lines.empty() && line.valueCount > 0) {
+                // Pré-aloca o buffer estimando as linhas do bloco pelo tamanho da primeira
+                const size_t lineBytes = static_cast<size_t>(lineEnd - p) + 1;
+                const size_t estimatedLines = static_cast<size_t>(chunk.end - chunk.begin) / lineBytes + 1;
+                chunk.values.reserve(estimatedLines * line.valueCount);
+                chunk.lines.reserve(estimatedLines);
+            }
+            if (line.status == LINE_OK) {
+                line.resolution = haarToResolution(chunk.values.data() + line.valueBegin, line.valueCount,
+                                                   line.resolution, targetResolution);
+            }
+            chunk.lines.push_back(line);
+        }
+        p = lineEnd + 1;
     }
+}
 
-    // Verifica se ocorreu algum erro *depois* de ler os doubles
-    if (!ss.eof() && ss.fail()) {
-        // Encontrou algo não numérico após os doubles.
+// Imprime o aviso de uma linha rejeitada; retorna false se a linha for válida
+bool reportRejectedLine(const ParsedLine& line, int line_number) {
+    if (line.status == LINE_MALFORMED) {
+        std::cerr << "Aviso: Linha " << line_number << " mal formatada (label/resolution). Ignorando." << std::endl;
+        return true;
+    }
+    if (line.status == LINE_NON_NUMERIC) {
         std::cerr << "Aviso: Linha " << line_number << " ignorada. Encontrado dado não numérico após os doubles." << std::endl;
-        return std::nullopt; // Falha no parsing dos dados
+        return true;
+    }
+    return false;
+}
+
+// Conteúdo de um arquivo: mapeado em memória ou, se não for possível (pipe, etc.), lido para um buffer
+class FileContents {
+public:
+    ~FileContents() {
+        if (mapped != nullptr) {
+            munmap(mapped, length);
+        }
     }
 
-    // Se chegou até aqui, o parsing foi bem-sucedido
-    return entry; // Retorna o VectorEntry dentro de um optional
+    bool open(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                madvise(address, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                mapped = address;
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+        close(fd);
+        if (mapped == nullptr) {
+            std::ifstream inputFile(filename, std::ios::binary);
+            std::stringstream contents;
+            contents << inputFile.rdbuf();
+            buffer = contents.str();
+            length = buffer.size();
+        }
+        return true;
+    }
+
+    const char* data() const { return (mapped != nullptr) ? static_cast<const char*>(mapped) : buffer.data(); }
+    size_t size() const { return length; }
+
+    // Devolve ao sistema as páginas mapeadas antes de 'offset', que não serão mais lidas
+    void release(size_t offset) {
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        offset = std::min(offset, length) / pageSize * pageSize;
+        if (mapped != nullptr && offset > released) {
+            madvise(static_cast<char*>(mapped) + released, offset - released, MADV_DONTNEED);
+            released = offset;
+        }
+    }
+
+private:
+    void* mapped = nullptr;
+    size_t length = 0;
+    size_t released = 0;
+    std::string buffer;
+};
+
+// Intervalo entre as liberações de páginas já lidas na leitura registro a registro
+const size_t STREAM_RELEASE_BYTES = 64 * 1024 * 1024;
+
+} // namespace
+
+// --- Implementação do Construtor ---
+VectorFileReader::VectorFileReader() : numLines(0), numElements(-1), parseThreads(0), targetResolution(-1) {
+    // Inicializa os contadores. numElements = -1 indica que o tamanho ainda não foi definido.
 }
 
-bool VectorFileReader::checkSizeAndAdd(VectorEntry&& entry, const std::string& line, int line_number) {
-    // Obtém o tamanho do vetor de dados da entrada atual
-    size_t current_data_size = entry.data.size();
+void VectorFileReader::setParseThreads(unsigned threads) {
+    this->parseThreads = threads;
+}
+
+void VectorFileReader::setTargetResolution(int resolution) {
+    this->targetResolution = resolution;
+}
 
+void VectorFileReader::reportUnreachedResolution(size_t unreached) const {
+    if (unreached > 0) {
+        std::cerr << "Aviso: " << unreached << " entrada(s) não puderam ser levadas à resolução " << this->targetResolution
+                  << " e ficaram na resolução mais próxima alcançável." << std::endl;
+    }
+}
+
+bool VectorFileReader::checkSize(size_t current_data_size, std::string_view line, int line_number) {
     if (this->numElements == -1) {
         // É a primeira linha válida encontrada. Define o tamanho esperado (numElements).
         this->numElements = static_cast<int>(current_data_size); // Assume que size_t cabe em int
-        // Adiciona a primeira entrada válida ao vetor principal
-        this->vectors.push_back(std::move(entry)); // Move a entrada para o vetor
         return true; // Sucesso (primeira entrada)
-    } else {
-        // Já temos um tamanho esperado (numElements). Compara com o tamanho atual.
-        if (static_cast<int>(current_data_size) != this->numElements) {
-            // Erro: Tamanho inconsistente!
-            std::cerr << "\nErro Crítico: Tamanho de dados inconsistente." << std::endl;
-            std::cerr << "  Linha " << line_number << ": Encontrado " << current_data_size << " elementos de dados." << std::endl;
-            std::cerr << "  Esperado (com base na primeira linha válida): " << this->numElements << " elementos." << std::endl;
-            std::cerr << "  Conteúdo da linha " << line_number << ": \"" << line << "\"" << std::endl;
-            return false; // Falha (inconsistência)
-        } else {
-            // Tamanho consistente. Adiciona a entrada ao vetor principal.
-            this->vectors.push_back(std::move(entry)); // Move a entrada para o vetor
-            return true; // Sucesso (consistente)
-        }
     }
+    // Já temos um tamanho esperado (numElements). Compara com o tamanho atual.
+    if (static_cast<int>(current_data_size) != this->numElements) {
+        // Erro: Tamanho inconsistente!
+        std::cerr << "\nErro Crítico: Tamanho de dados inconsistente." << std::endl;
+        std::cerr << "  Linha " << line_number << ": Encontrado " << current_data_size << " elementos de dados." << std::endl;
+        std::cerr << "  Esperado (com base na primeira linha válida): " << this->numElements << " elementos." << std::endl;
+        std::cerr << "  Conteúdo da linha " << line_number << ": \"" << line << "\"" << std::endl;
+        return false; // Falha (inconsistência)
+    }
+    return true; // Sucesso (consistente)
+}
+
+bool VectorFileReader::checkSizeAndAdd(VectorEntry&& entry, std::string_view line, int line_number) {
+    if (!checkSize(entry.data.size(), line, line_number)) {
+        return false;
+    }
+    // Adiciona a entrada ao vetor principal
+    this->vectors.push_back(std::move(entry)); // Move a entrada para o vetor
+    return true;
 }
 
 
+bool VectorFileReader::parseBuffer(const char* data, size_t size) {
+    // Divide o buffer em blocos que começam sempre no início de uma linha
+    const size_t threadCount = chooseThreadCount(this->parseThreads, size);
+    std::vector<ParsedChunk> chunks;
+    const char* end = data + size;
+    const char* chunkBegin = data;
+    for (size_t c = 1; c <= threadCount && chunkBegin < end; ++c) {
+        const char* chunkEnd = end;
+        if (c < threadCount) {
+            chunkEnd = std::max(chunkBegin, data + size / threadCount * c);
+            const char* newline = static_cast<const char*>(memchr(chunkEnd, '\n', static_cast<size_t>(end - chunkEnd)));
+            chunkEnd = (newline != nullptr) ? newline + 1 : end;
+        }
+        ParsedChunk chunk;
+        chunk.begin = chunkBegin;
+        chunk.end = chunkEnd;
+        chunks.push_back(std::move(chunk));
+        chunkBegin = chunkEnd;
+    }
+
+    // Parseia os blocos em paralelo (o primeiro na thread atual), já levando
+    // cada linha à resolução pedida
+    std::vector<std::thread> workers;
+    for (size_t c = 1; c < chunks.size(); ++c) {
+        workers.emplace_back(parseChunk, std::ref(chunks[c]), this->targetResolution);
+    }
+    if (!chunks.empty()) {
+        parseChunk(chunks[0], this->targetResolution);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Aplica avisos e verificação de tamanho na ordem das linhas
+    size_t total = 0;
+    for (const ParsedChunk& chunk : chunks) {
+        total += chunk.lines.size();
+    }
+    this->vectors.reserve(total);
+
+    int firstLine = 1;
+    for (const ParsedChunk& chunk : chunks) {
+        for (const ParsedLine& line : chunk.lines) {
+            const int line_number = firstLine + line.localLine;
+            if (reportRejectedLine(line, line_number)) {
+                continue;
+            }
+
+            VectorEntry entry;
+            entry.resolution = line.resolution;
+            snprintf(entry.label, sizeof(entry.label), "%.*s", static_cast<int>(line.labelLength), line.label);
+            entry.data.assign(chunk.values.begin() + line.valueBegin,
+                              chunk.values.begin() + line.valueBegin + line.valueCount);
+
+            if (!checkSizeAndAdd(std::move(entry), std::string_view(line.begin, static_cast<size_t>(line.end - line.begin)), line_number)) {
+                return false;
+            }
+        }
+        firstLine += chunk.lineCount;
+    }
+    return true;
+}
+
 bool VectorFileReader::loadFromFile(const std::string& filename) {
-    std::ifstream inputFile(filename);
-    if (!inputFile) {
+    // Mapeia o arquivo em memória (ou lê tudo para um buffer, se não for possível).
+    // Arquivos no formato binário (binary_dataset.h) são reconhecidos pelo cabeçalho.
+    FileContents contents;
+    if (!contents.open(filename)) {
         std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
         return false;
     }
@@ -94,41 +373,66 @@ bool VectorFileReader::loadFromFile(const std::string& filename) {
     this->numLines = 0;
     this->numElements = -1; // -1 indica que o tamanho ainda não foi determinado
 
-    std::string line;
-    int line_number = 0;
-
-    while (std::getline(inputFile, line)) {
-        line_number++;
-
-        // Tenta parsear a linha usando a função auxiliar
-        std::optional<VectorEntry> parsed_entry = parseLine(line, line_number);
-
-        // Verifica se o parsing foi bem-sucedido
-        if (parsed_entry.has_value()) {
-            // Se sim, verifica a consistência do tamanho e tenta adicionar
-            // Passamos a entrada usando std::move pois ela não será mais usada aqui
-            // se checkSizeAndAdd retornar true.
-            if (!checkSizeAndAdd(std::move(parsed_entry.value()), line, line_number)) {
-                // Erro de inconsistência detectado por checkSizeAndAdd
-                // Mensagem de erro já foi impressa pela função auxiliar.
-                this->vectors.clear();    // Limpa o vetor
-                this->numLines = 0;       // Reseta contadores
-                this->numElements = -1;
-                inputFile.close();      // Fecha o arquivo
-                std::cerr << "  Abortando leitura. Nenhum dado foi carregado devido à inconsistência." << std::endl;
-                return false;           // Retorna falha
+    const char* data = contents.data();
+    const size_t size = contents.size();
+
+    if (isBinaryDataset(data, size)) {
+        // Formato binário: os coeficientes já estão prontos, não há parsing
+        TBinaryDataset dataset;
+        if (!dataset.Attach(data, size)) {
+            std::cerr << "Erro: Arquivo binário inválido ou incompleto: " << filename << std::endl;
+            return false;
+        }
+        this->vectors.reserve(dataset.GetCount());
+        for (size_t i = 0; i < dataset.GetCount(); ++i) {
+            VectorEntry entry;
+            const std::string_view label = dataset.GetLabel(i);
+            const double* coefficients = dataset.GetCoefficients(i);
+            entry.resolution = dataset.GetResolution(i);
+            snprintf(entry.label, sizeof(entry.label), "%.*s", static_cast<int>(label.size()), label.data());
+            entry.data.assign(coefficients, coefficients + dataset.GetDimension());
+            this->vectors.push_back(std::move(entry));
+        }
+        if (this->targetResolution >= 0) {
+            // Transformada em paralelo, cada thread com uma faixa das entradas
+            const size_t count = this->vectors.size();
+            const size_t threadCount = std::min(chooseThreadCount(this->parseThreads, size), std::max<size_t>(1, count));
+            auto transformRange = [this, count, threadCount](size_t part) {
+                for (size_t i = count * part / threadCount; i < count * (part + 1) / threadCount; ++i) {
+                    VectorEntry& entry = this->vectors[i];
+                    entry.resolution = haarToResolution(entry.data.data(), entry.data.size(), entry.resolution,
+                                                        this->targetResolution);
+                }
+            };
+            std::vector<std::thread> workers;
+            for (size_t part = 1; part < threadCount; ++part) {
+                workers.emplace_back(transformRange, part);
+            }
+            transformRange(0);
+            for (std::thread& worker : workers) {
+                worker.join();
             }
-            // Se checkSizeAndAdd retornou true, a entrada foi adicionada com sucesso.
         }
-        // Se parseLine retornou std::nullopt, a linha foi ignorada (vazia, erro formato, etc.)
-        // A mensagem de aviso já foi impressa por parseLine (se aplicável). Continua para próxima linha.
-
-    } // Fim do while(getline)
-
-    inputFile.close();
+        if (dataset.GetCount() > 0) {
+            this->numElements = static_cast<int>(dataset.GetDimension());
+        }
+    } else if (!parseBuffer(data, size)) {
+        // Erro de inconsistência detectado por checkSizeAndAdd
+        // Mensagem de erro já foi impressa pela função auxiliar.
+        this->vectors.clear();    // Limpa o vetor
+        this->numLines = 0;       // Reseta contadores
+        this->numElements = -1;
+        std::cerr << "  Abortando leitura. Nenhum dado foi carregado devido à inconsistência." << std::endl;
+        return false;           // Retorna falha
+    }
 
     // Atualiza o número de linhas válidas carregadas
     this->numLines = static_cast<int>(this->vectors.size());
+    if (this->targetResolution >= 0) {
+        reportUnreachedResolution(std::count_if(this->vectors.begin(), this->vectors.end(), [this](const VectorEntry& entry) {
+            return entry.resolution != this->targetResolution;
+        }));
+    }
 
     // Se nenhuma linha válida foi carregada, numElements ainda será -1.
     if (this->numLines == 0) {
@@ -144,6 +448,107 @@ bool VectorFileReader::loadFromFile(const std::string& filename) {
 }
 
 
+bool VectorFileReader::forEachObject(const std::string& filename, const std::function<bool(TComplexObject&)>& visitor) {
+    TComplexObject object; // Reutilizado para todos os registros
+    TIngestRecord record;  // Registro parseado (capacidade reaproveitada)
+    return forEachRecord(filename, [&]() { return &record; }, [&](TIngestRecord& parsed) {
+        object.Assign(parsed.Label, parsed.Resolution, parsed.Data.data(), parsed.Data.size());
+        return visitor(object);
+    });
+}
+
+
+bool VectorFileReader::forEachRecord(const std::string& filename, const std::function<TIngestRecord*()>& acquire,
+                                     const std::function<bool(TIngestRecord&)>& visitor) {
+    FileContents contents;
+    if (!contents.open(filename)) {
+        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
+        return false;
+    }
+
+    // Nenhum registro fica guardado; apenas os contadores são atualizados
+    this->vectors.clear();
+    this->numLines = 0;
+    this->numElements = -1;
+
+    const char* data = contents.data();
+    const size_t size = contents.size();
+    TIngestRecord* record = nullptr; // Registro sendo preenchido, até ser entregue
+    size_t unreached = 0;            // Registros que não alcançaram a resolução pedida
+
+    if (isBinaryDataset(data, size)) {
+        TBinaryDataset dataset;
+        if (!dataset.Attach(data, size)) {
+            std::cerr << "Erro: Arquivo binário inválido ou incompleto: " << filename << std::endl;
+            return false;
+        }
+        this->numElements = static_cast<int>(dataset.GetDimension());
+        for (size_t i = 0; i < dataset.GetCount(); ++i) {
+            if ((record = acquire()) == nullptr) {
+                break;
+            }
+            const std::string_view label = dataset.GetLabel(i);
+            const double* coefficients = dataset.GetCoefficients(i);
+            record->Label.assign(label.substr(0, sizeof(VectorEntry::label) - 1));
+            record->Data.assign(coefficients, coefficients + dataset.GetDimension());
+            record->Resolution = haarToResolution(record->Data.data(), record->Data.size(), dataset.GetResolution(i),
+                                                  this->targetResolution);
+            unreached += (this->targetResolution >= 0 && record->Resolution != this->targetResolution) ? 1 : 0;
+            this->numLines++;
+            if (!visitor(*record)) {
+                break;
+            }
+        }
+    } else {
+        const char* end = data + size;
+        const char* p = data;
+        size_t nextRelease = STREAM_RELEASE_BYTES;
+        int line_number = 0;
+        while (p < end) {
+            const char* newline = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char* lineEnd = (newline != nullptr) ? newline : end;
+            line_number++;
+
+            // Uma linha rejeitada não consome o registro obtido
+            if (record == nullptr && (record = acquire()) == nullptr) {
+                break;
+            }
+            ParsedLine line;
+            record->Data.clear();
+            if (parseLineSpan(p, lineEnd, line, record->Data) && !reportRejectedLine(line, line_number)) {
+                if (!checkSize(line.valueCount, std::string_view(line.begin, static_cast<size_t>(line.end - line.begin)), line_number)) {
+                    // Os registros anteriores já foram entregues; só é possível interromper
+                    std::cerr << "  Abortando leitura na linha " << line_number << " devido à inconsistência." << std::endl;
+                    return false;
+                }
+                record->Label.assign(line.label, std::min<size_t>(line.labelLength, sizeof(VectorEntry::label) - 1));
+                record->Resolution = haarToResolution(record->Data.data(), record->Data.size(), line.resolution,
+                                                      this->targetResolution);
+                unreached += (this->targetResolution >= 0 && record->Resolution != this->targetResolution) ? 1 : 0;
+                this->numLines++;
+                TIngestRecord& parsed = *record;
+                record = nullptr;
+                if (!visitor(parsed)) {
+                    break;
+                }
+            }
+            p = lineEnd + 1;
+            if (static_cast<size_t>(p - data) >= nextRelease) {
+                contents.release(static_cast<size_t>(p - data));
+                nextRelease += STREAM_RELEASE_BYTES;
+            }
+        }
+    }
+
+    reportUnreachedResolution(unreached);
+    if (this->numLines == 0) {
+        this->numElements = 0;
+        std::cout << "Aviso: Arquivo '" << filename << "' lido, mas nenhuma entrada de dados válida foi encontrada ou carregada." << std::endl;
+    }
+    return true;
+}
+
+
 // Métodos de acesso
 const std::vector<VectorEntry>& VectorFileReader::getVectors() const { return vectors; }
 
@@ -4,7 +4,9 @@
 // #include "VectorData.hpp"
 #include <vector>
 #include <string>
-#include <optional>
+#include <string_view>
+#include <cstddef>
+#include <functional>
 
 #include "complex_object.h"
 
@@ -16,6 +18,17 @@ struct VectorEntry {
     std::vector<double> data;
 };
 
+/**
+* One dataset record as parsed by VectorFileReader::forEachRecord. The
+* caller owns it, so its buffers keep their capacity from one record to the
+* next (see TIngestPipeline).
+*/
+struct TIngestRecord {
+    std::string Label;
+    int Resolution = 0;
+    std::vector<double> Data;
+};
+
 
 class VectorFileReader {
 private:
@@ -24,25 +37,44 @@ private:
     std::vector<VectorEntry> vectors;       // Vetores com inforcao das imagens
 
 
+    unsigned parseThreads;                    // Threads do parser (0 = automático)
+    int targetResolution;                     // Resolução entregue (-1 = a do arquivo)
+
+
     // Funções auxiliares privadas
     /**
-     * @brief Tenta parsear uma única linha do arquivo para um VectorEntry.
-     * @param line A string contendo a linha a ser parseada.
-     * @param line_number O número da linha no arquivo (para mensagens de erro).
-     * @return Um std::optional<VectorEntry> contendo a entrada parseada em caso de sucesso,
-     * ou std::nullopt em caso de falha no parsing ou formato inválido.
+     * @brief Parseia o conteúdo completo do arquivo (já em memória) e preenche os vetores.
+     *
+     * O buffer é dividido em blocos alinhados a início de linha, parseados em paralelo
+     * com std::from_chars. Os avisos e a verificação de tamanho são aplicados depois,
+     * na ordem das linhas, exatamente como na leitura linha a linha.
+     * @param data Início do conteúdo do arquivo.
+     * @param size Tamanho do conteúdo em bytes.
+     * @return false se for encontrada uma inconsistência de tamanho.
      */
-     std::optional<VectorEntry> parseLine(const std::string& line, int line_number) const; // Pode ser const
+     bool parseBuffer(const char* data, size_t size);
+
+     /**
+      * @brief Verifica se o número de elementos de uma linha válida é o da primeira linha válida.
+      * @param current_data_size Número de elementos de dados da linha.
+      * @param line A linha original (para mensagens de erro).
+      * @param line_number O número da linha no arquivo.
+      * @return false (após imprimir o erro) se o tamanho for inconsistente.
+      */
+     bool checkSize(size_t current_data_size, std::string_view line, int line_number);
 
      /**
       * @brief Verifica a consistência do tamanho do vetor de dados e adiciona a entrada.
       * @param entry O VectorEntry parseado a ser verificado e potencialmente adicionado.
-      * @param line A string original da linha (para mensagens de erro).
+      * @param line A linha original (para mensagens de erro).
       * @param line_number O número da linha no arquivo.
       * @return true se a entrada for consistente (ou a primeira) e adicionada,
       * false se for encontrada uma inconsistência de tamanho.
       */
-     bool checkSizeAndAdd(VectorEntry&& entry, const std::string& line, int line_number); // Não pode ser const, modifica membros
+     bool checkSizeAndAdd(VectorEntry&& entry, std::string_view line, int line_number); // Não pode ser const, modifica membros
+
+     // Avisa quantas entradas não alcançaram a resolução pedida (nada se forem 0)
+     void reportUnreachedResolution(size_t unreached) const;
 
 public:
     // Construtor
@@ -51,6 +83,49 @@ public:
     // Método para carregar os dados do arquivo
     bool loadFromFile(const std::string& filename);
 
+    /**
+     * @brief Lê o arquivo registro a registro, sem guardar os dados, entregando cada um a 'visitor'.
+     *
+     * O mesmo TComplexObject é reutilizado para todos os registros (o visitante deve copiá-lo
+     * se precisar guardá-lo), de modo que a memória usada não depende do tamanho do arquivo.
+     * Os avisos e a verificação de tamanho são os de loadFromFile, mas como os registros
+     * anteriores já foram entregues, uma linha inconsistente apenas interrompe a leitura.
+     * Ao final, getNumLines() e getNumElements() refletem os registros entregues.
+     * @param filename Arquivo texto ou binário (binary_dataset.h).
+     * @param visitor Recebe cada objeto; retorna false para encerrar a leitura.
+     * @return false se o arquivo não puder ser lido ou tiver tamanho inconsistente.
+     */
+    bool forEachObject(const std::string& filename, const std::function<bool(TComplexObject&)>& visitor);
+
+    /**
+     * @brief Igual a forEachObject, mas cada registro é parseado direto no TIngestRecord do chamador.
+     *
+     * 'acquire' fornece o registro a preencher (o label, a resolução e os coeficientes, já na
+     * resolução pedida) e 'visitor' o recebe preenchido. Um registro obtido e não entregue (o
+     * arquivo terminou) é simplesmente abandonado. Evita a cópia intermediária em um
+     * TComplexObject quando o registro segue para outra thread (TIngestPipeline).
+     * @param acquire Retorna o próximo registro a preencher, ou NULL para encerrar a leitura.
+     * @param visitor Recebe cada registro preenchido; retorna false para encerrar a leitura.
+     * @return false se o arquivo não puder ser lido ou tiver tamanho inconsistente.
+     */
+    bool forEachRecord(const std::string& filename, const std::function<TIngestRecord*()>& acquire,
+                       const std::function<bool(TIngestRecord&)>& visitor);
+
+    /**
+     * @brief Define a resolução em que os vetores são entregues.
+     *
+     * Cada entrada é levada da resolução do arquivo à resolução pedida pela transformada de
+     * Haar (direta para resoluções maiores, inversa para menores) logo após o parsing, nas
+     * mesmas threads do parser. Assim um único arquivo na resolução base (0) substitui os
+     * arquivos de todas as resoluções. Entradas que não podem chegar à resolução pedida
+     * (bloco de aproximação ímpar ou de um elemento) ficam na mais próxima, com um aviso.
+     * @param resolution Resolução desejada, ou -1 (padrão) para manter a do arquivo.
+     */
+    void setTargetResolution(int resolution);
+
+    // Número de threads usadas para parsear o arquivo (0 = automático, conforme o tamanho do arquivo)
+    void setParseThreads(unsigned threads);
+
     // Método para exibir os vetores e suas resoluções
     void displayVectors() const;
 
@@ -12,12 +12,32 @@
 
 #pragma hdrstop // Manter se usar C++Builder
 #include "app.h" // Inclui todas as definições e headers necessários
+#include "page_cache.h"        // evictFileFromPageCache
+#include "ingest_pipeline.h"   // Carga do dataset em estágios paralelos
 
 std::string dataset_file_var = "../data/dados-hist/dataHist20k-3.txt";     // Arquivo com o dataset principal
 std::string query_file_var = "../data/dados-hist/dataHist20k-3-500.txt";    // Arquivo com os objetos de consulta
 double range_query_var = 10000;
 
 int disk_page_size = 131072;
+bool inline_labels_var = false;   // Labels dentro das entradas da árvore (sem arquivo de labels)
+bool print_labels_var = false;    // Imprime os labels dos objetos retornados
+bool pyramid_var = false;         // Grava a pirâmide de aproximações em cada entrada
+bool cold_cache_var = false;      // Descarta o arquivo da árvore do cache de páginas antes de cada consulta
+int dataset_resolution_var = -1;  // Resolução dos objetos do dataset (-1 = a do arquivo)
+int query_resolution_var = -1;    // Resolução dos objetos de consulta (-1 = a do arquivo)
+int ingest_threads_var = 0;       // Threads de transformada na carga do dataset (0 = automático)
+
+// Arquivo de páginas da Slim-tree
+static const char* TREE_FILE_NAME = "SlimTreeComplex.dat";
+
+// Descarta o arquivo da árvore do cache de páginas e devolve o tempo gasto,
+// que as consultas descontam do tempo medido
+static std::chrono::steady_clock::duration evictTreeFromPageCache() {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    evictFileFromPageCache(TREE_FILE_NAME);
+    return std::chrono::steady_clock::now() - begin;
+}
 
 //---------------------------------------------------------------------------
 #pragma package(smart_init) // Manter se usar C++Builder
@@ -27,6 +47,12 @@ int disk_page_size = 131072;
 void TApp::CreateTree() {
     // create for Slim-Tree using the typedef defined in app.h
     // which now uses TComplexObject and TComplexObjectDistanceEvaluator
+    // Pirâmide de aproximações: troca espaço nas páginas por consultas em
+    // resoluções mais grossas sem recalcular as médias
+    TComplexObject::SetStorePyramid(pyramid_var);
+    if (pyramid_var) {
+         std::cout << "INFO: Pirâmide de aproximações habilitada nas entradas." << std::endl;
+    }
     if (PageManager) {
          SlimTree = new mySlimTree(PageManager);
          std::cout << "INFO: Instância mySlimTree criada." << std::endl;
@@ -41,15 +67,49 @@ void TApp::CreateTree() {
 void TApp::CreateDiskPageManager() {
     // Cria o page manager em disco para o SlimTree
     // O nome do arquivo pode ser alterado se desejado.
-    PageManager = new stPlainDiskPageManager("SlimTreeComplex.dat", disk_page_size); // Nome do arquivo alterado opcionalmente
-     std::cout << "INFO: stPlainDiskPageManager criado ('SlimTreeComplex.dat')." << std::endl;
+    PageManager = new stPlainDiskPageManager(TREE_FILE_NAME, disk_page_size); // Nome do arquivo alterado opcionalmente
+     std::cout << "INFO: stPlainDiskPageManager criado ('" << TREE_FILE_NAME << "')." << std::endl;
 } //end TApp::CreateDiskPageManager
 
 //------------------------------------------------------------------------------
-void TApp::Run() {
+void TApp::CreateLabelStore() {
+    TComplexObject::SetInlineLabels(inline_labels_var);
+    if (inline_labels_var) {
+        std::cout << "INFO: Labels armazenados nas entradas da árvore." << std::endl;
+        return;
+    }
+    LabelStore = new TLabelStore();
+    if (!LabelStore->Open("SlimTreeLabels.dat", true)) {
+        std::cerr << "ERRO: Não foi possível criar o arquivo de labels 'SlimTreeLabels.dat'. Labels ficarão nas entradas." << std::endl;
+        delete LabelStore;
+        LabelStore = nullptr;
+        TComplexObject::SetInlineLabels(true);
+        return;
+    }
+    std::cout << "INFO: TLabelStore criado ('SlimTreeLabels.dat')." << std::endl;
+} //end TApp::CreateLabelStore
+
+//------------------------------------------------------------------------------
+std::string TApp::ResolveLabel(const TComplexObject& obj) {
+    if (!obj.GetLabel().empty() || LabelStore == nullptr ||
+        obj.GetObjectID() == TComplexObject::NO_OBJECT_ID) {
+        return obj.GetLabel();
+    }
+    return LabelStore->GetLabel(obj.GetObjectID());
+} //end TApp::ResolveLabel
+
+//------------------------------------------------------------------------------
+bool TApp::Run() {
+    std::cout << "INFO: Kernel de distância: " << manhattanKernelName() << std::endl;
+
     // Carrega os objetos do arquivo de dataset e constrói a árvore
     std::cout << "\nConstruindo a SlimTree a partir de: " << dataset_file_var << std::endl;
-    LoadTree(dataset_file_var); // Usa a nova define
+    if (!LoadTree(dataset_file_var)) {
+        // Uma árvore parcial (arquivo com linha inconsistente) daria resultados incompletos
+        std::cerr << "ERRO: A SlimTree não foi construída a partir de '" << dataset_file_var
+                  << "'. Consultas canceladas." << std::endl;
+        return false;
+    }
 
     // Carrega os objetos do arquivo de consulta para o vetor queryObjects
     std::cout << "\nCarregando objetos de consulta de: " << query_file_var << std::endl;
@@ -64,6 +124,7 @@ void TApp::Run() {
     }
     // Mensagem final
     std::cout << "\n\nProcesso concluído!" << std::endl;
+    return true;
 } //end TApp::Run
 
 //------------------------------------------------------------------------------
@@ -80,6 +141,11 @@ void TApp::Done() {
         this->PageManager = nullptr; // Boa prática
          std::cout << "INFO: Instância PageManager liberada." << std::endl;
     }
+    // Fecha o arquivo de labels
+    if (this->LabelStore != nullptr) {
+        delete this->LabelStore;
+        this->LabelStore = nullptr;
+    }
 
     // Libera a memória dos objetos de consulta alocados no heap
     if (!queryObjects.empty()) {
@@ -95,57 +161,75 @@ void TApp::Done() {
 } //end TApp::Done
 
 //------------------------------------------------------------------------------
-// Assume que SlimTree->Add CLONA o objeto, como implícito no código original.
-void TApp::LoadTree(const std::string& fileName) {
+bool TApp::LoadTree(const std::string& fileName) {
     if (!SlimTree) {
         std::cerr << "ERRO: SlimTree não inicializada antes de LoadTree!" << std::endl;
-        return;
+        return false;
     }
 
-    VectorFileReader reader;
-    std::cout << "INFO: Lendo arquivo de dataset '" << fileName << "'..." << std::endl;
-
-    if (!reader.loadFromFile(fileName)) {
-        std::cerr << "ERRO: Falha ao carregar dados de '" << fileName << "' usando VectorFileReader." << std::endl;
-        return;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    bool built = InsertObjects(fileName);
+    if (!built) {
+        return false;
     }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    BuildTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
 
-    // Cria os TComplexObjects a partir dos dados lidos
-    std::vector<TComplexObject> objects = reader.createVectorTComplexObject();
-
-    if (objects.empty()) {
-         std::cout << "AVISO: Nenhum objeto válido encontrado/criado a partir de '" << fileName << "'. A árvore permanecerá vazia." << std::endl;
-         return;
-    }
+    // Nós da árvore construída, relatados com as estatísticas de PerformRangeQuery
+    mySlimTree* slimTree = static_cast<mySlimTree*>(SlimTree);
+    IndexNodeCount = slimTree->GetIndexNodeCount();
+    LeafNodeCount = slimTree->GetLeafNodeCount();
 
-    std::cout << "INFO: Adicionando " << objects.size() << " objetos à SlimTree ";
-    long w = 0;
-    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::cout << "INFO: Total de objetos na árvore: " << SlimTree->GetNumberOfObjects() << std::endl;
+    std::cout << "INFO: Tempo de construção: " << BuildTimeMs << " ms" << std::endl;
+    std::cout << "INFO: Nós índice: " << IndexNodeCount << " | Nós folha: " << LeafNodeCount
+              << " | Altura: " << slimTree->GetHeight() << std::endl;
+    return true;
+} //end TApp::LoadTree
 
-    for (const auto& obj : objects) {
+//------------------------------------------------------------------------------
+// Assume que SlimTree->Add CLONA o objeto, como implícito no código original.
+bool TApp::InsertObjects(const std::string& fileName) {
+    // Leitura, transformada e inserção em estágios paralelos; esta thread só insere
+    TIngestPipeline pipeline(ingest_threads_var > 0 ? static_cast<size_t>(ingest_threads_var) : 0);
+    pipeline.SetTargetResolution(dataset_resolution_var);
+    std::cout << "INFO: Lendo arquivo de dataset '" << fileName << "' (" << pipeline.GetTransformThreads()
+              << " thread(s) de transformada)..." << std::endl;
+    TIngestProgress progress(std::cout, "INFO: Adicionando objetos à SlimTree: ");
+
+    // O objeto entregue é reutilizado pelo pipeline, sem manter o dataset inteiro na memória
+    bool loaded = pipeline.Run(fileName, [&](TComplexObject& obj) {
+        // A entrada da árvore leva apenas o ID; o label vai para o arquivo de labels
+        if (LabelStore) {
+            obj.SetObjectID(LabelStore->Append(obj.GetLabel()));
+        }
 
-        bool added = SlimTree->Add(const_cast<TComplexObject*>(&obj)); // Tentativa direta
+        bool added = SlimTree->Add(&obj); // A árvore guarda a forma serializada
 
         if (!added) {
              std::cerr << "\nAVISO: Falha ao adicionar objeto com label '" << obj.GetLabel() << "' à árvore." << std::endl;
              // Decidir se deve continuar ou abortar
         }
 
-        w++;
-        if (w % 100 == 0) { // Imprime um ponto a cada 100 objetos adicionados
-            std::cout << '.';
-            std::cout.flush(); // Garante que o ponto seja exibido imediatamente
-        }
-    }
-
-    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+        progress.Add(); // Objetos inseridos e taxa, atualizados no lugar
+        return true;
+    });
+    progress.Finish();
 
-    std::cout << " Concluído." << std::endl;
-    std::cout << "INFO: Total de objetos na árvore: " << SlimTree->GetNumberOfObjects() << std::endl;
-    std::cout << "INFO: Tempo para adicionar objetos: " << duration_ms << " ms" << std::endl;
+    if (!loaded) {
+        std::cerr << "ERRO: Falha ao carregar dados de '" << fileName << "' usando VectorFileReader ("
+                  << progress.GetCount() << " objeto(s) já inseridos)." << std::endl;
+        return false;
+    }
+    if (progress.GetCount() == 0) {
+         std::cout << "AVISO: Nenhum objeto válido encontrado/criado a partir de '" << fileName << "'. A árvore permanecerá vazia." << std::endl;
+         return false;
+    }
 
-} //end TApp::LoadTree
+    std::cout << "INFO: Inserção esperou " << static_cast<long long>(pipeline.GetInsertWaitSeconds() * 1000.0)
+              << " ms pela leitura." << std::endl;
+    return true;
+} //end TApp::InsertObjects
 
 //------------------------------------------------------------------------------
 void TApp::LoadQueryObjects(const std::string& fileName) {
@@ -159,34 +243,24 @@ void TApp::LoadQueryObjects(const std::string& fileName) {
 
 
    VectorFileReader reader;
+   reader.setTargetResolution(query_resolution_var);
     std::cout << "INFO: Lendo arquivo de consulta '" << fileName << "'..." << std::endl;
 
-   if (!reader.loadFromFile(fileName)) {
+   // Cada consulta é criada diretamente no HEAP a partir do registro lido
+   bool loaded = reader.forEachObject(fileName, [&](TComplexObject& entry) {
+       queryObjects.push_back(new TComplexObject(entry));
+       return true;
+   });
+   if (!loaded) {
        std::cerr << "ERRO: Falha ao carregar dados de consulta de '" << fileName << "'." << std::endl;
        return;
    }
 
-   // Obtém os VectorEntry's lidos
-   const std::vector<VectorEntry>& entries = reader.getVectors();
-
-    if (entries.empty()) {
+    if (queryObjects.empty()) {
         std::cout << "AVISO: Nenhum objeto de consulta válido encontrado/criado a partir de '" << fileName << "'." << std::endl;
         return;
     }
 
-   // Reserva espaço no vetor de ponteiros
-   queryObjects.reserve(entries.size());
-
-   std::cout << "INFO: Criando objetos de consulta na memória..." << std::endl;
-   int count = 0;
-   for (const auto& entry : entries) {
-       // Cria um NOVO objeto TComplexObject no HEAP para cada consulta
-       TComplexObject* queryObj = new TComplexObject(std::string(entry.label), entry.resolution, entry.data);
-       // Adiciona o PONTEIRO ao vetor
-       queryObjects.push_back(queryObj);
-       count++;
-   }
-
    std::cout << "INFO: " << queryObjects.size() << " objetos de consulta carregados." << std::endl;
 
 } //end TApp::LoadQueryObjects
@@ -223,27 +297,41 @@ void TApp::PerformRangeQuery() {
 
     std::cout << "\n  Raio da consulta: " << radius;
     std::cout << "\n  Número de consultas: " << size;
+    std::cout << "\n  Cache de páginas: " << (cold_cache_var ? "cold" : "warm");
 
     // Reseta estatísticas antes do loop de consultas
     PageManager->ResetStatistics();
     SlimTree->GetMetricEvaluator()->ResetStatistics();
 
+    std::chrono::steady_clock::duration evictionTime(0);
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
     for (unsigned int i = 0; i < size; ++i) {
+        if (cold_cache_var) {
+            // Cada consulta começa com as páginas da árvore fora da memória
+            evictionTime += evictTreeFromPageCache();
+        }
         // queryObjects[i] agora é TComplexObject*
         result = SlimTree->RangeQuery(queryObjects[i], radius);
         if (result) {
             totalResultSize += result->GetNumOfEntries(); // Acumula o número de resultados encontrados
+            if (print_labels_var) {
+                // Labels resolvidos só para os objetos retornados
+                std::cout << "\n  Consulta " << i << ":";
+                for (unsigned int j = 0; j < result->GetNumOfEntries(); ++j) {
+                    std::cout << " " << ResolveLabel(*(*result)[j].GetObject());
+                }
+            }
             delete result; // Libera a memória do objeto de resultado
         } else {
              std::cerr << "\nAVISO: RangeQuery retornou nullptr para o objeto de consulta " << i << std::endl;
         }
     }
 
+    // O descarte do cache (--cache cold) fica fora do tempo das consultas
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    long long duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
-    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+    long long duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - begin - evictionTime).count();
+    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin - evictionTime).count();
 
     std::cout << "\n  Tempo total: " << duration_ms << " ms (" << duration_us << " µs)";
     if (size > 0) {
@@ -260,6 +348,10 @@ void TApp::PerformRangeQuery() {
         std::cout << "\t\"" << "avg_dist_calc" << "\" : " << static_cast<double>(SlimTree->GetMetricEvaluator()->GetDistanceCount()) / size << "," << std::endl;
         std::cout << "\t\"" << "avg_obj_result" << "\" : " << static_cast<double>(totalResultSize) / size << "," << std::endl;
         std::cout << "\t\"" << "radius" << "\" : " << radius << "," << std::endl;
+        std::cout << "\t\"" << "cache" << "\" : \"" << (cold_cache_var ? "cold" : "warm") << "\"," << std::endl;
+        std::cout << "\t\"" << "build_time_ms" << "\" : " << BuildTimeMs << "," << std::endl;
+        std::cout << "\t\"" << "index_nodes" << "\" : " << IndexNodeCount << "," << std::endl;
+        std::cout << "\t\"" << "leaf_nodes" << "\" : " << LeafNodeCount << "," << std::endl;
         std::cout << "\t\"" << "num_consults" << "\" : " << size << std::endl;
         std::cout << "}";
         std::cout << "\n================JSON================\n";
@@ -283,9 +375,13 @@ void TApp::PerformNearestQuery() {
     PageManager->ResetStatistics();
     SlimTree->GetMetricEvaluator()->ResetStatistics();
 
+    std::chrono::steady_clock::duration evictionTime(0);
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
     for (unsigned int i = 0; i < size; ++i) {
+        if (cold_cache_var) {
+            evictionTime += evictTreeFromPageCache();
+        }
         // queryObjects[i] agora é TComplexObject*
         result = SlimTree->NearestQuery(queryObjects[i], k);
          if (result) {
@@ -296,9 +392,10 @@ void TApp::PerformNearestQuery() {
         }
     }
 
+    // O descarte do cache (--cache cold) fica fora do tempo das consultas
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    long long duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
-    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+    long long duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - begin - evictionTime).count();
+    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin - evictionTime).count();
 
 
     std::cout << "\n  Tempo total: " << duration_ms << " ms (" << duration_us << " µs)";
@@ -25,6 +25,7 @@
 #include "complex_object.h"         // Substitui city.h
 #include "distance_calculator.h"    // Para o avaliador de distância
 #include "VectorFileReader.hpp"     // Para carregar dados do arquivo
+#include "label_store.h"            // Labels fora das entradas da árvore
 
 // Definições de arquivos (nomes alterados para refletir o tipo de dado)
 // Os caminhos dos arquivos foram mantidos como solicitado.
@@ -56,7 +57,8 @@ public:
     /**
     * Creates a new instance of this class.
     */
-    TApp() : PageManager(nullptr), SlimTree(nullptr) {
+    TApp() : PageManager(nullptr), SlimTree(nullptr), LabelStore(nullptr), BuildTimeMs(0), IndexNodeCount(0),
+        LeafNodeCount(0) {
         // queryObjects é inicializado vazio por padrão
     } //end TApp
 
@@ -66,14 +68,17 @@ public:
     void Init() {
         // To create it in disk
         CreateDiskPageManager();
+        // Label file indexed by object ID
+        CreateLabelStore();
         // Creates the tree
         CreateTree();
     } //end Init
 
     /**
     * Runs the application logic: loads data, builds tree, performs queries.
+    * @return false if the tree could not be built; no query is run then.
     */
-    void Run();
+    bool Run();
 
     /**
     * Deinitializes the application, releasing resources.
@@ -92,6 +97,20 @@ private:
     */
     MetricTree * SlimTree; // Usando o typedef genérico MetricTree
 
+    /**
+    * Side file with the labels of the indexed objects. Tree entries only
+    * carry the object ID; NULL when labels are kept inline.
+    */
+    TLabelStore * LabelStore;
+
+    /**
+    * Time LoadTree took to build the tree and the nodes it ended up with,
+    * reported with the query statistics.
+    */
+    long long BuildTimeMs;
+    long IndexNodeCount;
+    long LeafNodeCount;
+
     /**
     * Vector for holding the query objects (pointers to TComplexObject).
     */
@@ -107,12 +126,35 @@ private:
     */
     void CreateTree();
 
+    /**
+    * Creates the label store, unless labels are kept inline in the tree.
+    */
+    void CreateLabelStore();
+
+    /**
+    * Returns the label of a result object, reading it from the label store
+    * when the tree entry only carries the object ID.
+    */
+    std::string ResolveLabel(const TComplexObject& obj);
+
     /**
     * Loads data from the specified file using VectorFileReader
     * and populates the SlimTree. Assumes the tree clones objects.
+    * The tree is built by InsertObjects, and its build time and node
+    * counts are reported.
     * @param fileName Path to the dataset file.
+    * @return false if the file could not be read to the end (an
+    * inconsistent line, say) or gave no object; the tree may then hold
+    * only part of the dataset.
+    */
+    bool LoadTree(const std::string& fileName); // Mudado para const std::string&
+
+    /**
+    * Inserts the objects of the file one by one with Add, streaming them
+    * through a TIngestPipeline.
+    * @return false if nothing was inserted.
     */
-    void LoadTree(const std::string& fileName); // Mudado para const std::string&
+    bool InsertObjects(const std::string& fileName);
 
     /**
     * Loads query objects from the specified file using VectorFileReader
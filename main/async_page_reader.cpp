@@ -0,0 +1,532 @@
+#include "async_page_reader.h"
+
+#include <algorithm>          // for std::min
+#include <cerrno>             // for errno
+#include <condition_variable> // for std::condition_variable
+#include <cstdlib>            // for aligned_alloc, free
+#include <cstring>            // for memset
+#include <deque>              // for std::deque
+#include <mutex>              // for std::mutex
+#include <thread>             // for std::thread
+
+#include <fcntl.h>     // for open
+#include <sys/mman.h>  // for mmap
+#include <sys/stat.h>  // for fstat
+#include <sys/syscall.h>
+#include <unistd.h>    // for pread, close
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define ASYNC_PAGE_READER_IO_URING 1
+#endif
+
+//---------------------------------------------------------------------------
+// Class TAlignedBufferPool
+//---------------------------------------------------------------------------
+
+TAlignedBufferPool& TAlignedBufferPool::Instance() {
+    static TAlignedBufferPool pool;
+    return pool;
+}
+
+TAlignedBufferPool::~TAlignedBufferPool() {
+    for (FreeBuffer& entry : FreeBuffers) {
+        free(entry.Buffer);
+    }
+}
+
+uint8_t* TAlignedBufferPool::Acquire(size_t size) {
+    size = AlignedSize(size);
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        for (size_t i = 0; i < FreeBuffers.size(); ++i) {
+            if (FreeBuffers[i].Size == size) {
+                uint8_t* buffer = FreeBuffers[i].Buffer;
+                FreeBuffers[i] = FreeBuffers.back();
+                FreeBuffers.pop_back();
+                return buffer;
+            }
+        }
+        AllocatedCount++;
+    }
+    uint8_t* buffer = static_cast<uint8_t*>(aligned_alloc(ASYNC_PAGE_ALIGNMENT, size));
+    if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(Mutex);
+        AllocatedCount--;
+    }
+    return buffer;
+}
+
+void TAlignedBufferPool::Release(uint8_t* buffer, size_t size) {
+    if (buffer == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(Mutex);
+    FreeBuffers.push_back(FreeBuffer{AlignedSize(size), buffer});
+}
+
+size_t TAlignedBufferPool::GetAllocatedCount() const {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return AllocatedCount;
+}
+
+//---------------------------------------------------------------------------
+// Class TPageReadBackend
+//---------------------------------------------------------------------------
+/**
+* Engine interface: reads are submitted into numbered slots and the caller
+* waits for a given slot.
+*/
+class TPageReadBackend {
+public:
+    virtual ~TPageReadBackend() {}
+    virtual const char* GetName() const = 0;
+
+    /**
+    * Starts reading 'length' bytes at 'offset' into 'buffer' for 'slot'.
+    */
+    virtual bool Submit(size_t slot, uint8_t* buffer, size_t length, uint64_t offset) = 0;
+
+    /**
+    * Waits for the read of 'slot'.
+    * @return Bytes read, or a negative errno value.
+    */
+    virtual long Wait(size_t slot) = 0;
+};
+
+//---------------------------------------------------------------------------
+// Thread pool engine
+//---------------------------------------------------------------------------
+
+class TThreadPoolBackend : public TPageReadBackend {
+public:
+    TThreadPoolBackend(int fd, size_t slots, size_t threads) :
+        FileDescriptor(fd), Results(slots, 0), Done(slots, false), Stopping(false) {
+        for (size_t i = 0; i < threads; ++i) {
+            Workers.emplace_back([this]() { Run(); });
+        }
+    }
+
+    ~TThreadPoolBackend() {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Stopping = true;
+        }
+        TaskReady.notify_all();
+        for (std::thread& worker : Workers) {
+            worker.join();
+        }
+    }
+
+    const char* GetName() const { return "pread-threads"; }
+
+    bool Submit(size_t slot, uint8_t* buffer, size_t length, uint64_t offset) {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Done[slot] = false;
+            Tasks.push_back(Task{slot, buffer, length, offset});
+        }
+        TaskReady.notify_one();
+        return true;
+    }
+
+    long Wait(size_t slot) {
+        std::unique_lock<std::mutex> lock(Mutex);
+        TaskDone.wait(lock, [this, slot]() { return Done[slot]; });
+        Done[slot] = false;
+        return Results[slot];
+    }
+
+private:
+    struct Task {
+        size_t Slot;
+        uint8_t* Buffer;
+        size_t Length;
+        uint64_t Offset;
+    };
+
+    int FileDescriptor;
+    std::vector<long> Results;
+    std::vector<bool> Done;
+    std::deque<Task> Tasks;
+    std::vector<std::thread> Workers;
+    std::mutex Mutex;
+    std::condition_variable TaskReady;
+    std::condition_variable TaskDone;
+    bool Stopping;
+
+    void Run() {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                TaskReady.wait(lock, [this]() { return Stopping || !Tasks.empty(); });
+                if (Tasks.empty()) {
+                    return; // Stopping
+                }
+                task = Tasks.front();
+                Tasks.pop_front();
+            }
+            // pread may return less than asked before the end of the file
+            size_t total = 0;
+            long result = 0;
+            while (total < task.Length) {
+                ssize_t count = pread(FileDescriptor, task.Buffer + total, task.Length - total,
+                                      static_cast<off_t>(task.Offset + total));
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count <= 0) {
+                    result = (count < 0) ? -errno : 0;
+                    break;
+                }
+                total += static_cast<size_t>(count);
+            }
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Results[task.Slot] = (result < 0) ? result : static_cast<long>(total);
+                Done[task.Slot] = true;
+            }
+            TaskDone.notify_all();
+        }
+    }
+};
+
+//---------------------------------------------------------------------------
+// io_uring engine
+//---------------------------------------------------------------------------
+
+#ifdef ASYNC_PAGE_READER_IO_URING
+
+class TIoUringBackend : public TPageReadBackend {
+public:
+    TIoUringBackend(int fd, size_t slots) :
+        FileDescriptor(fd), RingFd(-1), Results(slots, 0), Done(slots, false), Reads(slots),
+        SqRing(MAP_FAILED), CqRing(MAP_FAILED), Sqes(MAP_FAILED), SqRingSize(0), CqRingSize(0), SqesSize(0) {}
+
+    ~TIoUringBackend() {
+        if (Sqes != MAP_FAILED) {
+            munmap(Sqes, SqesSize);
+        }
+        if (CqRing != MAP_FAILED && CqRing != SqRing) {
+            munmap(CqRing, CqRingSize);
+        }
+        if (SqRing != MAP_FAILED) {
+            munmap(SqRing, SqRingSize);
+        }
+        if (RingFd >= 0) {
+            close(RingFd);
+        }
+    }
+
+    /**
+    * Creates the ring and maps its queues.
+    * @return false if io_uring is not available.
+    */
+    bool Setup() {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        RingFd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(Results.size()), &params));
+        if (RingFd < 0) {
+            return false;
+        }
+        SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            SqRingSize = CqRingSize = std::max(SqRingSize, CqRingSize);
+        }
+        SqRing = mmap(nullptr, SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      RingFd, IORING_OFF_SQ_RING);
+        if (SqRing == MAP_FAILED) {
+            return false;
+        }
+        CqRing = singleMap ? SqRing :
+                 mmap(nullptr, CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      RingFd, IORING_OFF_CQ_RING);
+        if (CqRing == MAP_FAILED) {
+            return false;
+        }
+        SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        Sqes = mmap(nullptr, SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    RingFd, IORING_OFF_SQES);
+        if (Sqes == MAP_FAILED) {
+            return false;
+        }
+
+        uint8_t* sq = static_cast<uint8_t*>(SqRing);
+        uint8_t* cq = static_cast<uint8_t*>(CqRing);
+        SqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        SqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        SqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        SqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        CqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        CqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        CqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    /**
+    * Checks that the kernel runs IORING_OP_READ (Linux 5.6+) by reading
+    * the first 'length' bytes of the file into 'buffer'. Older kernels
+    * accept the ring but fail the completion with -EINVAL or -EOPNOTSUPP.
+    */
+    bool Probe(uint8_t* buffer, size_t length) {
+        if (!Submit(0, buffer, length, 0)) {
+            return false;
+        }
+        const long result = Wait(0);
+        return result != -EINVAL && result != -EOPNOTSUPP;
+    }
+
+    const char* GetName() const { return "io_uring"; }
+
+    bool Submit(size_t slot, uint8_t* buffer, size_t length, uint64_t offset) {
+        Reads[slot] = Read{buffer, length, offset, 0};
+        Done[slot] = false;
+        return Enqueue(slot);
+    }
+
+    long Wait(size_t slot) {
+        while (!Done[slot]) {
+            unsigned head = *CqHead;
+            const unsigned tail = __atomic_load_n(CqTail, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                if (syscall(__NR_io_uring_enter, RingFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                    errno != EINTR) {
+                    return -errno;
+                }
+                continue;
+            }
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = Cqes[head & CqMask];
+                Complete(static_cast<size_t>(cqe.user_data), cqe.res);
+            }
+            __atomic_store_n(CqHead, head, __ATOMIC_RELEASE);
+        }
+        Done[slot] = false;
+        return Results[slot];
+    }
+
+private:
+    /**
+    * Read of one slot: the whole request and the bytes already read.
+    */
+    struct Read {
+        uint8_t* Buffer;
+        size_t Length;
+        uint64_t Offset;
+        size_t Filled;
+    };
+
+    /**
+    * Queues the unread part of the read of 'slot'.
+    * @return false if it could not be submitted; the ring is then left as
+    * it was.
+    */
+    bool Enqueue(size_t slot) {
+        const Read& read = Reads[slot];
+        // At most one read per slot is in flight, so the queue never overflows
+        const unsigned tail = *SqTail;
+        const unsigned index = tail & SqMask;
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(Sqes) + index;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = FileDescriptor;
+        sqe->addr = reinterpret_cast<uint64_t>(read.Buffer + read.Filled);
+        sqe->len = static_cast<uint32_t>(read.Length - read.Filled);
+        sqe->off = read.Offset + read.Filled;
+        sqe->user_data = slot;
+        SqArray[index] = index;
+        __atomic_store_n(SqTail, tail + 1, __ATOMIC_RELEASE);
+        long submitted;
+        do {
+            submitted = syscall(__NR_io_uring_enter, RingFd, 1, 0, 0, nullptr, 0);
+        } while (submitted < 0 && errno == EINTR);
+        if (submitted == 1) {
+            return true;
+        }
+        // Without SQPOLL the kernel only takes entries inside io_uring_enter,
+        // so an entry it did not take can be withdrawn
+        if (__atomic_load_n(SqHead, __ATOMIC_ACQUIRE) == tail) {
+            __atomic_store_n(SqTail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+        return true; // Taken: its completion reports the outcome
+    }
+
+    /**
+    * Handles the completion 'res' of a read of 'slot'. Like pread, a read
+    * may return less than asked before the end of the file; the rest is
+    * queued again.
+    */
+    void Complete(size_t slot, int res) {
+        Read& read = Reads[slot];
+        if (res == -EINTR || res == -EAGAIN || (res > 0 && read.Filled + res < read.Length)) {
+            read.Filled += (res > 0) ? static_cast<size_t>(res) : 0;
+            if (Enqueue(slot)) {
+                return;
+            }
+            res = -EIO;
+        } else if (res > 0) {
+            read.Filled += static_cast<size_t>(res);
+        }
+        Results[slot] = (res < 0) ? res : static_cast<long>(read.Filled);
+        Done[slot] = true;
+    }
+
+    int FileDescriptor;
+    int RingFd;
+    std::vector<long> Results;
+    std::vector<bool> Done;
+    std::vector<Read> Reads;
+    void* SqRing;
+    void* CqRing;
+    void* Sqes;
+    size_t SqRingSize;
+    size_t CqRingSize;
+    size_t SqesSize;
+    unsigned* SqHead;
+    unsigned* SqTail;
+    unsigned SqMask;
+    unsigned* SqArray;
+    unsigned* CqHead;
+    unsigned* CqTail;
+    unsigned CqMask;
+    io_uring_cqe* Cqes;
+};
+
+#endif // ASYNC_PAGE_READER_IO_URING
+
+//---------------------------------------------------------------------------
+// Class TAsyncPageReader
+//---------------------------------------------------------------------------
+
+TAsyncPageReader::TAsyncPageReader(size_t pageSize, size_t queueDepth, Engine engine, bool directIO) :
+    PageSize(pageSize), QueueDepth(std::max<size_t>(1, queueDepth)), RequestedEngine(engine),
+    DirectIO(directIO), FileDescriptor(-1), PageCount(0), BufferSize(TAlignedBufferPool::AlignedSize(pageSize)) {
+}
+
+TAsyncPageReader::~TAsyncPageReader() {
+    Close();
+}
+
+bool TAsyncPageReader::Open(const std::string& fileName) {
+    Close();
+    if (PageSize == 0 || (DirectIO && PageSize % ASYNC_PAGE_ALIGNMENT != 0)) {
+        return false;
+    }
+    FileDescriptor = open(fileName.c_str(), DirectIO ? (O_RDONLY | O_DIRECT) : O_RDONLY);
+    if (FileDescriptor < 0) {
+        return false;
+    }
+    struct stat fileInfo;
+    if (fstat(FileDescriptor, &fileInfo) != 0) {
+        Close();
+        return false;
+    }
+    PageCount = (static_cast<size_t>(fileInfo.st_size) + PageSize - 1) / PageSize;
+
+    for (size_t i = 0; i < QueueDepth; ++i) {
+        uint8_t* buffer = TAlignedBufferPool::Instance().Acquire(BufferSize);
+        if (buffer == nullptr) {
+            Close();
+            return false;
+        }
+        Buffers.push_back(buffer);
+    }
+
+#ifdef ASYNC_PAGE_READER_IO_URING
+    if (RequestedEngine != ENGINE_THREADS) {
+        std::unique_ptr<TIoUringBackend> ring(new TIoUringBackend(FileDescriptor, QueueDepth));
+        if (ring->Setup() && ring->Probe(Buffers[0], PageSize)) {
+            Backend = std::move(ring);
+        }
+    }
+#endif
+    if (!Backend && RequestedEngine != ENGINE_IO_URING) {
+        Backend.reset(new TThreadPoolBackend(FileDescriptor, QueueDepth, std::min<size_t>(QueueDepth, 16)));
+    }
+    if (!Backend) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void TAsyncPageReader::Close() {
+    Backend.reset();
+    for (uint8_t* buffer : Buffers) {
+        TAlignedBufferPool::Instance().Release(buffer, BufferSize);
+    }
+    Buffers.clear();
+    if (FileDescriptor >= 0) {
+        close(FileDescriptor);
+        FileDescriptor = -1;
+    }
+    PageCount = 0;
+}
+
+const char* TAsyncPageReader::GetEngineName() const {
+    return Backend ? Backend->GetName() : "none";
+}
+
+bool TAsyncPageReader::ReadPages(size_t firstPage, size_t pageLimit,
+                                 const std::function<bool(size_t)>& accept,
+                                 const std::function<void(size_t, const uint8_t*, size_t)>& consume) {
+    if (!Backend) {
+        return false;
+    }
+    const size_t lastPage = (firstPage < PageCount) ? firstPage + std::min(pageLimit, PageCount - firstPage) : firstPage;
+
+    // Pages in flight, oldest first; slot i of the ring holds inFlight[i]
+    std::vector<size_t> inFlight(QueueDepth);
+    size_t oldest = 0, pending = 0;
+    size_t nextPage = firstPage;
+    bool ok = true;
+
+    while (true) {
+        // Keep the queue full
+        while (ok && pending < QueueDepth && nextPage < lastPage) {
+            const size_t page = nextPage++;
+            if (accept && !accept(page)) {
+                continue;
+            }
+            const size_t slot = (oldest + pending) % QueueDepth;
+            inFlight[slot] = page;
+            if (!Backend->Submit(slot, Buffers[slot], PageSize, static_cast<uint64_t>(page) * PageSize)) {
+                ok = false;
+                break;
+            }
+            pending++;
+        }
+        if (pending == 0) {
+            break;
+        }
+
+        // The oldest page is decoded while the others are being read
+        const long bytes = Backend->Wait(oldest);
+        if (bytes < 0) {
+            ok = false;
+        } else if (ok) {
+            consume(inFlight[oldest], Buffers[oldest], static_cast<size_t>(bytes));
+        }
+        oldest = (oldest + 1) % QueueDepth;
+        pending--;
+    }
+    return ok;
+}
+
+bool TAsyncPageReader::ParseEngine(const std::string& name, Engine& engine) {
+    if (name == "auto") {
+        engine = ENGINE_AUTO;
+    } else if (name == "io_uring") {
+        engine = ENGINE_IO_URING;
+    } else if (name == "threads") {
+        engine = ENGINE_THREADS;
+    } else {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,177 @@
+#ifndef ASYNC_PAGE_READER_H
+#define ASYNC_PAGE_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class TPageReadBackend;
+
+/**
+* Alignment of the page buffers (enough for O_DIRECT on common devices).
+*/
+const size_t ASYNC_PAGE_ALIGNMENT = 4096;
+
+//---------------------------------------------------------------------------
+// Class TAlignedBufferPool
+//---------------------------------------------------------------------------
+/**
+* Process-wide pool of ASYNC_PAGE_ALIGNMENT-aligned buffers. Readers take
+* their page buffers from it and give them back on Close(), so repeated
+* scans (one reader per pass) do not allocate. Thread-safe.
+*
+* @version 1.0
+*/
+class TAlignedBufferPool {
+public:
+    /**
+    * The shared pool.
+    */
+    static TAlignedBufferPool& Instance();
+
+    ~TAlignedBufferPool();
+
+    /**
+    * Returns a buffer of at least 'size' bytes (rounded up to the
+    * alignment), or NULL if it cannot be allocated.
+    */
+    uint8_t* Acquire(size_t size);
+
+    /**
+    * Gives back a buffer obtained from Acquire() with the same 'size'.
+    */
+    void Release(uint8_t* buffer, size_t size);
+
+    /**
+    * Number of buffers allocated so far (in use or free).
+    */
+    size_t GetAllocatedCount() const;
+
+    /**
+    * Rounds 'size' up to a multiple of ASYNC_PAGE_ALIGNMENT.
+    */
+    static size_t AlignedSize(size_t size) {
+        return (size + ASYNC_PAGE_ALIGNMENT - 1) / ASYNC_PAGE_ALIGNMENT * ASYNC_PAGE_ALIGNMENT;
+    }
+
+private:
+    TAlignedBufferPool() : AllocatedCount(0) {}
+
+    struct FreeBuffer {
+        size_t Size;
+        uint8_t* Buffer;
+    };
+    std::vector<FreeBuffer> FreeBuffers;
+    size_t AllocatedCount;
+    mutable std::mutex Mutex;
+};
+
+//---------------------------------------------------------------------------
+// Class TAsyncPageReader
+//---------------------------------------------------------------------------
+/**
+* Reads the pages of a file with up to 'queueDepth' reads in flight and
+* hands them to the caller in page order, so decoding a page overlaps with
+* the reads of the following ones.
+*
+* Two engines are available: io_uring (used directly through its system
+* calls, no liburing needed) and a pool of threads issuing pread(). The
+* default picks io_uring and falls back to the thread pool when the kernel
+* does not provide it (or it is blocked, as in some containers) or is too
+* old for its read operation (before Linux 5.6); Open() checks that with a
+* read of the first page.
+*
+* Each read goes into one of 'queueDepth' page buffers aligned to
+* ASYNC_PAGE_ALIGNMENT bytes, taken from TAlignedBufferPool; a buffer is
+* reused as soon as the caller is done with its page.
+*
+* With 'directIO' the file is opened with O_DIRECT, so reads bypass the page
+* cache and every page access reaches the device. The page size must then
+* be a multiple of ASYNC_PAGE_ALIGNMENT.
+*
+* @version 1.0
+*/
+class TAsyncPageReader {
+public:
+    enum Engine {
+        ENGINE_AUTO,     // io_uring when available, thread pool otherwise
+        ENGINE_IO_URING, // io_uring only (Open fails without it)
+        ENGINE_THREADS   // pread() thread pool
+    };
+
+    /**
+    * @param pageSize Size of each page in bytes.
+    * @param queueDepth Maximum number of page reads in flight (at least 1).
+    * @param engine Engine to use.
+    * @param directIO Opens the file with O_DIRECT.
+    */
+    TAsyncPageReader(size_t pageSize, size_t queueDepth, Engine engine = ENGINE_AUTO, bool directIO = false);
+    ~TAsyncPageReader();
+
+    /**
+    * Opens the file and starts the selected engine.
+    * @return false if the file cannot be opened (also when O_DIRECT is not
+    * supported by the file system or the page size) or the engine started.
+    */
+    bool Open(const std::string& fileName);
+
+    /**
+    * Waits for the reads in flight and closes the file.
+    */
+    void Close();
+
+    bool IsOpen() const { return FileDescriptor >= 0; }
+
+    /**
+    * Name of the engine in use ("io_uring" or "pread-threads"), or "none"
+    * before Open().
+    */
+    const char* GetEngineName() const;
+
+    /**
+    * Number of pages in the file (the last one may be partial).
+    */
+    size_t GetPageCount() const { return PageCount; }
+
+    /**
+    * Reads the pages in [firstPage, firstPage + pageLimit) for which
+    * 'accept' returns true (all of them if it is empty) and calls
+    * 'consume' with each page number, its bytes and the number of bytes
+    * read, in page order. 'accept' is called in page order too, but ahead
+    * of the matching 'consume' calls, so it must not depend on them.
+    * @return false if a read fails.
+    */
+    bool ReadPages(size_t firstPage, size_t pageLimit,
+                   const std::function<bool(size_t)>& accept,
+                   const std::function<void(size_t, const uint8_t*, size_t)>& consume);
+
+    /**
+    * Parses an engine name ("auto", "io_uring" or "threads").
+    * @return false for unknown names.
+    */
+    static bool ParseEngine(const std::string& name, Engine& engine);
+
+private:
+    size_t PageSize;
+    size_t QueueDepth;
+    Engine RequestedEngine;
+    bool DirectIO;
+    int FileDescriptor;
+    size_t PageCount;
+    std::unique_ptr<TPageReadBackend> Backend;
+
+    /**
+    * One buffer per read in flight, BufferSize bytes each.
+    */
+    std::vector<uint8_t*> Buffers;
+    size_t BufferSize;
+
+    TAsyncPageReader(const TAsyncPageReader&) = delete;
+    TAsyncPageReader& operator=(const TAsyncPageReader&) = delete;
+};
+
+#endif // ASYNC_PAGE_READER_H
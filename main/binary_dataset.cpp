@@ -0,0 +1,165 @@
+#include "binary_dataset.h"
+#include "VectorFileReader.hpp"
+
+#include <cstring> // for memcpy, strlen
+#include <fstream>
+
+// Header field offsets
+static const size_t OFFSET_MAGIC = 0;
+static const size_t OFFSET_RESOLUTION = 4;
+static const size_t OFFSET_COUNT = 8;
+static const size_t OFFSET_DIMENSION = 16;
+static const size_t OFFSET_MATRIX = 24;
+static const size_t OFFSET_RESOLUTIONS = 32;
+static const size_t OFFSET_LABEL_OFFSETS = 40;
+static const size_t OFFSET_LABEL_BLOB = 48;
+static const size_t OFFSET_FILE_SIZE = 56;
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + BINARY_DATASET_ALIGNMENT - 1) / BINARY_DATASET_ALIGNMENT * BINARY_DATASET_ALIGNMENT;
+}
+
+static uint64_t readField(const uint8_t* header, size_t offset) {
+    uint64_t value;
+    memcpy(&value, header + offset, sizeof(value));
+    return value;
+}
+
+bool isBinaryDataset(const void* data, size_t size) {
+    uint32_t magic;
+    if (data == nullptr || size < sizeof(magic)) {
+        return false;
+    }
+    memcpy(&magic, data, sizeof(magic));
+    return magic == BINARY_DATASET_MAGIC;
+}
+
+bool writeBinaryDataset(const std::string& fileName, const std::vector<VectorEntry>& entries) {
+    const uint64_t count = entries.size();
+    const uint64_t dimension = entries.empty() ? 0 : entries[0].data.size();
+    int32_t resolution = entries.empty() ? 0 : entries[0].resolution;
+    for (const VectorEntry& entry : entries) {
+        if (entry.data.size() != dimension) {
+            return false;
+        }
+        if (entry.resolution != resolution) {
+            resolution = -1;
+        }
+    }
+
+    // Section offsets
+    std::vector<uint64_t> labelOffsets(count + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        labelOffsets[i + 1] = labelOffsets[i] + strlen(entries[i].label);
+    }
+    const uint64_t matrix = alignOffset(BINARY_DATASET_HEADER_SIZE);
+    uint64_t next = matrix + count * dimension * sizeof(double);
+    const uint64_t resolutions = (resolution < 0) ? next : 0;
+    if (resolution < 0) {
+        next += count * sizeof(int32_t);
+    }
+    const uint64_t labelOffsetTable = alignOffset(next);
+    const uint64_t labelBlob = labelOffsetTable + (count + 1) * sizeof(uint64_t);
+    const uint64_t fileSize = labelBlob + labelOffsets[count];
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    uint8_t header[BINARY_DATASET_HEADER_SIZE] = {0};
+    const uint32_t magic = BINARY_DATASET_MAGIC;
+    memcpy(header + OFFSET_MAGIC, &magic, sizeof(magic));
+    memcpy(header + OFFSET_RESOLUTION, &resolution, sizeof(resolution));
+    memcpy(header + OFFSET_COUNT, &count, sizeof(count));
+    memcpy(header + OFFSET_DIMENSION, &dimension, sizeof(dimension));
+    memcpy(header + OFFSET_MATRIX, &matrix, sizeof(matrix));
+    memcpy(header + OFFSET_RESOLUTIONS, &resolutions, sizeof(resolutions));
+    memcpy(header + OFFSET_LABEL_OFFSETS, &labelOffsetTable, sizeof(labelOffsetTable));
+    memcpy(header + OFFSET_LABEL_BLOB, &labelBlob, sizeof(labelBlob));
+    memcpy(header + OFFSET_FILE_SIZE, &fileSize, sizeof(fileSize));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    const std::vector<char> padding(BINARY_DATASET_ALIGNMENT, 0);
+    file.write(padding.data(), static_cast<std::streamsize>(matrix - BINARY_DATASET_HEADER_SIZE));
+    for (const VectorEntry& entry : entries) {
+        file.write(reinterpret_cast<const char*>(entry.data.data()),
+                   static_cast<std::streamsize>(dimension * sizeof(double)));
+    }
+    if (resolution < 0) {
+        for (const VectorEntry& entry : entries) {
+            const int32_t entryResolution = entry.resolution;
+            file.write(reinterpret_cast<const char*>(&entryResolution), sizeof(entryResolution));
+        }
+    }
+    file.write(padding.data(), static_cast<std::streamsize>(labelOffsetTable - next));
+    file.write(reinterpret_cast<const char*>(labelOffsets.data()),
+               static_cast<std::streamsize>(labelOffsets.size() * sizeof(uint64_t)));
+    for (const VectorEntry& entry : entries) {
+        file.write(entry.label, static_cast<std::streamsize>(strlen(entry.label)));
+    }
+    return static_cast<bool>(file);
+}
+
+//---------------------------------------------------------------------------
+// Class TBinaryDataset
+//---------------------------------------------------------------------------
+
+bool TBinaryDataset::Attach(const void* data, size_t size) {
+    Count = 0;
+    Dimension = 0;
+    if (!isBinaryDataset(data, size) || size < BINARY_DATASET_HEADER_SIZE) {
+        return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    int32_t resolution;
+    memcpy(&resolution, bytes + OFFSET_RESOLUTION, sizeof(resolution));
+    const uint64_t count = readField(bytes, OFFSET_COUNT);
+    const uint64_t dimension = readField(bytes, OFFSET_DIMENSION);
+    const uint64_t matrix = readField(bytes, OFFSET_MATRIX);
+    const uint64_t resolutions = readField(bytes, OFFSET_RESOLUTIONS);
+    const uint64_t labelOffsets = readField(bytes, OFFSET_LABEL_OFFSETS);
+    const uint64_t labelBlob = readField(bytes, OFFSET_LABEL_BLOB);
+    const uint64_t fileSize = readField(bytes, OFFSET_FILE_SIZE);
+
+    // Every section must lie inside the file (sizes checked against overflow)
+    if (fileSize != size || matrix % sizeof(double) != 0 || labelOffsets % sizeof(uint64_t) != 0 ||
+        (dimension != 0 && count > size / dimension / sizeof(double)) || matrix > size ||
+        count * dimension * sizeof(double) > size - matrix || count >= size / sizeof(uint64_t) ||
+        labelOffsets > size || (count + 1) * sizeof(uint64_t) > size - labelOffsets || labelBlob > size) {
+        return false;
+    }
+    if (resolution < 0 && (resolutions % sizeof(int32_t) != 0 || resolutions > size ||
+                           count * sizeof(int32_t) > size - resolutions)) {
+        return false;
+    }
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(bytes + labelOffsets);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            return false;
+        }
+    }
+    if (offsets[0] != 0 || offsets[count] > size - labelBlob) {
+        return false;
+    }
+
+    Count = static_cast<size_t>(count);
+    Dimension = static_cast<size_t>(dimension);
+    Resolution = resolution;
+    Matrix = reinterpret_cast<const double*>(bytes + matrix);
+    Resolutions = (resolution < 0) ? reinterpret_cast<const int32_t*>(bytes + resolutions) : nullptr;
+    LabelOffsets = offsets;
+    LabelBlob = reinterpret_cast<const char*>(bytes + labelBlob);
+    return true;
+}
+
+int TBinaryDataset::GetResolution(size_t entry) const {
+    return (Resolutions != nullptr) ? Resolutions[entry] : Resolution;
+}
+
+const double* TBinaryDataset::GetCoefficients(size_t entry) const {
+    return Matrix + entry * Dimension;
+}
+
+std::string_view TBinaryDataset::GetLabel(size_t entry) const {
+    return std::string_view(LabelBlob + LabelOffsets[entry], LabelOffsets[entry + 1] - LabelOffsets[entry]);
+}
@@ -0,0 +1,106 @@
+#ifndef BINARY_DATASET_H
+#define BINARY_DATASET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct VectorEntry;
+
+//---------------------------------------------------------------------------
+// Binary dataset layout
+//---------------------------------------------------------------------------
+/**
+* Binary form of a text dataset (one "label resolution v1 ... vN" line per
+* entry), read through mmap with no parsing.
+*
+* <CODE>
+* +--------+--------+-------------+---------------+------------+
+* | Header | Matrix | Resolutions | Label offsets | Label blob |
+* +--------+--------+-------------+---------------+------------+
+* </CODE>
+* Header (BINARY_DATASET_HEADER_SIZE bytes):
+* <CODE>
+* +-------+-----+-------+-----------+--------+-------------+---------------+------------+------+
+* | Magic | Res | Count | Dimension | Matrix | Resolutions | Label offsets | Label blob | Size |
+* +-------+-----+-------+-----------+--------+-------------+---------------+------------+------+
+* </CODE>
+* Magic is a uint32_t and Res an int32_t; the other fields are uint64_t
+* (Matrix to Label blob are byte offsets from the start of the file and
+* Size is the file size).
+*
+* Matrix holds Count x Dimension doubles, row by row, starting at a
+* BINARY_DATASET_ALIGNMENT-aligned offset. Res is the resolution shared by
+* all entries; when they differ it is -1 and the Resolutions column (one
+* int32_t per entry) is present, otherwise its offset is 0. Label offsets
+* holds Count + 1 uint64_t values: label i is the bytes
+* [offset[i], offset[i + 1]) of the blob.
+*/
+const uint32_t BINARY_DATASET_MAGIC = 0x31534456; // "VDS1"
+const size_t BINARY_DATASET_HEADER_SIZE = 64;
+const size_t BINARY_DATASET_ALIGNMENT = 64;
+
+/**
+* Tells whether the first bytes of a file are those of a binary dataset.
+*/
+bool isBinaryDataset(const void* data, size_t size);
+
+/**
+* Writes 'entries' (all with the same number of coefficients) as a binary
+* dataset.
+* @return false if the file cannot be written or the sizes differ.
+*/
+bool writeBinaryDataset(const std::string& fileName, const std::vector<VectorEntry>& entries);
+
+//---------------------------------------------------------------------------
+// Class TBinaryDataset
+//---------------------------------------------------------------------------
+/**
+* Read-only view of a binary dataset held in memory (usually a mapped
+* file). The view does not own the bytes.
+*
+* @version 1.0
+*/
+class TBinaryDataset {
+public:
+    TBinaryDataset() : Count(0), Dimension(0), Resolution(-1), Matrix(nullptr), Resolutions(nullptr),
+        LabelOffsets(nullptr), LabelBlob(nullptr) {}
+
+    /**
+    * Attaches the view to 'size' bytes starting at 'data', which must stay
+    * valid while the view is used and be aligned to 8 bytes.
+    * @return false if the bytes are not a complete binary dataset.
+    */
+    bool Attach(const void* data, size_t size);
+
+    size_t GetCount() const { return Count; }
+    size_t GetDimension() const { return Dimension; }
+
+    /**
+    * Resolution of 'entry'.
+    */
+    int GetResolution(size_t entry) const;
+
+    /**
+    * The GetDimension() coefficients of 'entry'.
+    */
+    const double* GetCoefficients(size_t entry) const;
+
+    /**
+    * Label of 'entry'.
+    */
+    std::string_view GetLabel(size_t entry) const;
+
+private:
+    size_t Count;
+    size_t Dimension;
+    int Resolution;
+    const double* Matrix;
+    const int32_t* Resolutions;
+    const uint64_t* LabelOffsets;
+    const char* LabelBlob;
+};
+
+#endif // BINARY_DATASET_H
@@ -0,0 +1,196 @@
+#include "coarse_tier.h"
+#include "distance_kernels.h"
+
+#include <algorithm> // for std::max, std::copy
+#include <cmath>     // for std::ldexp
+#include <cstring>   // for memcpy, memset
+
+// Record field offsets
+static const size_t OFFSET_PAGE = 0;
+static const size_t OFFSET_SLOT = 4;
+static const size_t OFFSET_RESOLUTION = 8;
+static const size_t OFFSET_LEVEL = 10;
+static const size_t OFFSET_USED = 12;
+
+static size_t coarseTierRecordSize(size_t coefficientCount) {
+    return COARSE_TIER_RECORD_HEADER_SIZE + coefficientCount * sizeof(double);
+}
+
+int coarseTierLevel(size_t dimension, int resolution, size_t maxCoefficients) {
+    if (dimension == 0 || resolution < 0 || resolution >= static_cast<int>(sizeof(size_t) * 8)) {
+        return -1;
+    }
+    size_t size = dimension >> resolution;
+    int level = resolution;
+    while (size > maxCoefficients) {
+        // Same stop rules as haarForward
+        if (size <= 1 || size % 2 != 0) {
+            return -1;
+        }
+        size /= 2;
+        level++;
+    }
+    return (size > 0) ? level : -1;
+}
+
+//---------------------------------------------------------------------------
+// Class TCoarseTierWriter
+//---------------------------------------------------------------------------
+
+TCoarseTierWriter::TCoarseTierWriter(size_t coefficientCount) :
+    CoefficientCount(std::min<size_t>(std::max<size_t>(coefficientCount, 1), UINT16_MAX)), Count(0),
+    Record(coarseTierRecordSize(CoefficientCount)) {
+}
+
+TCoarseTierWriter::~TCoarseTierWriter() {
+    if (File.is_open()) {
+        Close();
+    }
+}
+
+bool TCoarseTierWriter::Open(const std::string& fileName) {
+    File.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!File) {
+        return false;
+    }
+    Count = 0;
+    uint8_t header[COARSE_TIER_HEADER_SIZE] = {0};
+    const uint32_t magic = COARSE_TIER_MAGIC;
+    const uint32_t coefficientCount = static_cast<uint32_t>(CoefficientCount);
+    memcpy(header, &magic, sizeof(magic));
+    memcpy(header + 4, &coefficientCount, sizeof(coefficientCount));
+    File.write(reinterpret_cast<const char*>(header), sizeof(header));
+    return static_cast<bool>(File);
+}
+
+bool TCoarseTierWriter::Add(size_t page, size_t slot, int resolution, const double* approx, size_t approxCount,
+                            size_t dimension) {
+    if (!File.is_open()) {
+        return false;
+    }
+    memset(Record.data(), 0, Record.size());
+    const int level = coarseTierLevel(dimension, resolution, CoefficientCount);
+    uint16_t used = 0;
+    if (level >= 0 && approx != nullptr && approxCount >= (dimension >> resolution)) {
+        // Average pairs down to the coarse level
+        size_t size = dimension >> resolution;
+        Scratch.assign(approx, approx + size);
+        for (int l = resolution; l < level; ++l) {
+            size /= 2;
+            for (size_t i = 0; i < size; ++i) {
+                Scratch[i] = (Scratch[2 * i] + Scratch[2 * i + 1]) * 0.5;
+            }
+        }
+        used = static_cast<uint16_t>(size);
+        memcpy(Record.data() + COARSE_TIER_RECORD_HEADER_SIZE, Scratch.data(), size * sizeof(double));
+    }
+    const uint32_t pageField = static_cast<uint32_t>(page);
+    const uint32_t slotField = static_cast<uint32_t>(slot);
+    const int16_t resolutionField = static_cast<int16_t>(resolution);
+    const int16_t levelField = static_cast<int16_t>(used > 0 ? level : resolution);
+    memcpy(Record.data() + OFFSET_PAGE, &pageField, sizeof(pageField));
+    memcpy(Record.data() + OFFSET_SLOT, &slotField, sizeof(slotField));
+    memcpy(Record.data() + OFFSET_RESOLUTION, &resolutionField, sizeof(resolutionField));
+    memcpy(Record.data() + OFFSET_LEVEL, &levelField, sizeof(levelField));
+    memcpy(Record.data() + OFFSET_USED, &used, sizeof(used));
+    File.write(reinterpret_cast<const char*>(Record.data()), Record.size());
+    Count++;
+    return static_cast<bool>(File);
+}
+
+bool TCoarseTierWriter::Close() {
+    if (!File.is_open()) {
+        return false;
+    }
+    File.seekp(8);
+    File.write(reinterpret_cast<const char*>(&Count), sizeof(Count));
+    const bool ok = static_cast<bool>(File);
+    File.close();
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+// Class TCoarseTier
+//---------------------------------------------------------------------------
+
+bool TCoarseTier::Load(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    const std::streamsize size = file.tellg();
+    if (size < static_cast<std::streamsize>(COARSE_TIER_HEADER_SIZE)) {
+        return false;
+    }
+    Data.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(Data.data()), size)) {
+        return false;
+    }
+
+    uint32_t magic, coefficientCount;
+    uint64_t count;
+    memcpy(&magic, Data.data(), sizeof(magic));
+    memcpy(&coefficientCount, Data.data() + 4, sizeof(coefficientCount));
+    memcpy(&count, Data.data() + 8, sizeof(count));
+    if (magic != COARSE_TIER_MAGIC || coefficientCount == 0 ||
+        (Data.size() - COARSE_TIER_HEADER_SIZE) / coarseTierRecordSize(coefficientCount) < count) {
+        Data.clear();
+        return false;
+    }
+    CoefficientCount = coefficientCount;
+    Count = static_cast<size_t>(count);
+    FileSize = Data.size();
+    PageCount = 0;
+    for (size_t entry = 0; entry < Count; ++entry) {
+        PageCount = std::max(PageCount, GetPage(entry) + 1);
+    }
+    return true;
+}
+
+const uint8_t* TCoarseTier::GetRecord(size_t entry) const {
+    return Data.data() + COARSE_TIER_HEADER_SIZE + entry * coarseTierRecordSize(CoefficientCount);
+}
+
+size_t TCoarseTier::GetPage(size_t entry) const {
+    uint32_t page;
+    memcpy(&page, GetRecord(entry) + OFFSET_PAGE, sizeof(page));
+    return page;
+}
+
+size_t TCoarseTier::GetSlot(size_t entry) const {
+    uint32_t slot;
+    memcpy(&slot, GetRecord(entry) + OFFSET_SLOT, sizeof(slot));
+    return slot;
+}
+
+int TCoarseTier::GetResolution(size_t entry) const {
+    int16_t resolution;
+    memcpy(&resolution, GetRecord(entry) + OFFSET_RESOLUTION, sizeof(resolution));
+    return resolution;
+}
+
+int TCoarseTier::GetLevel(size_t entry) const {
+    int16_t level;
+    memcpy(&level, GetRecord(entry) + OFFSET_LEVEL, sizeof(level));
+    return level;
+}
+
+const double* TCoarseTier::GetCoefficients(size_t entry, size_t& count) const {
+    uint16_t used;
+    const uint8_t* record = GetRecord(entry);
+    memcpy(&used, record + OFFSET_USED, sizeof(used));
+    count = std::min<size_t>(used, CoefficientCount);
+    return reinterpret_cast<const double*>(record + COARSE_TIER_RECORD_HEADER_SIZE);
+}
+
+double TCoarseTier::LowerBound(size_t entry, const double* query, double bound) const {
+    size_t count;
+    const double* coefficients = GetCoefficients(entry, count);
+    if (count == 0 || query == nullptr) {
+        return 0.0;
+    }
+    const int shift = GetLevel(entry) - GetResolution(entry);
+    const double sum = boundedManhattanDistance(coefficients, query, count, std::ldexp(bound, -shift));
+    return std::ldexp(sum, shift);
+}
@@ -0,0 +1,160 @@
+#ifndef COARSE_TIER_H
+#define COARSE_TIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Coarse tier layout
+//---------------------------------------------------------------------------
+/**
+* Side file of the sequential scan with a very coarse copy of each object
+* of a paged file: its Haar approximation at the first level with at most
+* M coefficients, plus the page and slot where the full object lives.
+*
+* <CODE>
+* +--------+---+-------+-----------+-----------+
+* | Magic  | M | Count | Record[0] | Record[1] | ...
+* +--------+---+-------+-----------+-----------+
+*
+* Record:
+* +------+------+-----+-------+---+-----+------------------+
+* | Page | Slot | Res | Level | N | Pad | Coefficients[M]  |
+* +------+------+-----+-------+---+-----+------------------+
+* </CODE>
+* Magic and M are uint32_t and Count a uint64_t (COARSE_TIER_HEADER_SIZE
+* bytes). In a record, Page and Slot are uint32_t, Res (the resolution of
+* the object) and Level (the resolution of the coarse copy) are int16_t and
+* N (coefficients actually used, at most M) a uint16_t. N is 0 when the
+* approximation cannot be brought down to M coefficients; such records
+* never prune anything.
+*
+* Each Haar level averages pairs of coefficients, so the L1 distance at
+* level k + 1 is at most half the distance at level k. The distance at
+* Level, scaled by 2^(Level - Res), is therefore a lower bound of the
+* distance at Res used by the scan.
+*/
+const uint32_t COARSE_TIER_MAGIC = 0x31545243; // "CRT1"
+const size_t COARSE_TIER_HEADER_SIZE = 16;
+const size_t COARSE_TIER_RECORD_HEADER_SIZE = 16;
+
+/**
+* Coarsest resolution, starting at 'resolution', whose approximation of a
+* 'dimension'-sized object has at most 'maxCoefficients' coefficients and
+* can be reached by averaging pairs. Returns -1 if there is none.
+*/
+int coarseTierLevel(size_t dimension, int resolution, size_t maxCoefficients);
+
+//---------------------------------------------------------------------------
+// Class TCoarseTierWriter
+//---------------------------------------------------------------------------
+/**
+* Writes a coarse tier file, one record per object, in the order the
+* objects are added.
+*
+* @version 1.0
+*/
+class TCoarseTierWriter {
+public:
+    /**
+    * @param coefficientCount M, the maximum number of coefficients kept per
+    * object (at least 1).
+    */
+    explicit TCoarseTierWriter(size_t coefficientCount);
+    ~TCoarseTierWriter();
+
+    /**
+    * Creates (or truncates) the file and writes a provisional header.
+    */
+    bool Open(const std::string& fileName);
+
+    /**
+    * Appends the coarse copy of an object.
+    * @param page Page of the paged file holding the object.
+    * @param slot Position of the object within its page.
+    * @param approx Approximation block of the object at 'resolution'.
+    * @param approxCount Number of coefficients in 'approx'.
+    * @param dimension Total number of coefficients of the object.
+    */
+    bool Add(size_t page, size_t slot, int resolution, const double* approx, size_t approxCount,
+             size_t dimension);
+
+    /**
+    * Writes the final object count and closes the file.
+    */
+    bool Close();
+
+    size_t GetCount() const { return Count; }
+
+private:
+    std::ofstream File;
+    size_t CoefficientCount;
+    uint64_t Count;
+    std::vector<uint8_t> Record;
+    std::vector<double> Scratch;
+};
+
+//---------------------------------------------------------------------------
+// Class TCoarseTier
+//---------------------------------------------------------------------------
+/**
+* A coarse tier file loaded in memory (it is meant to be small).
+*
+* @version 1.0
+*/
+class TCoarseTier {
+public:
+    TCoarseTier() : CoefficientCount(0), Count(0), FileSize(0), PageCount(0) {}
+
+    /**
+    * Reads the whole file.
+    * @return false if it cannot be read or is not a valid coarse tier.
+    */
+    bool Load(const std::string& fileName);
+
+    size_t GetCount() const { return Count; }
+    size_t GetCoefficientCount() const { return CoefficientCount; }
+
+    /**
+    * Size of the file in bytes, for the I/O accounting of the scan.
+    */
+    size_t GetFileSize() const { return FileSize; }
+
+    /**
+    * One more than the largest page number referenced by the records.
+    */
+    size_t GetPageCount() const { return PageCount; }
+
+    size_t GetPage(size_t entry) const;
+    size_t GetSlot(size_t entry) const;
+    int GetResolution(size_t entry) const;
+    int GetLevel(size_t entry) const;
+
+    /**
+    * Coarse coefficients of 'entry'; their number is written to 'count'
+    * (0 when the record cannot prune).
+    */
+    const double* GetCoefficients(size_t entry, size_t& count) const;
+
+    /**
+    * Lower bound of the distance between 'entry' and a query whose
+    * approximation at GetLevel(entry) is 'query'. The sum stops once the
+    * bound exceeds 'bound' (the result is then only known to be larger).
+    * Returns 0 for records that cannot prune.
+    */
+    double LowerBound(size_t entry, const double* query, double bound) const;
+
+private:
+    std::vector<uint8_t> Data;
+    size_t CoefficientCount;
+    size_t Count;
+    size_t FileSize;
+    size_t PageCount;
+
+    const uint8_t* GetRecord(size_t entry) const;
+};
+
+#endif // COARSE_TIER_H
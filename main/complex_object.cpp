@@ -1,9 +1,12 @@
 #pragma hdrstop // Mantido se estiver usando C++Builder, caso contrário pode remover
 #include "complex_object.h"
+#include "haar_transform.h"
+#include "distance_kernels.h" // for MANHATTAN_INT_LIMIT
 #include <cstring> // for memcpy
 #include <vector>
 #include <stdexcept> // for std::runtime_error
 #include <cmath>
+#include <algorithm> // for std::fill
 
 #pragma package(smart_init) // Mantido se estiver usando C++Builder
 
@@ -11,11 +14,227 @@
 // Class TComplexObject
 //---------------------------------------------------------------------------
 
+int TComplexObject::StoredDetailLevels = -1;
+int TComplexObject::SerialFormat = 2;
+bool TComplexObject::InlineLabels = false;
+bool TComplexObject::IntegerCoefficients = false;
+bool TComplexObject::StorePyramid = false;
+bool TComplexObject::ResultIDsOnly = false;
+
+void TComplexObject::SetSerialFormat(int version) {
+    if (version != 1 && version != 2) {
+        throw std::invalid_argument("Unknown TComplexObject serial format.");
+    }
+    SerialFormat = version;
+}
+
+// Resolution word layout: low 16 bits resolution, bits 16-23 stored detail
+// levels + 1 (0 = all coefficients stored).
+static const int RESOLUTION_MASK = 0xFFFF;
+static const int DETAIL_LEVELS_SHIFT = 16;
+static const int DETAIL_LEVELS_MASK = 0xFF;
+
+/**
+* Number of Data elements stored for an object of the given dimension and
+* resolution when 'levelsPlusOne' (from the resolution word) is not 0.
+*/
+static size_t storedCountFromHeader(size_t dataSize, int resolution, int levelsPlusOne) {
+    if (levelsPlusOne == 0 || resolution <= 0) {
+        return dataSize;
+    }
+    size_t approxSize = dataSize >> resolution;
+    size_t stored = approxSize << (levelsPlusOne - 1);
+    return (stored < dataSize) ? stored : dataSize;
+}
+
+/**
+* Fields decoded from the header of a serialized object, in either format.
+*/
+struct SerialHeader {
+    int format;
+    int resolution;
+    size_t dimension;
+    size_t storedCount;
+    size_t labelLength;
+    uint32_t objectID;
+    TComplexObject::CoefficientEncoding encoding;
+    size_t labelOffset;       // From the start of the object
+    size_t coefficientOffset; // From the start of the object
+    size_t coefficientEnd;    // First byte after the stored coefficients
+    size_t pyramidOffset;     // 0 if there is no pyramid
+    int pyramidLevels;
+    size_t totalSize;
+};
+
+/**
+* Decodes the header at 'data'. Returns false if fewer than the header
+* bytes are available; the variable fields are not checked.
+*/
+static bool decodeSerialHeader(const uint8_t* data, size_t available, SerialHeader& header) {
+    if (available >= 1 && data[0] == TComplexObject::SERIAL_V2_TAG) {
+        // Tag, Res, Dimension, Stored Cnt, Flags, Label Len
+        const size_t headerSize = 8;
+        if (available < headerSize) {
+            return false;
+        }
+        uint16_t dimension, storedCount;
+        memcpy(&dimension, data + 2, sizeof(uint16_t));
+        memcpy(&storedCount, data + 4, sizeof(uint16_t));
+        header.format = 2;
+        header.resolution = data[1];
+        header.dimension = dimension;
+        header.storedCount = storedCount;
+        header.labelLength = data[7];
+        header.encoding = TComplexObject::COEFFICIENTS_DOUBLE;
+        size_t coefficientSize = sizeof(double);
+        if (data[6] & TComplexObject::SERIAL_FLAG_INT32) {
+            header.encoding = TComplexObject::COEFFICIENTS_INT32;
+            coefficientSize = sizeof(int32_t);
+        } else if (data[6] & TComplexObject::SERIAL_FLAG_INT16) {
+            header.encoding = TComplexObject::COEFFICIENTS_INT16;
+            coefficientSize = sizeof(int16_t);
+        }
+        header.coefficientOffset = headerSize;
+        header.labelOffset = headerSize + header.storedCount * coefficientSize;
+        header.coefficientEnd = header.labelOffset;
+        header.pyramidOffset = 0;
+        header.pyramidLevels = 0;
+        if (data[6] & TComplexObject::SERIAL_FLAG_PYRAMID) {
+            // Pyramid doubles start at the next multiple of 8
+            header.pyramidOffset = (header.coefficientEnd + 7) & ~size_t(7);
+            header.pyramidLevels = haarPyramidLevels(header.dimension, header.resolution);
+            header.labelOffset = header.pyramidOffset +
+                                 haarPyramidSize(header.dimension, header.resolution) * sizeof(double);
+        }
+        header.objectID = TComplexObject::NO_OBJECT_ID;
+        if (data[6] & TComplexObject::SERIAL_FLAG_OBJECT_ID) {
+            // The ID follows the coefficients
+            if (available < header.labelOffset + sizeof(uint32_t)) {
+                return false;
+            }
+            memcpy(&header.objectID, data + header.labelOffset, sizeof(uint32_t));
+            header.labelOffset += sizeof(uint32_t);
+        }
+        header.totalSize = (header.labelOffset + header.labelLength + 7) & ~size_t(7);
+        return true;
+    }
+
+    // Resolution (int), Data Size (size_t), Label Length (size_t)
+    const size_t headerSize = sizeof(int) + 2 * sizeof(size_t);
+    if (available < headerSize) {
+        return false;
+    }
+    int resolutionWord;
+    memcpy(&resolutionWord, data, sizeof(int));
+    memcpy(&header.dimension, data + sizeof(int), sizeof(size_t));
+    memcpy(&header.labelLength, data + sizeof(int) + sizeof(size_t), sizeof(size_t));
+
+    header.format = 1;
+    header.objectID = TComplexObject::NO_OBJECT_ID;
+    header.encoding = TComplexObject::COEFFICIENTS_DOUBLE;
+    header.resolution = static_cast<int16_t>(resolutionWord & RESOLUTION_MASK);
+    int levelsPlusOne = (resolutionWord >> DETAIL_LEVELS_SHIFT) & DETAIL_LEVELS_MASK;
+    header.storedCount = storedCountFromHeader(header.dimension, header.resolution, levelsPlusOne);
+    header.labelOffset = headerSize;
+    header.coefficientOffset = headerSize + header.labelLength;
+    header.totalSize = header.coefficientOffset + header.storedCount * sizeof(double);
+    header.coefficientEnd = header.totalSize;
+    header.pyramidOffset = 0;
+    header.pyramidLevels = 0;
+    return true;
+}
+
+size_t TComplexObject::GetSerializedDataCount(int& detailLevels) const {
+    const size_t dim = Data.size();
+    detailLevels = -1;
+    if (dim == 0 || Resolution <= 0 || Resolution >= DETAIL_LEVELS_MASK) {
+        return dim; // Nothing to truncate
+    }
+    size_t approxSize = dim >> Resolution;
+    if (approxSize == 0) {
+        return dim;
+    }
+
+    int levels = (StoredDetailLevels < 0 || StoredDetailLevels > Resolution) ? Resolution : StoredDetailLevels;
+    // Never claim more coefficients than this object actually holds
+    while (levels > 0 && (approxSize << levels) > StoredSize) {
+        levels--;
+    }
+    if (levels >= Resolution) {
+        return dim; // Every detail level is kept: original layout
+    }
+    detailLevels = levels;
+    return approxSize << levels;
+}
+
+size_t TComplexObject::PeekSerializedSize(const uint8_t* data, size_t available, int& resolution) {
+    SerialHeader header;
+    if (!decodeSerialHeader(data, available, header)) {
+        return 0;
+    }
+    resolution = header.resolution;
+    return header.totalSize;
+}
+
+TComplexObject::CoefficientEncoding TComplexObject::GetCoefficientEncoding(size_t storedCount) const {
+    if (!IntegerCoefficients || storedCount == 0) {
+        return COEFFICIENTS_DOUBLE;
+    }
+    if (EncodingCount == storedCount) {
+        return Encoding;
+    }
+    bool fitsInt16 = true;
+    Encoding = COEFFICIENTS_INT32;
+    for (size_t i = 0; i < storedCount; ++i) {
+        // Multiplying by a power of 2 is exact, so integral means lossless
+        double scaled = std::ldexp(Data[i], Resolution);
+        if (!(std::abs(scaled) <= MANHATTAN_INT_LIMIT) || std::trunc(scaled) != scaled) {
+            Encoding = COEFFICIENTS_DOUBLE;
+            break;
+        }
+        if (scaled < INT16_MIN || scaled > INT16_MAX) {
+            fitsInt16 = false;
+        }
+    }
+    if (Encoding == COEFFICIENTS_INT32 && fitsInt16) {
+        Encoding = COEFFICIENTS_INT16;
+    }
+    EncodingCount = storedCount;
+    return Encoding;
+}
+
+const int32_t* TComplexObject::GetScaledApproximation() const {
+    if (ScaledApproximationState == SCALED_UNKNOWN) {
+        size_t approxSize = (Resolution <= 0) ? Data.size() : (Data.size() >> Resolution);
+        ScaledApproximation.resize(approxSize);
+        ScaledApproximationState = SCALED_VALID;
+        for (size_t i = 0; i < approxSize; ++i) {
+            double scaled = std::ldexp(Data[i], Resolution);
+            if (!(std::abs(scaled) <= MANHATTAN_INT_LIMIT) || std::trunc(scaled) != scaled) {
+                ScaledApproximationState = SCALED_NOT_INTEGER;
+                ScaledApproximation.clear();
+                break;
+            }
+            ScaledApproximation[i] = static_cast<int32_t>(scaled);
+        }
+    }
+    return (ScaledApproximationState == SCALED_VALID) ? ScaledApproximation.data() : nullptr;
+}
+
+size_t TComplexObject::GetSerializedPyramidSize() const {
+    if (!StorePyramid || Resolution < 0) {
+        return 0;
+    }
+    return haarPyramidSize(Data.size(), Resolution);
+}
+
 void TComplexObject::InvalidateSerializedBuffer() {
     if (Serialized != nullptr) {
         delete[] Serialized;
         Serialized = nullptr;
     }
+    ScaledApproximationState = SCALED_UNKNOWN;
+    EncodingCount = NO_ENCODING;
 }
 
 /**
@@ -30,15 +249,87 @@ const uint8_t* TComplexObject::Serialize() {
         Serialized = new uint8_t[totalSize];
         uint8_t* currentPos = Serialized;
 
-        // --- Serialization Order ---
+        int detailLevels;
+        size_t storedCount = GetSerializedDataCount(detailLevels);
+
+        if (UsesSerialV2(storedCount)) {
+            // --- Serialization Order (v2) ---
+            // Tag, Res, Dimension, Stored Cnt, Flags, Label Len,
+            // Data (double*), Object ID (optional), Label (char*), Padding
+            uint16_t dimension = static_cast<uint16_t>(Data.size());
+            uint16_t stored16 = static_cast<uint16_t>(storedCount);
+            size_t labelLen = GetSerializedLabelLength();
+            CoefficientEncoding encoding = GetCoefficientEncoding(storedCount);
+            uint8_t flags = (ObjectID != NO_OBJECT_ID) ? SERIAL_FLAG_OBJECT_ID : 0;
+            if (encoding == COEFFICIENTS_INT32) {
+                flags |= SERIAL_FLAG_INT32;
+            } else if (encoding == COEFFICIENTS_INT16) {
+                flags |= SERIAL_FLAG_INT16;
+            }
+            size_t pyramidSize = GetSerializedPyramidSize();
+            if (pyramidSize > 0) {
+                flags |= SERIAL_FLAG_PYRAMID;
+            }
+            currentPos[0] = SERIAL_V2_TAG;
+            currentPos[1] = static_cast<uint8_t>(Resolution);
+            memcpy(currentPos + 2, &dimension, sizeof(uint16_t));
+            memcpy(currentPos + 4, &stored16, sizeof(uint16_t));
+            currentPos[6] = flags;
+            currentPos[7] = static_cast<uint8_t>(labelLen);
+            currentPos += SERIAL_V2_HEADER_SIZE;
+
+            if (encoding == COEFFICIENTS_DOUBLE) {
+                memcpy(currentPos, Data.data(), storedCount * sizeof(double));
+            } else {
+                // Scaled by 2^Resolution: exact integers (checked above)
+                for (size_t i = 0; i < storedCount; ++i) {
+                    double scaled = std::ldexp(Data[i], Resolution);
+                    if (encoding == COEFFICIENTS_INT32) {
+                        int32_t value = static_cast<int32_t>(scaled);
+                        memcpy(currentPos + i * sizeof(int32_t), &value, sizeof(int32_t));
+                    } else {
+                        int16_t value = static_cast<int16_t>(scaled);
+                        memcpy(currentPos + i * sizeof(int16_t), &value, sizeof(int16_t));
+                    }
+                }
+            }
+            currentPos += storedCount * CoefficientSize(encoding);
+
+            if (pyramidSize > 0) {
+                // Align the pyramid to 8 bytes from the start of the object
+                size_t alignedOffset = ((currentPos - Serialized) + 7) & ~size_t(7);
+                memset(currentPos, 0, (Serialized + alignedOffset) - currentPos);
+                currentPos = Serialized + alignedOffset;
+                // The buffer comes from new[], so this offset is double-aligned
+                haarBuildPyramid(Data.data(), Data.size(), Resolution, reinterpret_cast<double*>(currentPos));
+                currentPos += pyramidSize * sizeof(double);
+            }
+            if (ObjectID != NO_OBJECT_ID) {
+                memcpy(currentPos, &ObjectID, sizeof(uint32_t));
+                currentPos += sizeof(uint32_t);
+            }
+            if (labelLen > 0) {
+                memcpy(currentPos, Label.c_str(), labelLen);
+                currentPos += labelLen;
+            }
+            // Padding is zeroed so equal objects serialize to equal bytes
+            memset(currentPos, 0, (Serialized + totalSize) - currentPos);
+            return Serialized;
+        }
+
+        // --- Serialization Order (v1) ---
         // Resolution (int), Data Size (size_t), Label Length (size_t),
         // Label (char*), Data (double*)
 
-        // 1. Resolution
-        memcpy(currentPos, &Resolution, sizeof(int));
+        // 1. Resolution (with the stored detail levels in the upper bits)
+        int resolutionWord = Resolution;
+        if (detailLevels >= 0) {
+            resolutionWord = (Resolution & RESOLUTION_MASK) | ((detailLevels + 1) << DETAIL_LEVELS_SHIFT);
+        }
+        memcpy(currentPos, &resolutionWord, sizeof(int));
         currentPos += sizeof(int);
 
-        // 2. Data Size (number of elements in the vector)
+        // 2. Data Size (number of elements in the vector, stored or not)
         size_t dataSize = Data.size();
         memcpy(currentPos, &dataSize, sizeof(size_t));
         currentPos += sizeof(size_t);
@@ -55,8 +346,8 @@ const uint8_t* TComplexObject::Serialize() {
         }
 
         // 5. Data vector elements (variable length array of doubles)
-        if (dataSize > 0) {
-             size_t dataBytes = dataSize * sizeof(double);
+        if (storedCount > 0) {
+             size_t dataBytes = storedCount * sizeof(double);
              memcpy(currentPos, Data.data(), dataBytes);
              // currentPos increment not needed as it's the last element
              // currentPos += dataBytes;
@@ -84,8 +375,8 @@ int TComplexObject::GetResolutionSerial(const uint8_t* data, size_t datasize) {
         Serialized = nullptr; // Mark as invalid
     }
 
-    int res;
-    memcpy(&res, data, sizeof(int));
+    int res = 0;
+    PeekSerializedSize(data, datasize, res);
     return res;
 }
 
@@ -100,62 +391,29 @@ void TComplexObject::Unserialize(const uint8_t* data, size_t datasize) {
         Serialized = nullptr; // Mark as invalid
     }
 
-    const uint8_t* currentPos = data;
-    size_t remainingSize = datasize;
-
-    // --- Deserialization Order (must match Serialize) ---
-    // Resolution, Data Size, Label Length, Label, Data
-
-    // Check minimum size before reading fixed parts
-    size_t minFixedSize = sizeof(int) + sizeof(size_t) * 2;
-    if (remainingSize < minFixedSize) {
-        throw std::runtime_error("Insufficient data for TComplexObject Unserialize (fixed fields).");
-    }
+    // Header decoding and size checks are shared with TComplexObjectView
+    TComplexObjectView view(data, datasize);
 
     // 1. Resolution
-    memcpy(&Resolution, currentPos, sizeof(int));
-    currentPos += sizeof(int);
-    remainingSize -= sizeof(int);
-
-    // 2. Data Size (number of elements)
-    size_t dataSize;
-    memcpy(&dataSize, currentPos, sizeof(size_t));
-    currentPos += sizeof(size_t);
-    remainingSize -= sizeof(size_t);
-
-    // 3. Label Length
-    size_t labelLen;
-    memcpy(&labelLen, currentPos, sizeof(size_t));
-    currentPos += sizeof(size_t);
-    remainingSize -= sizeof(size_t);
-
-    // Check if remaining size matches expected variable parts size
-    size_t dataVecBytes = dataSize * sizeof(double);
-    if (remainingSize < (labelLen + dataVecBytes)) {
-         throw std::runtime_error("Insufficient data for TComplexObject Unserialize (variable fields size mismatch).");
-    }
-    // Can also check if remainingSize == (labelLen + dataVecBytes) for exact match
+    Resolution = view.GetResolution();
 
-    // 4. Label
-    if (labelLen > 0) {
-        Label.assign(reinterpret_cast<const char*>(currentPos), labelLen);
-        currentPos += labelLen;
-        remainingSize -= labelLen;
+    // 2. Object ID and Label (empty when kept in a TLabelStore)
+    ObjectID = view.GetObjectID();
+    if (view.GetLabelLength() > 0) {
+        Label.assign(view.GetLabelData(), view.GetLabelLength());
     } else {
         Label.clear(); // Ensure label is empty if length was 0
     }
 
-    // 5. Data vector
-    Data.resize(dataSize); // Resize vector to hold the incoming data
-    if (dataSize > 0) {
-        // Double check remaining size is sufficient (though checked above)
-        if (remainingSize < dataVecBytes) {
-             throw std::runtime_error("Insufficient data for TComplexObject Unserialize (Data vector).");
-        }
-        memcpy(Data.data(), currentPos, dataVecBytes);
-        // currentPos += dataVecBytes; // Not needed for last element read
-        // remainingSize -= dataVecBytes;
-    }
+    // 3. Data vector (integer encodings are scaled back to doubles)
+    size_t storedCount = view.GetStoredSize();
+    Data.resize(view.GetDimension()); // Resize vector to hold the incoming data
+    view.DecodeCoefficients(Data.data(), storedCount);
+    ScaledApproximationState = SCALED_UNKNOWN;
+    EncodingCount = NO_ENCODING;
+    // Coefficients that were not stored are restored as zeros
+    std::fill(Data.begin() + storedCount, Data.end(), 0.0);
+    StoredSize = storedCount;
 
     // Object state is now updated. Keep Serialized as nullptr
     // until Serialize() is called again.
@@ -173,6 +431,12 @@ void TComplexObject::dataCompression(const int lvlCompress) {
         // Call internal compression helper
         DoCompression(lvlCompress);
     } else {
+        // Decompression needs the detail coefficients of every level crossed
+        int targetResolution = (Resolution + lvlCompress > 0) ? Resolution + lvlCompress : 0;
+        size_t neededSize = (targetResolution == 0) ? Data.size() : (Data.size() >> targetResolution);
+        if (StoredSize < neededSize) {
+            throw std::runtime_error("Detail coefficients needed for decompression were not stored.");
+        }
         // Call internal decompression helper with positive level count
         DoDecompression(std::abs(lvlCompress));
     }
@@ -183,55 +447,9 @@ void TComplexObject::DoCompression(const int levels) {
     if (levels <= 0) return; // Sanity check
     if (Data.empty()) return; // Cannot compress empty data
 
-    std::vector<double> tempBuffer(Data.size()); // Temporary buffer for results
-    int currentLevel = 0;
-
-    // Loop for the requested number of levels or until max compression is reached
-    while (currentLevel < levels) {
-        // Use double for calculation involving pow to avoid potential integer truncation
-        double currentApproxSizeF = static_cast<double>(Data.size()) / pow(2.0, static_cast<double>(Resolution));
-        size_t approxSize = static_cast<size_t>(currentApproxSizeF);
-
-        // Check if further compression is possible
-        if (approxSize <= 1) {
-            break; // Cannot reduce further
-        }
-
-        // Ensure approxSize is even for pairing (should be if original size was power of 2 based)
-        // This implicitly handles non-power-of-2 sizes by stopping compression early.
-        if (approxSize % 2 != 0) {
-             // Or log a warning: "Data size at current resolution is odd, stopping compression."
-            break;
-        }
-
-        size_t nextApproxSize = approxSize / 2; // Size after one more compression step
-
-        // 1. Calculate new approximations and details
-        for (size_t i = 0; i < nextApproxSize; ++i) {
-            double val1 = Data[2 * i];
-            double val2 = Data[(2 * i) + 1];
-            tempBuffer[i] = (val1 + val2) / 2.0; // Approximation
-            tempBuffer[i + nextApproxSize] = (val1 - val2) / 2.0; // Detail
-        }
-
-        // 2. Copy untouched detail coefficients from previous levels (if any)
-        // These start after the currently processed block (indices from approxSize up to Data.size())
-        for (size_t i = approxSize; i < Data.size(); ++i) {
-            tempBuffer[i] = Data[i];
-        }
-
-        // 3. Update Resolution and copy data back from buffer
-        Resolution++;
-        // Use std::vector's move assignment for potential efficiency
-        Data = std::move(tempBuffer);
-        // Re-allocate tempBuffer for the next iteration if needed (or resize)
-        // Since Data size doesn't change, we can just reuse the buffer by swapping back
-        // Or just create a new one each loop if clarity is preferred and size isn't huge
-        tempBuffer.resize(Data.size()); // Ensure size is correct if we were to reuse
-
-
-        currentLevel++;
-    }
+    // In-place lifting: stops by itself when the approximation block has a
+    // single or an odd number of elements
+    Resolution = haarForward(Data.data(), Data.size(), Resolution, levels);
     // Serialized buffer was invalidated at the start of dataCompression
 }
 
@@ -243,74 +461,132 @@ void TComplexObject::DoDecompression(const int levels) {
         return;
     }
 
-    std::vector<double> tempBuffer(Data.size()); // Temporary buffer
-    int currentLevel = 0;
+    // In-place inverse lifting, down to resolution 0 at most
+    Resolution = haarInverse(Data.data(), Data.size(), Resolution, levels);
+    // Serialized buffer was invalidated at the start of dataCompression
+}
 
-    // Loop for the requested number of levels or until resolution is 0
-    while (currentLevel < levels && Resolution > 0) {
 
-        // Size of the approximation part at the *current* resolution (before decompression)
-        double currentApproxSizeF = static_cast<double>(Data.size()) / pow(2.0, static_cast<double>(Resolution));
-        size_t approxSize = static_cast<size_t>(currentApproxSizeF);
+//---------------------------------------------------------------------------
+// Class TComplexObjectView
+//---------------------------------------------------------------------------
 
-        // Check for potential issues from pow or non-integer results
-         if (approxSize == 0 && !Data.empty()) {
-             // Should not happen if Resolution > 0, but check anyway
-             // Log warning: "Approximation size is zero during decompression, stopping."
-             break;
-         }
-         // Check if approxSize * 2 would exceed original data size (corruption?)
-         if (approxSize > Data.size() / 2) {
-              // Log warning: "Calculated approximation size seems too large, stopping decompression."
-             break;
-         }
+TComplexObjectView::TComplexObjectView(const uint8_t* data, size_t datasize) :
+    Serialized(data), SerializedSize(datasize) {
+    // --- Deserialization Order (must match TComplexObject::Serialize) ---
+    // v2: Tag, Res, Dimension, Stored Cnt, Flags, Label Len, Data, ID, Label
+    // v1: Resolution, Data Size, Label Length, Label, Data
+    SerialHeader header;
+    if (!decodeSerialHeader(data, datasize, header)) {
+        throw std::runtime_error("Insufficient data for TComplexObject Unserialize (fixed fields).");
+    }
+    SerialFormat = header.format;
+    Resolution = header.resolution;
+    Dimension = header.dimension;
+    StoredSize = header.storedCount;
+    LabelLength = header.labelLength;
+    ObjectID = header.objectID;
+    Encoding = header.encoding;
+
+    // Check if the buffer holds the variable parts (v2 padding is optional)
+    if (datasize < header.coefficientEnd ||
+        datasize < header.labelOffset + LabelLength) {
+         throw std::runtime_error("Insufficient data for TComplexObject Unserialize (variable fields size mismatch).");
+    }
+    if (StoredSize > Dimension) {
+         throw std::runtime_error("Invalid TComplexObject header (stored count exceeds dimension).");
+    }
 
+    // Label and Data are referenced in place
+    LabelData = reinterpret_cast<const char*>(data + header.labelOffset);
+    RawCoefficients = data + header.coefficientOffset;
+    Pyramid = (header.pyramidOffset != 0) ? data + header.pyramidOffset : nullptr;
+    PyramidLevels = header.pyramidLevels;
+}
 
-        // Size of the data part that will be reconstructed in this step
-        size_t reconstructSize = approxSize * 2;
+/**
+* Size in bytes of one stored coefficient of 'encoding'.
+*/
+static size_t coefficientSize(TComplexObject::CoefficientEncoding encoding) {
+    switch (encoding) {
+        case TComplexObject::COEFFICIENTS_INT32: return sizeof(int32_t);
+        case TComplexObject::COEFFICIENTS_INT16: return sizeof(int16_t);
+        default: return sizeof(double);
+    }
+}
 
-        // 1. Reconstruct data using approximations and details
-        for (size_t i = 0; i < approxSize; ++i) {
-            double approx = Data[i];
-            // Details are stored right after approximations
-            // Add boundary check for safety, although logic implies it should be fine
-            if ((i + approxSize) >= Data.size()) {
-                 throw std::runtime_error("Data index out of bounds during decompression (detail coeff).");
-            }
-            double detail = Data[i + approxSize];
+bool TComplexObjectView::HasAlignedCoefficients() const {
+    // Every coefficient type has its size as alignment
+    return reinterpret_cast<uintptr_t>(RawCoefficients) % coefficientSize(Encoding) == 0;
+}
 
-            // Check indices for write access
-            if ((2 * i + 1) >= tempBuffer.size()) {
-                 throw std::runtime_error("Buffer index out of bounds during decompression (write access).");
-            }
+const void* TComplexObjectView::GetAlignedCoefficients() const {
+    if (HasAlignedCoefficients()) {
+        return RawCoefficients;
+    }
+    if (AlignedCoefficients.empty() && StoredSize > 0) {
+        const size_t bytes = StoredSize * coefficientSize(Encoding);
+        AlignedCoefficients.resize((bytes + sizeof(double) - 1) / sizeof(double));
+        memcpy(AlignedCoefficients.data(), RawCoefficients, bytes);
+    }
+    return AlignedCoefficients.data();
+}
 
-            tempBuffer[2 * i]     = approx + detail;
-            tempBuffer[2 * i + 1] = approx - detail;
+const double* TComplexObjectView::GetPyramidLevel(int resolution) const {
+    if (Pyramid == nullptr || resolution <= Resolution || resolution > Resolution + PyramidLevels) {
+        return nullptr;
+    }
+    const double* pyramid = reinterpret_cast<const double*>(Pyramid);
+    if (reinterpret_cast<uintptr_t>(Pyramid) % alignof(double) != 0) {
+        if (AlignedPyramid.empty()) {
+            AlignedPyramid.resize(haarPyramidSize(Dimension, Resolution));
+            memcpy(AlignedPyramid.data(), Pyramid, AlignedPyramid.size() * sizeof(double));
         }
+        pyramid = AlignedPyramid.data();
+    }
+    return pyramid + haarPyramidOffset(Dimension, Resolution, resolution);
+}
 
-        // 2. Copy untouched detail coefficients from previous levels (if any)
-        // These start after the block containing the details we just used (indices from reconstructSize up to Data.size())
-        for (size_t i = reconstructSize; i < Data.size(); ++i) {
-             // Check indices for read/write access
-             if (i >= Data.size() || i >= tempBuffer.size()) {
-                 throw std::runtime_error("Index out of bounds during decompression (copying details).");
-             }
-            tempBuffer[i] = Data[i];
+void TComplexObjectView::DecodeCoefficients(double* out, size_t count) const {
+    if (count > StoredSize) {
+        count = StoredSize;
+    }
+    if (Encoding == TComplexObject::COEFFICIENTS_DOUBLE) {
+        if (count > 0) {
+            memcpy(out, RawCoefficients, count * sizeof(double));
         }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        double scaled;
+        if (Encoding == TComplexObject::COEFFICIENTS_INT32) {
+            int32_t value;
+            memcpy(&value, RawCoefficients + i * sizeof(int32_t), sizeof(int32_t));
+            scaled = value;
+        } else {
+            int16_t value;
+            memcpy(&value, RawCoefficients + i * sizeof(int16_t), sizeof(int16_t));
+            scaled = value;
+        }
+        out[i] = std::ldexp(scaled, -Resolution);
+    }
+}
 
-        // 3. Update Resolution and copy data back from buffer
-        Resolution--;
-        Data = std::move(tempBuffer); // Replaces Data's content
-         // Re-allocate or resize tempBuffer if loop continues
-        tempBuffer.resize(Data.size());
-
+TComplexObject* TComplexObjectView::Materialize() const {
+    TComplexObject* obj = new TComplexObject();
+    obj->Unserialize(Serialized, SerializedSize);
+    return obj;
+}
 
-        currentLevel++;
+TComplexObject* TComplexObjectView::MaterializeResult() const {
+    if (!TComplexObject::GetResultIDsOnly()) {
+        return Materialize();
     }
-     // Serialized buffer was invalidated at the start of dataCompression
+    TComplexObject* obj = new TComplexObject(std::string(LabelData, LabelLength), Resolution, std::vector<double>());
+    obj->SetObjectID(ObjectID);
+    return obj;
 }
 
-
 //---------------------------------------------------------------------------
 // Output operator
 //---------------------------------------------------------------------------
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <stdexcept> // Para std::runtime_error
 #include <cstring>   // Para memcpy
 #include <ostream>
@@ -15,6 +16,8 @@
 // mas mantendo caso a estrutura ainda seja usada externamente)
 // #include <arboretum/stUtil.h> // Comente ou remova se não usar mais
 
+class TComplexObjectView;
+
 //---------------------------------------------------------------------------
 // Class TComplexObject
 //---------------------------------------------------------------------------
@@ -32,7 +35,34 @@
 * - Serialize() - Gets the serialized version.
 * - Unserialize() - Restores a serialized object.
 *
-* The serialized format is:
+* Two serialized formats are supported. Version 2 (the default) is:
+* <CODE>
+* +-----+-----+-----------+------------+-------+-----------+--------+-------+---------+
+* | Tag | Res | Dimension | Stored Cnt | Flags | Label Len | Data[] | Label | Padding |
+* +-----+-----+-----------+------------+-------+-----------+--------+-------+---------+
+* </CODE>
+* Tag is the byte SERIAL_V2_TAG, Res is a uint8_t, Dimension and Stored Cnt
+* are uint16_t, Flags and Label Len are uint8_t (8 bytes of header). Data[]
+* holds Stored Cnt doubles right after the header, so it keeps the
+* alignment of the buffer the object is written to. The optional label
+* follows the coefficients and the whole object is padded to a multiple of
+* 8 bytes, so objects placed back to back in a page stay aligned too.
+*
+* When Flags has SERIAL_FLAG_INT32 or SERIAL_FLAG_INT16 set, Data[] holds
+* int32_t or int16_t values equal to each coefficient times
+* 2^resolution (see SetIntegerCoefficients) instead of doubles.
+*
+* When Flags has SERIAL_FLAG_PYRAMID set, Data[] is followed (at the next
+* multiple of 8 bytes) by the approximation pyramid: the approximation
+* blocks of every coarser resolution, as doubles (see SetStorePyramid and
+* haarBuildPyramid).
+*
+* When Flags has SERIAL_FLAG_OBJECT_ID set, a uint32_t object ID sits
+* after Data[] (and the pyramid) and before the label. Objects with an ID omit the label unless
+* SetInlineLabels(true) was called; the label is then kept in a
+* TLabelStore and resolved from the ID only when it is needed.
+*
+* Version 1 (the original format, still read) is:
 * <CODE>
 * +------------+-----------------+-----------------+-------------+--------+
 * | Resolution | Data Size (sz_t)| Label Len (sz_t)| Label (str) | Data[] |
@@ -41,17 +71,39 @@
 * Resolution is int. Data Size and Label Len are size_t.
 * Label is a variable-length string. Data[] elements are doubles.
 *
-* @version 1.2
+* The low 16 bits of the Resolution word hold the resolution. Bits 16-23
+* hold the number of stored detail levels plus one; 0 means every
+* coefficient is stored (the original layout). When it is not 0, Data[]
+* only holds the approximation block followed by that many detail levels
+* (see SetStoredDetailLevels) and Data Size is still the full dimension;
+* the missing coefficients are restored as zeros and GetStoredSize()
+* tells how many leading coefficients are valid.
+*
+* Objects that do not fit the v2 field widths (resolution outside 0-255,
+* more than 65535 coefficients or labels longer than 255 characters) are
+* always written as version 1. A v1 object whose first byte equals
+* SERIAL_V2_TAG would need a resolution of 194 (or -62), which never
+* happens in practice.
+*
+* @version 1.6
 * @author Adaptado
 */
 class TComplexObject {
 public:
+    /**
+    * Read-only view over the serialized form of this type. Used by the
+    * tree queries to evaluate entries straight from the page bytes.
+    */
+    typedef TComplexObjectView ViewType;
+
     /**
     * Default constructor. Required by stObject interface.
     * Initializes resolution to 0, label to empty, data vector to empty.
     */
     TComplexObject() :
-        Resolution(0), Label(""), Serialized(nullptr) {
+        Resolution(0), Label(""), StoredSize(0), ObjectID(NO_OBJECT_ID),
+        ScaledApproximationState(SCALED_UNKNOWN), EncodingCount(NO_ENCODING),
+        Serialized(nullptr) {
         // Data vector is default-initialized to empty
         // Serialized buffer is invalidated.
     }
@@ -64,7 +116,9 @@ public:
     * @param data A vector of double values representing the object's features.
     */
     TComplexObject(const std::string& label, int resolution, const std::vector<double>& data) :
-        Label(label), Resolution(resolution), Data(data), Serialized(nullptr) {
+        Label(label), Resolution(resolution), Data(data), StoredSize(data.size()),
+        ObjectID(NO_OBJECT_ID), ScaledApproximationState(SCALED_UNKNOWN), EncodingCount(NO_ENCODING),
+        Serialized(nullptr) {
         // Serialized buffer is invalidated.
     }
 
@@ -72,7 +126,10 @@ public:
     * Copy constructor.
     */
     TComplexObject(const TComplexObject& other) :
-        Label(other.Label), Resolution(other.Resolution), Data(other.Data), Serialized(nullptr)
+        Label(other.Label), Resolution(other.Resolution), Data(other.Data),
+        StoredSize(other.StoredSize), ObjectID(other.ObjectID),
+        ScaledApproximationState(SCALED_UNKNOWN), EncodingCount(NO_ENCODING),
+        Serialized(nullptr)
     {
         // Invalidate potential serialized buffer copy - create own when needed
     }
@@ -85,6 +142,10 @@ public:
             Label = other.Label;
             Resolution = other.Resolution;
             Data = other.Data;
+            StoredSize = other.StoredSize;
+            ObjectID = other.ObjectID;
+            ScaledApproximationState = SCALED_UNKNOWN;
+            EncodingCount = NO_ENCODING;
 
             // Invalidate and clean up old serialized buffer
             if (Serialized != nullptr) {
@@ -104,11 +165,158 @@ public:
         }
     }
 
+    /**
+    * Replaces the contents of this object, reusing the memory already held
+    * by the label and the coefficients. The object ID is cleared. Lets a
+    * dataset be streamed through a single object (see
+    * VectorFileReader::forEachObject).
+    */
+    void Assign(std::string_view label, int resolution, const double* data, size_t count) {
+        Label.assign(label.data(), label.size());
+        Resolution = resolution;
+        Data.assign(data, data + count);
+        StoredSize = count;
+        ObjectID = NO_OBJECT_ID;
+        InvalidateSerializedBuffer();
+    }
+
     // --- Getters ---
     const std::string& GetLabel() const { return Label; }
     int GetResolution() const { return Resolution; }
     const std::vector<double>& GetData() const { return Data; }
 
+    /**
+    * Number of leading coefficients of Data that hold real values. Objects
+    * restored from a truncated serialization only keep the approximation
+    * block and a few detail levels; the rest of Data is zero-filled.
+    */
+    size_t GetStoredSize() const { return StoredSize; }
+
+    /**
+    * Value of GetObjectID() for objects without an ID.
+    */
+    static const uint32_t NO_OBJECT_ID = 0xFFFFFFFF;
+
+    /**
+    * ID of this object in a TLabelStore, or NO_OBJECT_ID. Like the label,
+    * the ID is not considered by IsEqual().
+    */
+    uint32_t GetObjectID() const { return ObjectID; }
+    void SetObjectID(uint32_t id) {
+        ObjectID = id;
+        InvalidateSerializedBuffer();
+    }
+
+    // --- Storage mode ---
+
+    /**
+    * Sets how many detail levels are serialized after the approximation
+    * block. A negative value (the default) serializes every coefficient.
+    * 0 stores only the approximation block, which is all GetDistance2 reads
+    * when comparing at the object's own or a coarser resolution.
+    * Applies to every object serialized afterwards.
+    */
+    static void SetStoredDetailLevels(int levels) { StoredDetailLevels = levels; }
+    static int GetStoredDetailLevels() { return StoredDetailLevels; }
+
+    /**
+    * First byte of every object serialized in format version 2.
+    */
+    static const uint8_t SERIAL_V2_TAG = 0xC2;
+
+    /**
+    * Selects the format written by Serialize(): 1 (original layout) or 2
+    * (compact header, the default). Both are always accepted by
+    * Unserialize() and TComplexObjectView. Applies to every object
+    * serialized afterwards.
+    */
+    static void SetSerialFormat(int version);
+    static int GetSerialFormat() { return SerialFormat; }
+
+    /**
+    * Flags bit of format 2 telling that an object ID follows Data[].
+    */
+    static const uint8_t SERIAL_FLAG_OBJECT_ID = 0x01;
+
+    /**
+    * Selects whether objects that have an object ID also serialize their
+    * label (false by default: the ID is enough to find it in a
+    * TLabelStore). Objects without an ID, or written in format 1, always
+    * keep the label inline.
+    */
+    static void SetInlineLabels(bool inlineLabels) { InlineLabels = inlineLabels; }
+    static bool GetInlineLabels() { return InlineLabels; }
+
+    /**
+    * Flags bits of format 2 telling how Data[] is encoded (doubles when
+    * neither is set).
+    */
+    static const uint8_t SERIAL_FLAG_INT32 = 0x02;
+    static const uint8_t SERIAL_FLAG_INT16 = 0x04;
+
+    /**
+    * How the coefficients of a serialized object are stored.
+    */
+    enum CoefficientEncoding {
+        COEFFICIENTS_DOUBLE,
+        COEFFICIENTS_INT32,
+        COEFFICIENTS_INT16
+    };
+
+    /**
+    * Enables the lossless integer storage mode. Histogram bins are whole
+    * numbers and every averaging level adds one binary fraction digit, so
+    * the coefficients of an object at resolution r become integers once
+    * multiplied by 2^r. When enabled, objects whose scaled coefficients are
+    * all integers of magnitude up to MANHATTAN_INT_LIMIT are written as
+    * int16_t (if they fit) or int32_t in format 2; anything else is still
+    * written as doubles. Applies to every object serialized afterwards.
+    */
+    static void SetIntegerCoefficients(bool enabled) { IntegerCoefficients = enabled; }
+    static bool GetIntegerCoefficients() { return IntegerCoefficients; }
+
+    /**
+    * Flags bit of format 2 telling that an approximation pyramid follows
+    * Data[].
+    */
+    static const uint8_t SERIAL_FLAG_PYRAMID = 0x08;
+
+    /**
+    * Enables the approximation pyramid: format 2 objects also store the
+    * approximation of every coarser resolution they can reach (about
+    * dimension / 2^resolution extra doubles), so comparisons against a
+    * coarser query read the right level instead of re-averaging the
+    * coefficients. The pyramid is derived data: Unserialize() ignores it
+    * and Serialize() rebuilds it. Applies to every object serialized
+    * afterwards.
+    */
+    static void SetStorePyramid(bool enabled) { StorePyramid = enabled; }
+    static bool GetStorePyramid() { return StorePyramid; }
+
+    /**
+    * Enables the ID-only result mode: query results built through
+    * TComplexObjectView::MaterializeResult() keep only the identity of the
+    * object (object ID, inline label and resolution), without coefficients.
+    * Enough for counting results or listing (ID, distance) pairs.
+    */
+    static void SetResultIDsOnly(bool enabled) { ResultIDsOnly = enabled; }
+    static bool GetResultIDsOnly() { return ResultIDsOnly; }
+
+    /**
+    * Approximation block of this object multiplied by 2^resolution, as
+    * integers, or NULL if some value is not an integer within
+    * MANHATTAN_INT_LIMIT. Computed once and kept until the object changes;
+    * used to compare query objects against integer-encoded entries.
+    */
+    const int32_t* GetScaledApproximation() const;
+
+    /**
+    * Returns the size in bytes of the serialized object starting at 'data',
+    * read from its header, or 0 if fewer than the header bytes are
+    * available. Resolution is returned through 'resolution'.
+    */
+    static size_t PeekSerializedSize(const uint8_t* data, size_t available, int& resolution);
+
     // --- stObject interface methods ---
 
     /**
@@ -116,7 +324,7 @@ public:
     * @return A new instance of TComplexObject identical to this one.
     */
     TComplexObject* Clone() const {
-        return new TComplexObject(Label, Resolution, Data);
+        return new TComplexObject(*this);
     }
 
     /**
@@ -143,10 +351,24 @@ public:
     * Required by stObject interface.
     */
     size_t GetSerializedSize() const {
+        int detailLevels;
+        size_t storedCount = GetSerializedDataCount(detailLevels);
+        if (UsesSerialV2(storedCount)) {
+            // 8 byte header, Data, Object ID, Label, padded to a multiple of 8
+            size_t size = SERIAL_V2_HEADER_SIZE +
+                          storedCount * CoefficientSize(GetCoefficientEncoding(storedCount));
+            size_t pyramidSize = GetSerializedPyramidSize();
+            if (pyramidSize > 0) {
+                size = ((size + 7) & ~size_t(7)) + pyramidSize * sizeof(double);
+            }
+            size += ((ObjectID != NO_OBJECT_ID) ? sizeof(uint32_t) : 0) +
+                          GetSerializedLabelLength();
+            return (size + 7) & ~size_t(7);
+        }
         // Fixed parts: Resolution (int), Data size (size_t), Label length (size_t)
-        // Variable parts: Label (string chars), Data (vector elements)
+        // Variable parts: Label (string chars), Data (stored vector elements)
         return sizeof(int) + (sizeof(size_t) * 2) +
-               Label.length() + (Data.size() * sizeof(double));
+               Label.length() + (storedCount * sizeof(double));
     }
 
     int GetResolutionSerial(const uint8_t* data, size_t datasize);
@@ -174,6 +396,114 @@ private:
     int Resolution;
     std::vector<double> Data;
 
+    /**
+    * Number of leading valid coefficients in Data (Data.size() unless the
+    * object was restored from a truncated serialization).
+    */
+    size_t StoredSize;
+
+    /**
+    * ID of the object in a TLabelStore (NO_OBJECT_ID if none).
+    */
+    uint32_t ObjectID;
+
+    /**
+    * Cache of GetScaledApproximation().
+    */
+    enum { SCALED_UNKNOWN, SCALED_VALID, SCALED_NOT_INTEGER };
+    mutable int ScaledApproximationState;
+    mutable std::vector<int32_t> ScaledApproximation;
+
+    /**
+    * Cache of GetCoefficientEncoding(): the integer encoding found for the
+    * first EncodingCount coefficients. Invalidated with the serialized
+    * buffer.
+    */
+    static const size_t NO_ENCODING = SIZE_MAX;
+    mutable size_t EncodingCount;
+    mutable CoefficientEncoding Encoding;
+
+    /**
+    * Detail levels serialized after the approximation block (-1 = all).
+    */
+    static int StoredDetailLevels;
+
+    /**
+    * Format version written by Serialize() (1 or 2).
+    */
+    static int SerialFormat;
+
+    /**
+    * Serialize labels of objects that have an object ID (see SetInlineLabels).
+    */
+    static bool InlineLabels;
+
+    /**
+    * Integer storage mode (see SetIntegerCoefficients).
+    */
+    static bool IntegerCoefficients;
+
+    /**
+    * Approximation pyramid mode (see SetStorePyramid).
+    */
+    static bool StorePyramid;
+
+    /**
+    * ID-only result mode (see SetResultIDsOnly).
+    */
+    static bool ResultIDsOnly;
+
+    /**
+    * Number of pyramid doubles written by Serialize() in format 2 (0 if the
+    * pyramid is disabled or no coarser level exists).
+    */
+    size_t GetSerializedPyramidSize() const;
+
+    /**
+    * Encoding used by Serialize() in format 2 for the first 'storedCount'
+    * coefficients under the current storage mode. The scan of the
+    * coefficients is cached until the serialized buffer is invalidated.
+    */
+    CoefficientEncoding GetCoefficientEncoding(size_t storedCount) const;
+
+    /**
+    * Bytes per coefficient of the given encoding.
+    */
+    static size_t CoefficientSize(CoefficientEncoding encoding) {
+        return (encoding == COEFFICIENTS_INT32) ? sizeof(int32_t) :
+               (encoding == COEFFICIENTS_INT16) ? sizeof(int16_t) : sizeof(double);
+    }
+
+    /**
+    * Number of label characters written by Serialize() in format 2.
+    */
+    size_t GetSerializedLabelLength() const {
+        return (ObjectID != NO_OBJECT_ID && !InlineLabels) ? 0 : Label.length();
+    }
+
+    /**
+    * Size of the fixed part of a v2 serialized object.
+    */
+    static const size_t SERIAL_V2_HEADER_SIZE = 8;
+
+    /**
+    * Checks if this object is written in format 2: it must be selected and
+    * every field must fit its v2 width.
+    */
+    bool UsesSerialV2(size_t storedCount) const {
+        return SerialFormat == 2 &&
+               Resolution >= 0 && Resolution <= 0xFF &&
+               Data.size() <= 0xFFFF && storedCount <= 0xFFFF &&
+               Label.length() <= 0xFF;
+    }
+
+    /**
+    * Number of Data elements written by Serialize() under the current
+    * storage mode. 'detailLevels' receives the number of detail levels
+    * kept, or -1 if the whole vector is written.
+    */
+    size_t GetSerializedDataCount(int& detailLevels) const;
+
     /**
     * Serialized version buffer. NULL if not created or invalidated.
     * Managed internally by Serialize() and Unserialize().
@@ -198,6 +528,148 @@ private:
     void DoDecompression(const int levels);
 };
 
+//---------------------------------------------------------------------------
+// Class TComplexObjectView
+//---------------------------------------------------------------------------
+/**
+* Read-only view of a serialized TComplexObject. It only decodes the header
+* and points straight into the serialized bytes (typically an entry inside
+* an stPage), so building one costs no allocation and no copy. A view is
+* valid only while the underlying buffer is.
+*
+* TComplexObjectDistanceEvaluator accepts views, so queries can evaluate
+* node entries without Unserialize and materialize only the objects that
+* enter an stResult.
+*
+* Both serialized formats are accepted. In format 2 the coefficients have
+* the alignment of the page buffer; in format 1 they follow a
+* variable-length label, and objects packed in a page start at any offset,
+* so they may not be aligned for their type. The pointers returned by
+* GetCoefficients(), GetInt32Coefficients(), GetInt16Coefficients() and
+* GetPyramidLevel() are always aligned: when the bytes are not, the view
+* copies them (on first use) into a buffer it owns. Callers that want to
+* avoid that copy check HasAlignedCoefficients() and use
+* DecodeCoefficients(), which reads with memcpy.
+*
+* Integer-encoded coefficients are exposed through GetInt32Coefficients()
+* or GetInt16Coefficients(); GetCoefficients() is NULL for them and
+* DecodeCoefficients() converts any encoding back to doubles.
+*/
+class TComplexObjectView {
+public:
+    /**
+    * Decodes the header of the serialized object in 'data'.
+    * Throws std::runtime_error if 'datasize' is too small for it.
+    */
+    TComplexObjectView(const uint8_t* data, size_t datasize);
+
+    int GetResolution() const { return Resolution; }
+
+    /**
+    * Format version of the serialized bytes (1 or 2).
+    */
+    int GetSerialFormat() const { return SerialFormat; }
+
+    /**
+    * Object ID stored in the serialized bytes, or
+    * TComplexObject::NO_OBJECT_ID if none was written.
+    */
+    uint32_t GetObjectID() const { return ObjectID; }
+
+    /**
+    * Full number of coefficients of the object (Data.size() once restored).
+    */
+    size_t GetDimension() const { return Dimension; }
+
+    /**
+    * Number of coefficients present in the serialized bytes.
+    */
+    size_t GetStoredSize() const { return StoredSize; }
+
+    TComplexObject::CoefficientEncoding GetCoefficientEncoding() const { return Encoding; }
+
+    /**
+    * Checks if the serialized coefficients are aligned for their type, so
+    * the Get*Coefficients() methods return them in place.
+    */
+    bool HasAlignedCoefficients() const;
+
+    /**
+    * Coefficients stored as doubles, or NULL for integer encodings.
+    */
+    const double* GetCoefficients() const {
+        return (Encoding == TComplexObject::COEFFICIENTS_DOUBLE) ?
+               static_cast<const double*>(GetAlignedCoefficients()) : nullptr;
+    }
+
+    /**
+    * Scaled coefficients (value * 2^resolution) of integer encodings, or
+    * NULL if the object uses another encoding.
+    */
+    const int32_t* GetInt32Coefficients() const {
+        return (Encoding == TComplexObject::COEFFICIENTS_INT32) ?
+               static_cast<const int32_t*>(GetAlignedCoefficients()) : nullptr;
+    }
+    const int16_t* GetInt16Coefficients() const {
+        return (Encoding == TComplexObject::COEFFICIENTS_INT16) ?
+               static_cast<const int16_t*>(GetAlignedCoefficients()) : nullptr;
+    }
+
+    /**
+    * Writes the first 'count' (<= GetStoredSize()) coefficients to 'out'
+    * as doubles, whatever the encoding.
+    */
+    void DecodeCoefficients(double* out, size_t count) const;
+
+    /**
+    * Checks if the serialized object carries an approximation pyramid.
+    */
+    bool HasPyramid() const { return Pyramid != nullptr; }
+
+    /**
+    * Approximation block at a coarser 'resolution' read from the pyramid,
+    * or NULL if the object has no pyramid or it does not reach that level.
+    */
+    const double* GetPyramidLevel(int resolution) const;
+    const char* GetLabelData() const { return LabelData; }
+    size_t GetLabelLength() const { return LabelLength; }
+
+    /**
+    * Creates a heap-allocated TComplexObject with the contents of this view.
+    */
+    TComplexObject* Materialize() const;
+
+    /**
+    * Creates the object stored in a query result: the same as
+    * Materialize(), or only its identity (no coefficients) when
+    * TComplexObject::GetResultIDsOnly() is set.
+    */
+    TComplexObject* MaterializeResult() const;
+
+private:
+    /**
+    * The stored coefficients, in place or copied to AlignedCoefficients.
+    */
+    const void* GetAlignedCoefficients() const;
+
+    const uint8_t* Serialized;
+    size_t SerializedSize;
+    int SerialFormat;
+    int Resolution;
+    size_t Dimension;
+    size_t StoredSize;
+    const char* LabelData;
+    size_t LabelLength;
+    uint32_t ObjectID;
+    TComplexObject::CoefficientEncoding Encoding;
+    const uint8_t* RawCoefficients;
+    const uint8_t* Pyramid;
+    int PyramidLevels;
+    // Aligned copies of misaligned serialized bytes (empty otherwise)
+    mutable std::vector<double> AlignedCoefficients;
+    mutable std::vector<double> AlignedPyramid;
+};
+
 // --- Output Operator ---
 /**
 * Writes a string representation of a TComplexObject to an output stream.
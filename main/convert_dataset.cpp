@@ -0,0 +1,49 @@
+// convert_dataset.cpp
+// Converte um dataset texto ("label resolução v1 ... vN" por linha) para o
+// formato binário de binary_dataset.h, que o VectorFileReader carrega sem parsing.
+
+#include <iostream>
+#include <string>
+#include <chrono>    // Para medir o tempo de leitura
+
+#include "VectorFileReader.hpp"
+#include "binary_dataset.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Uso: " << argv[0] << " <arquivoTexto> <arquivoBinario>" << std::endl;
+        std::cerr << "Exemplo: " << argv[0] << " ../data/dados-hist/dataHist20k-3-500.txt dataHist20k-3-500.vds" << std::endl;
+        return 1;
+    }
+    const std::string inputFile = argv[1];
+    const std::string outputFile = argv[2];
+
+    // Lê o arquivo texto com as mesmas validações do carregamento normal
+    VectorFileReader reader;
+    auto start = std::chrono::steady_clock::now();
+    if (!reader.loadFromFile(inputFile)) {
+        std::cerr << "ERRO: Falha ao ler o arquivo de entrada '" << inputFile << "'." << std::endl;
+        return 1;
+    }
+    auto textTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (!writeBinaryDataset(outputFile, reader.getVectors())) {
+        std::cerr << "ERRO: Falha ao gravar o arquivo binário '" << outputFile << "'." << std::endl;
+        return 1;
+    }
+
+    // Confere o arquivo gerado relendo-o pelo mesmo caminho usado pelas aplicações
+    VectorFileReader check;
+    start = std::chrono::steady_clock::now();
+    if (!check.loadFromFile(outputFile) || check.getNumLines() != reader.getNumLines() ||
+        check.getNumElements() != reader.getNumElements()) {
+        std::cerr << "ERRO: O arquivo binário '" << outputFile << "' não confere com a entrada." << std::endl;
+        return 1;
+    }
+    auto binaryTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Convertido '" << inputFile << "' -> '" << outputFile << "': "
+              << reader.getNumLines() << " entradas, " << reader.getNumElements() << " elementos por vetor." << std::endl;
+    std::cout << "Leitura texto: " << textTime << " ms | Leitura binária: " << binaryTime << " ms" << std::endl;
+    return 0;
+}
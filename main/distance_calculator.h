@@ -5,7 +5,10 @@
 #include <stdexcept>    // For std::runtime_error
 #include <iostream>
 #include <memory>
+#include <limits>       // For std::numeric_limits
+#include <cmath>        // For std::ldexp
 #include "complex_object.h" // Include the definition of the object type
+#include "distance_kernels.h" // Manhattan and cross-resolution kernels
 
 // Include for the base class DistanceFunction
 #include <hermes/DistanceFunction.h>
@@ -18,9 +21,21 @@
 *
 * This implementation uses the Manhattan distance between the Data vectors.
 * It requires the Data vectors of both objects to have the same dimension.
+* Objects at different resolutions are compared at the resolution of the
+* second object without cloning or transforming the first one.
 *
+* Entries stored with integer coefficients (see
+* TComplexObject::SetIntegerCoefficients) are compared with integer kernels
+* when the query is integral at the same resolution. That sum is exact and
+* rescaled once; it equals the double computation when the double sums are
+* exact too (small integer histograms, say) and otherwise differs from it
+* only by the rounding of the double path.
 *
-* @version 1.0
+* Entries serialized with an approximation pyramid (see
+* TComplexObject::SetStorePyramid) are compared against coarser queries
+* straight from the stored level.
+*
+* @version 1.3
 * @author Adapted from TCityDistanceEvaluator
 */
 class TComplexObjectDistanceEvaluator : public DistanceFunction<TComplexObject> {
@@ -33,108 +48,165 @@ public:
     * Calculates the Manhattan distance between the 'Data' vectors of two objects.
     * Throws std::runtime_error if data vectors have different dimensions.
     *
+    * When 'bound' is given, accumulation stops as soon as the partial sum
+    * exceeds it and that partial sum is returned instead (see
+    * boundedManhattanDistance). Results <= bound are always exact.
+    *
     * @param obj1 First TComplexObject.
     * @param obj2 Second TComplexObject.
+    * @param bound Early-abandon threshold (infinity computes the full distance).
     * @return The Manhattan distance.
     */
-    virtual double GetDistance2(TComplexObject& obj1, TComplexObject& obj2) {
+    virtual double GetDistance2(TComplexObject& obj1, TComplexObject& obj2,
+                                double bound = std::numeric_limits<double>::infinity()) {
+        const std::vector<double>& data1_obj = obj1.GetData();
+        return ComputeDistance(data1_obj.data(), obj1.GetResolution(), data1_obj.size(),
+                               obj1.GetStoredSize(), obj2, bound);
+    }
 
-        // --- Section 1: Prepare Data Pointers and Handle Resolution Differences ---
+    /**
+    * Same as GetDistance2, with the first object read in place from its
+    * serialized bytes (no Unserialize, no copy).
+    *
+    * @param obj1 View over the serialized first object.
+    * @param obj2 Second TComplexObject (target resolution).
+    * @param bound Early-abandon threshold (infinity computes the full distance).
+    * @return The Manhattan distance, or a partial sum greater than bound.
+    */
+    virtual double GetDistance(const TComplexObjectView& obj1, TComplexObject& obj2,
+                               double bound = std::numeric_limits<double>::infinity()) {
+        // Coarser query: the pyramid already holds its approximation
+        if (obj1.GetDimension() == obj2.GetData().size()) {
+            const double* level = obj1.GetPyramidLevel(obj2.GetResolution());
+            if (level != nullptr) {
+                double sumOfDiff = boundedManhattanDistance(level, obj2.GetData().data(),
+                    approximationSize(obj1.GetDimension(), obj2.GetResolution()), bound);
+                updateDistanceCount();
+                return sumOfDiff;
+            }
+        }
 
-        const int targetResolution = obj2.GetResolution();
-        const std::vector<double>& data2_obj = obj2.GetData();
+        if (obj1.GetCoefficientEncoding() == TComplexObject::COEFFICIENTS_DOUBLE) {
+            return ComputeDistance(obj1.GetCoefficients(), obj1.GetResolution(), obj1.GetDimension(),
+                                   obj1.GetStoredSize(), obj2, bound);
+        }
 
-        // Pointer to the data vector of obj1 (or its temporary clone)
-        const std::vector<double>* data1_ptr = &obj1.GetData();
-
-        // Smart pointer to manage the lifetime of a temporary clone of obj1
-        // Using unique_ptr ensures clone is deleted even if exceptions occur
-        std::unique_ptr<TComplexObject> obj1_temp_clone_ptr = nullptr;
-
-        int currentResolution = obj1.GetResolution();
-
-        // Check if obj1 needs resolution adjustment
-        if (currentResolution != targetResolution) {
-            // Clone obj1 to avoid modifying the original object permanently
-            // Clone returns a raw pointer, manage it with unique_ptr
-             try {
-                obj1_temp_clone_ptr.reset(obj1.Clone()); // Transfer ownership to unique_ptr
-             } catch (const std::bad_alloc& e) {
-                 throw std::runtime_error("Failed to allocate memory for obj1 clone.");
-             }
-            if (!obj1_temp_clone_ptr) {
-                 throw std::runtime_error("Failed to clone obj1 for distance calculation (null result).");
+        // Integer entry and integral query at the same resolution: exact
+        // integer sum of the scaled coefficients, rescaled once
+        const int resolution = obj1.GetResolution();
+        const size_t approxSize = approximationSize(obj1.GetDimension(), resolution);
+        if (resolution == obj2.GetResolution() && obj1.GetDimension() == obj2.GetData().size() &&
+            approxSize > 0 && approxSize <= obj1.GetStoredSize()) {
+            const int32_t* query = obj2.GetScaledApproximation();
+            if (query != nullptr) {
+                const double scaledBound = std::ldexp(bound, resolution);
+                int64_t sumOfDiff = (obj1.GetCoefficientEncoding() == TComplexObject::COEFFICIENTS_INT16) ?
+                    boundedManhattanDistanceInt16(obj1.GetInt16Coefficients(), query, approxSize, scaledBound) :
+                    boundedManhattanDistanceInt32(obj1.GetInt32Coefficients(), query, approxSize, scaledBound);
+                updateDistanceCount();
+                return std::ldexp(static_cast<double>(sumOfDiff), -resolution);
             }
+        }
 
-            // Check for fundamental size mismatch before transforming
-            if (obj1_temp_clone_ptr->GetData().size() != data2_obj.size()) {
-                 // No need to delete clone, unique_ptr handles it.
-                 throw std::runtime_error("Objects have different underlying data sizes, cannot compare.");
-            }
+        // Any other case works on the coefficients converted back to doubles
+        thread_local std::vector<double> decoded;
+        decoded.resize(obj1.GetStoredSize());
+        obj1.DecodeCoefficients(decoded.data(), decoded.size());
+        return ComputeDistance(decoded.data(), resolution, obj1.GetDimension(),
+                               obj1.GetStoredSize(), obj2, bound);
+    }
 
-            // Calculate the transformation level needed for the clone
-            // Positive = compress, Negative = decompress
-            int levelsToTransform = targetResolution - currentResolution;
-
-            // Apply the transformation *to the clone* using the public dataCompression method
-            // This method now internally handles positive (compress) and negative (decompress) levels.
-            obj1_temp_clone_ptr->dataCompression(levelsToTransform);
-
-            // Verify that the transformation resulted in the target resolution
-            if (obj1_temp_clone_ptr->GetResolution() != targetResolution) {
-                // This might happen if transform couldn't complete all levels (e.g., hit res 0)
-                // Depending on requirements, could throw or maybe compare at the achieved resolution?
-                // Throwing is safer if exact resolution match is expected.
-                 // unique_ptr handles deletion of clone.
-                 throw std::runtime_error("Failed to adjust obj1 clone to target resolution. CloneRes="
-                    + std::to_string(obj1_temp_clone_ptr->GetResolution()) + ", TargetRes=" + std::to_string(targetResolution));
-            }
+    /**
+    * Calculates the Euclidean distance between the 'Data' vectors of two objects.
+    * This is the primary distance function.
+    * Uses GetDistance2 internally for calculation.
+    * Throws std::runtime_error if data vectors have different dimensions.
+    *
+    * @param obj1 First TComplexObject.
+    * @param obj2 Second TComplexObject.
+    * @return The Euclidean distance.
+    */
+    virtual double GetDistance(TComplexObject& obj1, TComplexObject& obj2) {
+         // No need to call updateDistanceCount() here if GetDistance2 does it.
+         return GetDistance2(obj1, obj2);
+    }
 
-            // Update the pointer to use the transformed data from the clone
-            data1_ptr = &obj1_temp_clone_ptr->GetData();
+    /**
+    * Bounded version of GetDistance, used by range queries to prune
+    * candidates: stops accumulating once the partial distance exceeds
+    * 'bound'. A returned value <= bound is the exact distance; a value
+    * > bound only tells that the object does not qualify.
+    *
+    * @param obj1 First TComplexObject.
+    * @param obj2 Second TComplexObject.
+    * @param bound The threshold the caller compares the distance with.
+    * @return The distance, or a partial sum greater than bound.
+    */
+    virtual double GetDistance(TComplexObject& obj1, TComplexObject& obj2, double bound) {
+         return GetDistance2(obj1, obj2, bound);
+    }
 
-        } else {
-             // Resolutions already match, still check for size compatibility
-             if (obj1.GetData().size() != data2_obj.size()) {
-                 throw std::runtime_error("Objects have different underlying data sizes, cannot compare.");
-             }
-             // data1_ptr already points to obj1.GetData() - no clone needed
-        }
 
-        // --- Section 2: Calculate Distance using Approximation Coefficients ---
+    /**
+     * Provided for compatibility if the original code used getDistance
+     * directly in some places. Delegates to GetDistance.
+     */
+    double getDistance(TComplexObject& obj1, TComplexObject& obj2){
+       return GetDistance(obj1, obj2);
+    }
 
-        // Now, data1_ptr points to the data of obj1 (or its clone) at targetResolution
-        // and data2_obj is the data of obj2 at targetResolution. Their underlying sizes match.
+private:
 
-        // Calculate the number of approximation coefficients at the target resolution
-        if (data2_obj.empty()) {
-            updateDistanceCount(); // Count distance calc even for empty objects? Your choice.
-            return 0.0; // Distance is 0 if objects are empty
+    /**
+    * Distance between a first object given by its raw coefficients and obj2,
+    * evaluated at obj2's resolution. Shared by the object and view overloads.
+    *
+    * @param data1 Coefficients of the first object.
+    * @param currentResolution Resolution of the first object.
+    * @param dimension1 Full number of coefficients of the first object.
+    * @param storedSize Number of valid leading coefficients in data1.
+    * @param obj2 Second TComplexObject (target resolution).
+    * @param bound Early-abandon threshold.
+    */
+    double ComputeDistance(const double* data1, int currentResolution, size_t dimension1,
+                           size_t storedSize, TComplexObject& obj2, double bound) {
+
+        // --- Section 1: Validate Sizes and Resolution Differences ---
+
+        const int targetResolution = obj2.GetResolution();
+        const std::vector<double>& data2_obj = obj2.GetData();
+
+        if (dimension1 != data2_obj.size()) {
+            throw std::runtime_error("Objects have different underlying data sizes, cannot compare.");
         }
-        if (!data1_ptr || data1_ptr->empty()) {
-             // Should not happen if data2_obj is not empty and sizes match, but check
-             updateDistanceCount();
-             return 0.0;
+
+        // obj1 is never transformed: when resolutions differ its approximation
+        // at targetResolution is computed on the fly by the cross-resolution
+        // kernel, so no clone is needed.
+        if (currentResolution != targetResolution &&
+            !canTransformResolution(dimension1, currentResolution, targetResolution)) {
+            throw std::runtime_error("Failed to adjust obj1 to target resolution. ObjRes="
+                + std::to_string(currentResolution) + ", TargetRes=" + std::to_string(targetResolution));
+        }
+        // Reaching a finer resolution needs detail coefficients, which a truncated
+        // serialization may not have kept
+        if (currentResolution > targetResolution &&
+            storedSize < approximationSize(dimension1, targetResolution)) {
+            throw std::runtime_error("obj1 does not store the detail coefficients needed for the target resolution.");
         }
 
+        // --- Section 2: Calculate Distance using Approximation Coefficients ---
 
-        // Use double for potentially large sizes or intermediate pow result
-        double powerOfTwo = pow(2.0, static_cast<double>(targetResolution));
-         // Basic checks for pow result
-        if (powerOfTwo <= 0 || !std::isfinite(powerOfTwo)) {
-             throw std::runtime_error("Invalid power calculation for resolution.");
+        if (data2_obj.empty()) {
+            updateDistanceCount(); // Count distance calc even for empty objects? Your choice.
+            return 0.0; // Distance is 0 if objects are empty
         }
-        // Avoid division by zero or near-zero
-        if (powerOfTwo < 1.0) powerOfTwo = 1.0;
-
 
-        // Calculate approximate size, ensuring it doesn't exceed actual vector size due to precision issues
+        // Number of approximation coefficients at the target resolution
         size_t vectorSize = data2_obj.size(); // Use common size
-        size_t approxSize = static_cast<size_t>(static_cast<double>(vectorSize) / powerOfTwo);
-        approxSize = std::min(approxSize, vectorSize); // Ensure not larger than total size
+        size_t approxSize = approximationSize(vectorSize, targetResolution);
 
-
-        if (approxSize == 0 && vectorSize > 0) {
+        if (approxSize == 0) {
              // Resolution might be too high for the data size
              // Log or handle as appropriate. Returning 0 might be misleading.
              // Consider throwing an error if comparison at this level is meaningless.
@@ -146,42 +218,18 @@ public:
         }
 
         // Calculate the Manhattan distance using only the approximation coefficients
-        double sumOfDiff = 0.0;
-        for (size_t i = 0; i < approxSize; ++i) {
-            // Access data using the pointer dereference (*data1_ptr)
-            double diff = (*data1_ptr)[i] - data2_obj[i];
-            sumOfDiff += std::abs(diff); // Use std::abs for double
+        double sumOfDiff;
+        if (currentResolution == targetResolution) {
+            sumOfDiff = boundedManhattanDistance(data1, data2_obj.data(), approxSize, bound);
+        } else {
+            sumOfDiff = crossResolutionManhattan(data1, currentResolution,
+                                                 data2_obj.data(), targetResolution, vectorSize, bound);
         }
 
         updateDistanceCount(); // Update statistics counter from base class
         return sumOfDiff;
     }
 
-
-    /**
-    * Calculates the Euclidean distance between the 'Data' vectors of two objects.
-    * This is the primary distance function.
-    * Uses GetDistance2 internally for calculation.
-    * Throws std::runtime_error if data vectors have different dimensions.
-    *
-    * @param obj1 First TComplexObject.
-    * @param obj2 Second TComplexObject.
-    * @return The Euclidean distance.
-    */
-    virtual double GetDistance(TComplexObject& obj1, TComplexObject& obj2) {
-         // No need to call updateDistanceCount() here if GetDistance2 does it.
-         return GetDistance2(obj1, obj2);
-    }
-
-
-    /**
-     * Provided for compatibility if the original code used getDistance
-     * directly in some places. Delegates to GetDistance.
-     */
-    double getDistance(TComplexObject& obj1, TComplexObject& obj2){
-       return GetDistance(obj1, obj2);
-    }
-
 }; // end class TComplexObjectDistanceEvaluator
 
 #endif // DISTANCE_CALCULATOR_H
\ No newline at end of file
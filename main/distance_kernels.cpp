@@ -0,0 +1,375 @@
+#include "distance_kernels.h"
+
+#include <cmath>    // Para std::abs, std::ldexp
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//---------------------------------------------------------------------------
+// Helpers
+//---------------------------------------------------------------------------
+
+size_t approximationSize(size_t dimension, int resolution) {
+    if (resolution <= 0) {
+        return dimension;
+    }
+    if (resolution >= static_cast<int>(sizeof(size_t) * 8)) {
+        return 0;
+    }
+    return dimension >> resolution;
+}
+
+bool canTransformResolution(size_t dimension, int from, int to) {
+    if (from == to) {
+        return true;
+    }
+    if (dimension == 0 || from < 0 || to < 0) {
+        return false;
+    }
+    if (to > from) {
+        // Compression: every intermediate approximation must be split in pairs
+        for (int level = from; level < to; ++level) {
+            size_t approxSize = approximationSize(dimension, level);
+            if (approxSize <= 1 || approxSize % 2 != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // Decompression: the coarsest approximation must not be empty
+    return approximationSize(dimension, from) > 0;
+}
+
+//---------------------------------------------------------------------------
+// Manhattan kernels
+//---------------------------------------------------------------------------
+// Each kernel keeps several independent accumulators to hide the add
+// latency, uses unaligned loads (coefficients may sit anywhere inside a
+// page) and finishes the tail with scalar code. The absolute value is taken
+// by clearing the sign bit.
+
+typedef double (*ManhattanKernel)(const double*, const double*, size_t);
+
+static double manhattanScalar(const double* a, const double* b, size_t count) {
+    double sumOfDiff = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sumOfDiff += std::abs(a[i] - b[i]);
+    }
+    return sumOfDiff;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+static double manhattanSSE2(const double* a, const double* b, size_t count) {
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128d d0 = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+        __m128d d1 = _mm_sub_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2));
+        acc0 = _mm_add_pd(acc0, _mm_andnot_pd(signMask, d0));
+        acc1 = _mm_add_pd(acc1, _mm_andnot_pd(signMask, d1));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc0);
+    double sumOfDiff = lanes[0] + lanes[1];
+    for (; i < count; ++i) {
+        sumOfDiff += std::abs(a[i] - b[i]);
+    }
+    return sumOfDiff;
+}
+
+__attribute__((target("avx2")))
+static double manhattanAVX2(const double* a, const double* b, size_t count) {
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+        __m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8));
+        __m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12));
+        acc0 = _mm256_add_pd(acc0, _mm256_andnot_pd(signMask, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_andnot_pd(signMask, d1));
+        acc2 = _mm256_add_pd(acc2, _mm256_andnot_pd(signMask, d2));
+        acc3 = _mm256_add_pd(acc3, _mm256_andnot_pd(signMask, d3));
+    }
+    for (; i + 4 <= count; i += 4) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        acc0 = _mm256_add_pd(acc0, _mm256_andnot_pd(signMask, d0));
+    }
+    acc0 = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    double lanes[2];
+    _mm_storeu_pd(lanes, half);
+    double sumOfDiff = lanes[0] + lanes[1];
+    for (; i < count; ++i) {
+        sumOfDiff += std::abs(a[i] - b[i]);
+    }
+    return sumOfDiff;
+}
+
+__attribute__((target("avx512f")))
+static double manhattanAVX512(const double* a, const double* b, size_t count) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+        __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8));
+        acc0 = _mm512_add_pd(acc0, _mm512_abs_pd(d0));
+        acc1 = _mm512_add_pd(acc1, _mm512_abs_pd(d1));
+    }
+    if (i < count) {
+        // Masked loads cover the last (count - i) < 16 elements
+        __mmask8 mask0 = (count - i >= 8) ? __mmask8(0xFF) : __mmask8((1u << (count - i)) - 1);
+        __m512d d0 = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask0, a + i), _mm512_maskz_loadu_pd(mask0, b + i));
+        acc0 = _mm512_add_pd(acc0, _mm512_abs_pd(d0));
+        if (count - i > 8) {
+            __mmask8 mask1 = __mmask8((1u << (count - i - 8)) - 1);
+            __m512d d1 = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask1, a + i + 8), _mm512_maskz_loadu_pd(mask1, b + i + 8));
+            acc1 = _mm512_add_pd(acc1, _mm512_abs_pd(d1));
+        }
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+/**
+* Picks the widest kernel the CPU supports (cpuid via __builtin_cpu_supports).
+*/
+static ManhattanKernel selectManhattanKernel(const char** name) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        *name = "avx512";
+        return manhattanAVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return manhattanAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        *name = "sse2";
+        return manhattanSSE2;
+    }
+    *name = "scalar";
+    return manhattanScalar;
+}
+
+#else
+
+static ManhattanKernel selectManhattanKernel(const char** name) {
+    *name = "scalar";
+    return manhattanScalar;
+}
+
+#endif
+
+static const char* selectedKernelName = "scalar";
+static const ManhattanKernel selectedKernel = selectManhattanKernel(&selectedKernelName);
+
+double manhattanDistance(const double* a, const double* b, size_t count) {
+    return selectedKernel(a, b, count);
+}
+
+double boundedManhattanDistance(const double* a, const double* b, size_t count, double bound) {
+    // Blocks are summed in the same order whatever the bound (even an
+    // infinite one), so the bound test sees the same value as the full sum
+    double sumOfDiff = 0.0;
+    size_t i = 0;
+    while (i < count) {
+        size_t block = (count - i < MANHATTAN_BOUND_BLOCK) ? (count - i) : MANHATTAN_BOUND_BLOCK;
+        sumOfDiff += selectedKernel(a + i, b + i, block);
+        i += block;
+        if (sumOfDiff > bound) {
+            break; // Cannot qualify anymore
+        }
+    }
+    return sumOfDiff;
+}
+
+const char* manhattanKernelName() {
+    return selectedKernelName;
+}
+
+//---------------------------------------------------------------------------
+// Integer Manhattan kernels
+//---------------------------------------------------------------------------
+// Differences and absolute values are taken in 32 bits (inputs are limited
+// to MANHATTAN_INT_LIMIT) and widened to 64-bit lanes before accumulating.
+
+typedef int64_t (*ManhattanInt32Kernel)(const int32_t*, const int32_t*, size_t);
+typedef int64_t (*ManhattanInt16Kernel)(const int16_t*, const int32_t*, size_t);
+
+template <class T>
+static int64_t manhattanIntScalar(const T* a, const int32_t* b, size_t count) {
+    int64_t sumOfDiff = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int32_t diff = static_cast<int32_t>(a[i]) - b[i];
+        sumOfDiff += (diff < 0) ? -diff : diff;
+    }
+    return sumOfDiff;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static inline __m256i accumulateAbsInt32(__m256i acc, __m256i a, __m256i b) {
+    __m256i diff = _mm256_abs_epi32(_mm256_sub_epi32(a, b));
+    acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(diff)));
+    return _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(diff, 1)));
+}
+
+__attribute__((target("avx2")))
+static inline int64_t reduceInt64(__m256i acc) {
+    int64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("avx2")))
+static int64_t manhattanInt32AVX2(const int32_t* a, const int32_t* b, size_t count) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc = accumulateAbsInt32(acc,
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    }
+    return reduceInt64(acc) + manhattanIntScalar(a + i, b + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static int64_t manhattanInt16AVX2(const int16_t* a, const int32_t* b, size_t count) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i wideA = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        acc = accumulateAbsInt32(acc, wideA,
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    }
+    return reduceInt64(acc) + manhattanIntScalar(a + i, b + i, count - i);
+}
+
+static bool cpuHasAVX2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static const bool useIntAVX2 = cpuHasAVX2();
+static const ManhattanInt32Kernel selectedInt32Kernel =
+    useIntAVX2 ? manhattanInt32AVX2 : manhattanIntScalar<int32_t>;
+static const ManhattanInt16Kernel selectedInt16Kernel =
+    useIntAVX2 ? manhattanInt16AVX2 : manhattanIntScalar<int16_t>;
+
+#else
+
+static const ManhattanInt32Kernel selectedInt32Kernel = manhattanIntScalar<int32_t>;
+static const ManhattanInt16Kernel selectedInt16Kernel = manhattanIntScalar<int16_t>;
+
+#endif
+
+template <class T, class Kernel>
+static int64_t boundedManhattanInt(const T* a, const int32_t* b, size_t count, double bound, Kernel kernel) {
+    if (!(bound < std::numeric_limits<double>::infinity())) {
+        return kernel(a, b, count);
+    }
+    int64_t sumOfDiff = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t block = (count - i < MANHATTAN_BOUND_BLOCK) ? (count - i) : MANHATTAN_BOUND_BLOCK;
+        sumOfDiff += kernel(a + i, b + i, block);
+        i += block;
+        if (static_cast<double>(sumOfDiff) > bound) {
+            break; // Cannot qualify anymore
+        }
+    }
+    return sumOfDiff;
+}
+
+int64_t boundedManhattanDistanceInt32(const int32_t* a, const int32_t* b, size_t count, double bound) {
+    return boundedManhattanInt(a, b, count, bound, selectedInt32Kernel);
+}
+
+int64_t boundedManhattanDistanceInt16(const int16_t* a, const int32_t* b, size_t count, double bound) {
+    return boundedManhattanInt(a, b, count, bound, selectedInt16Kernel);
+}
+
+//---------------------------------------------------------------------------
+// Cross-resolution kernel
+//---------------------------------------------------------------------------
+
+/**
+* Sum of 2^levels consecutive values added as a balanced binary tree, the
+* same order repeated pairwise averaging uses. A small stack of partial sums
+* (one per tree level) replaces the temporary buffer.
+*/
+static inline double pairwiseBlockSum(const double* block, int levels) {
+    double partial[sizeof(size_t) * 8];
+    int top = 0;
+    const size_t blockSize = size_t(1) << levels;
+
+    for (size_t k = 0; k < blockSize; ++k) {
+        double value = block[k];
+        // Each trailing 1 bit of k closes one complete subtree
+        for (size_t m = k; m & 1; m >>= 1) {
+            value = partial[--top] + value;
+        }
+        partial[top++] = value;
+    }
+    return partial[0];
+}
+
+double crossResolutionManhattan(const double* data1, int resolution1,
+                                const double* data2, int targetResolution,
+                                size_t dimension, double bound) {
+    const size_t approxSize = approximationSize(dimension, targetResolution);
+    double sumOfDiff = 0.0;
+
+    if (resolution1 < targetResolution) {
+        // data1 is finer: each target coefficient is the mean of a block of
+        // 2^levels approximation coefficients of data1.
+        const int levels = targetResolution - resolution1;
+        const size_t blockSize = size_t(1) << levels;
+        const double scale = std::ldexp(1.0, -levels);
+
+        const double* block = data1;
+        for (size_t j = 0; j < approxSize; ++j, block += blockSize) {
+            double approx = pairwiseBlockSum(block, levels) * scale;
+            sumOfDiff += std::abs(approx - data2[j]);
+            if (sumOfDiff > bound) {
+                break;
+            }
+        }
+    } else {
+        // data1 is coarser: rebuild each target coefficient walking down from
+        // the coarse approximation, adding (even child) or subtracting (odd
+        // child) the detail coefficient of every level in between.
+        const int levels = resolution1 - targetResolution;
+
+        for (size_t j = 0; j < approxSize; ++j) {
+            double approx = data1[j >> levels];
+            for (int level = resolution1; level > targetResolution; --level) {
+                const int shift = level - targetResolution;
+                const size_t parent = j >> shift;
+                const double detail = data1[(dimension >> level) + parent];
+                if (((j >> (shift - 1)) & 1) == 0) {
+                    approx = approx + detail;
+                } else {
+                    approx = approx - detail;
+                }
+            }
+            sumOfDiff += std::abs(approx - data2[j]);
+            if (sumOfDiff > bound) {
+                break;
+            }
+        }
+    }
+    return sumOfDiff;
+}
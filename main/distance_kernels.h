@@ -0,0 +1,111 @@
+#ifndef DISTANCE_KERNELS_H
+#define DISTANCE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+//---------------------------------------------------------------------------
+// Distance kernels over Haar coefficient blocks
+//---------------------------------------------------------------------------
+/**
+* Low level routines shared by TComplexObjectDistanceEvaluator and the
+* sequential scan. They work on raw coefficient pointers laid out as produced
+* by TComplexObject::dataCompression:
+*
+* <CODE>
+* +------------------+--------------+-----+--------------+
+* | Approx (n >> r)  | Detail lvl r | ... | Detail lvl 1 |
+* +------------------+--------------+-----+--------------+
+* </CODE>
+*
+* where the detail block of level l starts at index (n >> l) and has
+* (n >> l) elements. None of these functions allocate memory.
+*/
+
+/**
+* Number of approximation coefficients of a vector of the given dimension at
+* the given resolution (dimension / 2^resolution). Resolutions <= 0 keep the
+* full dimension.
+*/
+size_t approximationSize(size_t dimension, int resolution);
+
+/**
+* Checks if a vector of the given dimension can be moved from resolution
+* 'from' to resolution 'to' by dataCompression, following the same stop
+* rules as TComplexObject::DoCompression/DoDecompression.
+*/
+bool canTransformResolution(size_t dimension, int from, int to);
+
+/**
+* Manhattan distance between the first 'count' elements of a and b.
+* Dispatches to the widest SIMD kernel supported by the running CPU
+* (AVX-512, AVX2, SSE2 or scalar), selected at startup. The SIMD kernels
+* add the differences in several lanes, so for non-integer data the result
+* equals the scalar sum only up to rounding.
+*/
+double manhattanDistance(const double* a, const double* b, size_t count);
+
+/**
+* Early-abandoning Manhattan distance. Accumulates in blocks of
+* MANHATTAN_BOUND_BLOCK elements and stops as soon as the partial sum exceeds
+* 'bound'. The blocks are added in the same order for every bound, so a
+* value <= bound is bit-identical to the one returned with an infinite
+* bound; otherwise it is only guaranteed to be greater than bound. Because
+* of the blocking it equals manhattanDistance() only up to rounding.
+*/
+double boundedManhattanDistance(const double* a, const double* b, size_t count, double bound);
+
+/**
+* Number of elements accumulated between two bound checks.
+*/
+const size_t MANHATTAN_BOUND_BLOCK = 16;
+
+/**
+* Largest magnitude of an integer coefficient accepted by the integer
+* kernels. Differences of two such values always fit an int32_t.
+*/
+const int32_t MANHATTAN_INT_LIMIT = (1 << 30) - 1;
+
+/**
+* Early-abandoning Manhattan distance between integer coefficients (see
+* TComplexObject::SetIntegerCoefficients), with the same block and bound
+* rules as boundedManhattanDistance. Every |value| must be at most
+* MANHATTAN_INT_LIMIT. The sum is exact; callers rescale it once.
+*/
+int64_t boundedManhattanDistanceInt32(const int32_t* a, const int32_t* b, size_t count, double bound);
+
+/**
+* Same as boundedManhattanDistanceInt32 with 'a' stored as int16_t.
+*/
+int64_t boundedManhattanDistanceInt16(const int16_t* a, const int32_t* b, size_t count, double bound);
+
+/**
+* Name of the Manhattan kernel selected for this CPU ("avx512", "avx2",
+* "sse2" or "scalar").
+*/
+const char* manhattanKernelName();
+
+/**
+* Manhattan distance between the approximation coefficients of 'data1'
+* (stored at 'resolution1') and 'data2' (stored at 'targetResolution'),
+* evaluated at 'targetResolution'.
+*
+* The approximation of data1 at the target resolution is computed on the fly
+* from its coefficients: block averages when the target is coarser, and
+* approximation plus signed details when it is finer. Operations are
+* ordered as in dataCompression, so the approximation is bit-identical to
+* that of a transformed clone. The differences are added one by one, so
+* the distance equals manhattanDistance() on the clone up to rounding.
+*
+* Accumulation stops once the partial sum exceeds 'bound', with the same
+* guarantee as boundedManhattanDistance().
+*
+* The caller must check canTransformResolution() first.
+*/
+double crossResolutionManhattan(const double* data1, int resolution1,
+                                const double* data2, int targetResolution,
+                                size_t dimension,
+                                double bound = std::numeric_limits<double>::infinity());
+
+#endif // DISTANCE_KERNELS_H
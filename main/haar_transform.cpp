@@ -0,0 +1,235 @@
+#include "haar_transform.h"
+
+#include <cstring>  // Para memcpy
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//---------------------------------------------------------------------------
+// Level kernels
+//---------------------------------------------------------------------------
+// split: data[0 .. 2*half) holds an approximation block. Writes the means
+//        to data[0 .. half) and the differences to detail[0 .. half).
+// merge: data[0 .. half) holds the approximation and detail[0 .. half) the
+//        differences. Writes the reconstructed block to data[0 .. 2*half).
+//
+// Both work in place on 'data': split walks forward (pair i is read before
+// position i is written and later reads start at 2i), merge walks backward
+// (positions 2i and 2i+1 are written after every approximation below i has
+// been read). Multiplying by 0.5 is exact, so it matches dividing by 2.
+
+typedef void (*HaarSplitKernel)(double* data, double* detail, size_t half);
+typedef void (*HaarMergeKernel)(double* data, const double* detail, size_t half);
+
+static void haarSplitScalar(double* data, double* detail, size_t half) {
+    for (size_t i = 0; i < half; ++i) {
+        double val1 = data[2 * i];
+        double val2 = data[2 * i + 1];
+        data[i] = (val1 + val2) * 0.5;   // Approximation
+        detail[i] = (val1 - val2) * 0.5; // Detail
+    }
+}
+
+static void haarMergeScalar(double* data, const double* detail, size_t half) {
+    for (size_t i = half; i-- > 0;) {
+        double approx = data[i];
+        data[2 * i]     = approx + detail[i];
+        data[2 * i + 1] = approx - detail[i];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static void haarSplitAVX2(double* data, double* detail, size_t half) {
+    const __m256d scale = _mm256_set1_pd(0.5);
+    size_t i = 0;
+    for (; i + 4 <= half; i += 4) {
+        // x0 = [a0 b0 a1 b1], x1 = [a2 b2 a3 b3]
+        __m256d x0 = _mm256_loadu_pd(data + 2 * i);
+        __m256d x1 = _mm256_loadu_pd(data + 2 * i + 4);
+        // hadd/hsub give [p0 p2 p1 p3]; 0xD8 restores [p0 p1 p2 p3]
+        __m256d sum = _mm256_permute4x64_pd(_mm256_hadd_pd(x0, x1), 0xD8);
+        __m256d diff = _mm256_permute4x64_pd(_mm256_hsub_pd(x0, x1), 0xD8);
+        _mm256_storeu_pd(data + i, _mm256_mul_pd(sum, scale));
+        _mm256_storeu_pd(detail + i, _mm256_mul_pd(diff, scale));
+    }
+    for (; i < half; ++i) {
+        double val1 = data[2 * i];
+        double val2 = data[2 * i + 1];
+        data[i] = (val1 + val2) * 0.5;
+        detail[i] = (val1 - val2) * 0.5;
+    }
+}
+
+__attribute__((target("avx2")))
+static void haarMergeAVX2(double* data, const double* detail, size_t half) {
+    // Scalar tail first: the backward walk must finish the highest indices
+    size_t i = half;
+    for (; i % 4 != 0; ) {
+        --i;
+        double approx = data[i];
+        data[2 * i]     = approx + detail[i];
+        data[2 * i + 1] = approx - detail[i];
+    }
+    while (i > 0) {
+        i -= 4;
+        __m256d approx = _mm256_loadu_pd(data + i);
+        __m256d det = _mm256_loadu_pd(detail + i);
+        __m256d even = _mm256_add_pd(approx, det); // [e0 e1 e2 e3]
+        __m256d odd = _mm256_sub_pd(approx, det);  // [o0 o1 o2 o3]
+        __m256d lo = _mm256_unpacklo_pd(even, odd); // [e0 o0 e2 o2]
+        __m256d hi = _mm256_unpackhi_pd(even, odd); // [e1 o1 e3 o3]
+        _mm256_storeu_pd(data + 2 * i, _mm256_permute2f128_pd(lo, hi, 0x20));
+        _mm256_storeu_pd(data + 2 * i + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+    }
+}
+
+static void selectHaarKernels(HaarSplitKernel* split, HaarMergeKernel* merge, const char** name) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *split = haarSplitAVX2;
+        *merge = haarMergeAVX2;
+        *name = "avx2";
+        return;
+    }
+    *split = haarSplitScalar;
+    *merge = haarMergeScalar;
+    *name = "scalar";
+}
+
+#else
+
+static void selectHaarKernels(HaarSplitKernel* split, HaarMergeKernel* merge, const char** name) {
+    *split = haarSplitScalar;
+    *merge = haarMergeScalar;
+    *name = "scalar";
+}
+
+#endif
+
+struct HaarKernels {
+    HaarSplitKernel split;
+    HaarMergeKernel merge;
+    const char* name;
+    HaarKernels() { selectHaarKernels(&split, &merge, &name); }
+};
+
+static const HaarKernels selectedHaarKernels;
+
+/**
+* Scratch block for one level's detail coefficients. It only grows, so
+* repeated transforms of same-sized objects do not allocate.
+*/
+static double* haarScratch(size_t size) {
+    thread_local std::vector<double> scratch;
+    if (scratch.size() < size) {
+        scratch.resize(size);
+    }
+    return scratch.data();
+}
+
+//---------------------------------------------------------------------------
+// Multi-level transforms
+//---------------------------------------------------------------------------
+
+int haarForward(double* data, size_t dimension, int resolution, int levels) {
+    if (data == nullptr || dimension == 0 || resolution < 0) {
+        return resolution;
+    }
+    for (int level = 0; level < levels; ++level) {
+        if (resolution >= static_cast<int>(sizeof(size_t) * 8)) {
+            break;
+        }
+        const size_t approxSize = dimension >> resolution;
+        // Same stop rules as the original compression loop
+        if (approxSize <= 1 || approxSize % 2 != 0) {
+            break;
+        }
+        const size_t half = approxSize / 2;
+        double* detail = haarScratch(half);
+        selectedHaarKernels.split(data, detail, half);
+        memcpy(data + half, detail, half * sizeof(double));
+        resolution++;
+    }
+    return resolution;
+}
+
+int haarInverse(double* data, size_t dimension, int resolution, int levels) {
+    if (data == nullptr || dimension == 0) {
+        return resolution;
+    }
+    for (int level = 0; level < levels && resolution > 0; ++level) {
+        if (resolution >= static_cast<int>(sizeof(size_t) * 8)) {
+            break;
+        }
+        const size_t approxSize = dimension >> resolution;
+        if (approxSize == 0 || approxSize > dimension / 2) {
+            break;
+        }
+        // The details of this level are overwritten by the reconstruction
+        double* detail = haarScratch(approxSize);
+        memcpy(detail, data + approxSize, approxSize * sizeof(double));
+        selectedHaarKernels.merge(data, detail, approxSize);
+        resolution--;
+    }
+    return resolution;
+}
+
+int haarToResolution(double* data, size_t dimension, int resolution, int target) {
+    if (target < 0 || target == resolution || dimension == 0) {
+        return resolution;
+    }
+    return (target > resolution) ? haarForward(data, dimension, resolution, target - resolution)
+                                 : haarInverse(data, dimension, resolution, resolution - target);
+}
+
+//---------------------------------------------------------------------------
+// Approximation pyramid
+//---------------------------------------------------------------------------
+
+int haarPyramidLevels(size_t dimension, int resolution) {
+    if (dimension == 0 || resolution < 0) {
+        return 0;
+    }
+    int levels = 0;
+    for (int level = resolution; level < static_cast<int>(sizeof(size_t) * 8) - 1; ++level) {
+        const size_t approxSize = dimension >> level;
+        if (approxSize <= 1 || approxSize % 2 != 0) {
+            break;
+        }
+        levels++;
+    }
+    return levels;
+}
+
+size_t haarPyramidSize(size_t dimension, int resolution) {
+    return haarPyramidOffset(dimension, resolution, resolution + haarPyramidLevels(dimension, resolution) + 1);
+}
+
+size_t haarPyramidOffset(size_t dimension, int resolution, int target) {
+    size_t offset = 0;
+    for (int level = resolution + 1; level < target; ++level) {
+        offset += dimension >> level;
+    }
+    return offset;
+}
+
+void haarBuildPyramid(const double* approx, size_t dimension, int resolution, double* out) {
+    const int levels = haarPyramidLevels(dimension, resolution);
+    const double* previous = approx;
+    for (int level = resolution + 1; level <= resolution + levels; ++level) {
+        const size_t size = dimension >> level;
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = (previous[2 * i] + previous[2 * i + 1]) * 0.5;
+        }
+        previous = out;
+        out += size;
+    }
+}
+
+const char* haarKernelName() {
+    return selectedHaarKernels.name;
+}
@@ -0,0 +1,82 @@
+#ifndef HAAR_TRANSFORM_H
+#define HAAR_TRANSFORM_H
+
+#include <cstddef>
+
+//---------------------------------------------------------------------------
+// In-place Haar transform
+//---------------------------------------------------------------------------
+/**
+* Multi-level Haar transform used by TComplexObject::dataCompression. The
+* coefficients keep the layout described in distance_kernels.h:
+*
+* <CODE>
+* +------------------+--------------+-----+--------------+
+* | Approx (n >> r)  | Detail lvl r | ... | Detail lvl 1 |
+* +------------------+--------------+-----+--------------+
+* </CODE>
+*
+* Each level only touches the current approximation block: the pairwise
+* means are written over its first half and the differences are staged in
+* a per-thread scratch buffer (half a block, reused across calls) before
+* landing in the second half. Detail levels that are already in place are
+* never copied. Results are bit-identical to the original two-buffer
+* implementation ((x0 + x1) / 2 and (x0 - x1) / 2 per pair).
+*/
+
+/**
+* Applies up to 'levels' forward Haar levels to 'data' (currently at
+* 'resolution'). Stops early, like DoCompression, when the approximation
+* block has one element or an odd number of elements.
+* @return The resolution reached.
+*/
+int haarForward(double* data, size_t dimension, int resolution, int levels);
+
+/**
+* Applies up to 'levels' inverse Haar levels to 'data' (currently at
+* 'resolution'). Stops early, like DoDecompression, at resolution 0 or
+* when the approximation block cannot be doubled inside 'dimension'.
+* @return The resolution reached.
+*/
+int haarInverse(double* data, size_t dimension, int resolution, int levels);
+
+/**
+* Brings 'data' from 'resolution' to 'target' with haarForward or
+* haarInverse. A negative 'target' leaves the data as it is.
+* @return The resolution reached.
+*/
+int haarToResolution(double* data, size_t dimension, int resolution, int target);
+
+/**
+* Number of coarser approximation levels reachable from 'resolution' by
+* haarForward (each one halves an even approximation block of more than
+* one element).
+*/
+int haarPyramidLevels(size_t dimension, int resolution);
+
+/**
+* Number of doubles of the approximation pyramid of an object at
+* 'resolution': the approximation blocks of every coarser reachable level,
+* stored one after the other from resolution + 1 upwards.
+*/
+size_t haarPyramidSize(size_t dimension, int resolution);
+
+/**
+* Position inside the pyramid of the approximation block of 'target'
+* (resolution < target <= resolution + haarPyramidLevels()).
+*/
+size_t haarPyramidOffset(size_t dimension, int resolution, int target);
+
+/**
+* Fills 'out' (haarPyramidSize() doubles) with the pyramid built from the
+* approximation block 'approx' of an object at 'resolution'. Each level is
+* the pairwise mean of the previous one, so it matches haarForward exactly.
+*/
+void haarBuildPyramid(const double* approx, size_t dimension, int resolution, double* out);
+
+/**
+* Name of the level kernel selected for this CPU ("avx2" or "scalar").
+*/
+const char* haarKernelName();
+
+#endif // HAAR_TRANSFORM_H
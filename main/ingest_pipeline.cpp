@@ -0,0 +1,197 @@
+#include "ingest_pipeline.h"
+#include "complex_object.h"
+#include "haar_transform.h"
+#include "spsc_queue.h"
+
+#include <algorithm> // for std::max, std::swap
+#include <cstdio>    // for snprintf
+#include <iostream>
+#include <memory>
+#include <thread>
+
+typedef TSpscQueue<TIngestRecord> TIngestQueue;
+
+//---------------------------------------------------------------------------
+// Class TIngestPipeline
+//---------------------------------------------------------------------------
+
+TIngestPipeline::TIngestPipeline(size_t transformThreads, size_t queueCapacity) :
+    TransformThreads(transformThreads), QueueCapacity(std::max<size_t>(queueCapacity, 2)), TargetResolution(-1),
+    Count(0), NumElements(0), InsertWaitSeconds(0.0) {
+    if (TransformThreads == 0) {
+        // The parser and the insert thread keep one CPU each; with 2 CPUs
+        // or fewer a transform thread would only compete with them, so the
+        // parser transforms the records itself
+        const unsigned cpus = std::thread::hardware_concurrency();
+        TransformThreads = (cpus > 2) ? cpus - 2 : 0;
+    }
+}
+
+size_t TIngestPipeline::GetTransformThreads() const {
+    return (TargetResolution >= 0) ? TransformThreads : 0;
+}
+
+bool TIngestPipeline::Run(const std::string& fileName, const std::function<bool(TComplexObject&)>& insert) {
+    Count = 0;
+    NumElements = 0;
+    InsertWaitSeconds = 0.0;
+    // Without a target resolution, or without transform threads, the
+    // parser hands the records straight to the insert thread
+    const size_t stageThreads = GetTransformThreads();
+    const size_t threads = std::max<size_t>(stageThreads, 1);
+    std::vector<std::unique_ptr<TIngestQueue>> parsed, transformed;
+    for (size_t t = 0; t < threads; ++t) {
+        parsed.emplace_back(new TIngestQueue(QueueCapacity));
+        if (stageThreads > 0) {
+            transformed.emplace_back(new TIngestQueue(QueueCapacity));
+        }
+    }
+    std::vector<std::unique_ptr<TIngestQueue>>& delivered = (stageThreads > 0) ? transformed : parsed;
+    std::vector<size_t> unreached(threads, 0);
+
+    // Parser: record i is parsed into a slot of the queue of transform
+    // thread i % threads (BeginPush returns NULL once cancelled)
+    VectorFileReader reader;
+    bool readOk = true;
+    std::thread parser([&]() {
+        size_t next = 0;
+        size_t missed = 0;
+        readOk = reader.forEachRecord(fileName, [&]() {
+            return parsed[next % threads]->BeginPush();
+        }, [&](TIngestRecord& record) {
+            if (stageThreads == 0 && TargetResolution >= 0) {
+                record.Resolution = haarToResolution(record.Data.data(), record.Data.size(),
+                                                     record.Resolution, TargetResolution);
+                missed += (record.Resolution != TargetResolution) ? 1 : 0;
+            }
+            parsed[next % threads]->EndPush();
+            next++;
+            return true;
+        });
+        if (stageThreads == 0) {
+            unreached[0] = missed;
+        }
+        for (std::unique_ptr<TIngestQueue>& queue : parsed) {
+            queue->Close();
+        }
+    });
+
+    // Transform: the parsed record is swapped into the output slot, so the
+    // buffers circulate between the two queues instead of being copied
+    std::vector<std::thread> transformers;
+    for (size_t t = 0; t < stageThreads; ++t) {
+        transformers.emplace_back([&, t]() {
+            TIngestQueue& in = *parsed[t];
+            TIngestQueue& out = *transformed[t];
+            size_t missed = 0;
+            while (TIngestRecord* record = in.Front()) {
+                TIngestRecord* slot = out.BeginPush();
+                if (slot == nullptr) {
+                    break;
+                }
+                std::swap(*record, *slot);
+                in.Pop();
+                const int resolution = haarToResolution(slot->Data.data(), slot->Data.size(), slot->Resolution,
+                                                        TargetResolution);
+                missed += (TargetResolution >= 0 && resolution != TargetResolution) ? 1 : 0;
+                slot->Resolution = resolution;
+                out.EndPush();
+            }
+            unreached[t] = missed;
+            out.Close();
+        });
+    }
+
+    // Insert: takes the records back in the order they were dealt
+    TComplexObject object;
+    for (size_t i = 0;; ++i) {
+        TIngestQueue& queue = *delivered[i % threads];
+        TIngestRecord* record;
+        if (queue.IsReady()) {
+            record = queue.Front();
+        } else {
+            const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            record = queue.Front();
+            InsertWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+        if (record == nullptr) {
+            break; // Every record was delivered
+        }
+        object.Assign(record->Label, record->Resolution, record->Data.data(), record->Data.size());
+        queue.Pop();
+        Count++;
+        if (!insert(object)) {
+            for (std::unique_ptr<TIngestQueue>& stage : parsed) {
+                stage->Cancel();
+            }
+            for (std::unique_ptr<TIngestQueue>& stage : transformed) {
+                stage->Cancel();
+            }
+            break;
+        }
+    }
+
+    parser.join();
+    for (std::thread& transformer : transformers) {
+        transformer.join();
+    }
+    NumElements = (reader.getNumElements() > 0) ? static_cast<size_t>(reader.getNumElements()) : 0;
+    size_t missed = 0;
+    for (size_t count : unreached) {
+        missed += count;
+    }
+    if (missed > 0) {
+        std::cerr << "Aviso: " << missed << " entrada(s) não puderam ser levadas à resolução " << TargetResolution
+                  << " e ficaram na resolução mais próxima alcançável." << std::endl;
+    }
+    return readOk;
+}
+
+//---------------------------------------------------------------------------
+// Class TIngestProgress
+//---------------------------------------------------------------------------
+
+TIngestProgress::TIngestProgress(std::ostream& out, const std::string& label, double intervalSeconds) :
+    Out(out), Label(label),
+    Interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(intervalSeconds))),
+    Start(std::chrono::steady_clock::now()), LastPrint(Start), Count(0) {
+}
+
+void TIngestProgress::Add(size_t count) {
+    const size_t before = Count;
+    Count += count;
+    // The clock is only read once every 64 objects
+    if (before / 64 != Count / 64) {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - LastPrint >= Interval) {
+            LastPrint = now;
+            Print(false);
+        }
+    }
+}
+
+void TIngestProgress::Finish() {
+    Print(true);
+}
+
+double TIngestProgress::GetElapsedSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+
+void TIngestProgress::Print(bool final) {
+    const double seconds = GetElapsedSeconds();
+    const double rate = (seconds > 0.0) ? Count / seconds : 0.0;
+    char line[160];
+    if (final) {
+        snprintf(line, sizeof(line), "%zu objetos em %.2f s (%.0f obj/s)", Count, seconds, rate);
+    } else {
+        snprintf(line, sizeof(line), "%zu objetos (%.0f obj/s)", Count, rate);
+    }
+    Out << '\r' << Label << line;
+    if (final) {
+        Out << std::endl;
+    } else {
+        Out.flush();
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef INGEST_PIPELINE_H
+#define INGEST_PIPELINE_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+
+#include "VectorFileReader.hpp" // TIngestRecord
+
+class TComplexObject;
+
+//---------------------------------------------------------------------------
+// Class TIngestPipeline
+//---------------------------------------------------------------------------
+/**
+* Reads a dataset file (text or binary, see VectorFileReader) in three
+* stages that run at the same time:
+*
+* <CODE>
+*                  +--> [queue] --> transform 0 --> [queue] --+
+*   parser thread -+--> [queue] --> transform 1 --> [queue] --+--> insert (caller)
+*                  +--> ...                                   +
+* </CODE>
+* The parser thread parses each record straight into a queue slot (see
+* VectorFileReader::forEachRecord) and deals them round-robin to the
+* transform threads, which bring each one to the target resolution with
+* haarToResolution. The calling thread takes the records back in the same
+* round-robin order, so they reach 'insert' in file order, and does
+* nothing but insert them. When the records keep the resolution of the
+* file, or on hosts with 2 CPUs or fewer, there are no transform threads:
+* the parser transforms the records itself (if needed) and queues them
+* straight to the insert thread. Every queue is a bounded TSpscQueue whose
+* records (and their buffers) are recycled, so the memory used does not
+* depend on the size of the file.
+*
+* @version 1.0
+*/
+class TIngestPipeline {
+public:
+    /**
+    * @param transformThreads Transform threads (0 = automatic, from the
+    * number of CPUs; none with 2 CPUs or fewer).
+    * @param queueCapacity Records each queue holds.
+    */
+    explicit TIngestPipeline(size_t transformThreads = 0, size_t queueCapacity = 256);
+
+    /**
+    * Resolution the records are brought to, or -1 (default) to keep the
+    * resolution of the file (see VectorFileReader::setTargetResolution).
+    */
+    void SetTargetResolution(int resolution) { TargetResolution = resolution; }
+
+    /**
+    * Reads 'fileName' and hands every record to 'insert', in file order,
+    * in the same (reused) TComplexObject. 'insert' runs on the calling
+    * thread; returning false stops the reading.
+    * @return false if the file cannot be read or has records of different
+    * sizes (the records before the bad one were already inserted).
+    */
+    bool Run(const std::string& fileName, const std::function<bool(TComplexObject&)>& insert);
+
+    /**
+    * Transform threads Run() starts: 0 when the parser does the transform
+    * or the records keep the resolution of the file.
+    */
+    size_t GetTransformThreads() const;
+
+    /**
+    * Records handed to 'insert' by the last Run().
+    */
+    size_t GetCount() const { return Count; }
+
+    /**
+    * Coefficients per record in the last Run() (0 if there were none).
+    */
+    size_t GetNumElements() const { return NumElements; }
+
+    /**
+    * Seconds the insert thread spent waiting for records in the last Run().
+    * Close to zero when inserting is the slowest stage.
+    */
+    double GetInsertWaitSeconds() const { return InsertWaitSeconds; }
+
+private:
+    size_t TransformThreads;
+    size_t QueueCapacity;
+    int TargetResolution;
+    size_t Count;
+    size_t NumElements;
+    double InsertWaitSeconds;
+};
+
+//---------------------------------------------------------------------------
+// Class TIngestProgress
+//---------------------------------------------------------------------------
+/**
+* Progress line of a load: the number of objects and the throughput,
+* rewritten in place ("\r") at most once per interval.
+*
+* @version 1.0
+*/
+class TIngestProgress {
+public:
+    TIngestProgress(std::ostream& out, const std::string& label, double intervalSeconds = 0.5);
+
+    /**
+    * Counts 'count' more objects and refreshes the line if the interval
+    * has passed.
+    */
+    void Add(size_t count = 1);
+
+    /**
+    * Writes the final line (total, time and throughput) and ends it.
+    */
+    void Finish();
+
+    size_t GetCount() const { return Count; }
+    double GetElapsedSeconds() const;
+
+private:
+    void Print(bool final);
+
+    std::ostream& Out;
+    std::string Label;
+    std::chrono::steady_clock::duration Interval;
+    std::chrono::steady_clock::time_point Start;
+    std::chrono::steady_clock::time_point LastPrint;
+    size_t Count;
+};
+
+#endif // INGEST_PIPELINE_H
@@ -0,0 +1,100 @@
+#include "label_store.h"
+
+#include <stdexcept> // for std::runtime_error, std::out_of_range
+
+//---------------------------------------------------------------------------
+// Class TLabelStore
+//---------------------------------------------------------------------------
+
+bool TLabelStore::Open(const std::string& fileName, bool truncate) {
+    Close();
+
+    std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary;
+    if (truncate) {
+        mode |= std::ios::trunc;
+    }
+    File.open(fileName, mode);
+    if (!File.is_open() && !truncate) {
+        // in|out does not create missing files
+        File.clear();
+        File.open(fileName, mode | std::ios::trunc);
+    }
+    if (!File.is_open()) {
+        return false;
+    }
+
+    // Rebuild the offsets of the existing records
+    File.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(File.tellg());
+    File.seekg(0, std::ios::beg);
+    uint64_t offset = 0;
+    while (offset + sizeof(uint32_t) <= fileSize) {
+        uint32_t length;
+        File.read(reinterpret_cast<char*>(&length), sizeof(uint32_t));
+        if (!File || offset + sizeof(uint32_t) + length > fileSize) {
+            Close();
+            return false; // Truncated record
+        }
+        Offsets.push_back(offset);
+        offset += sizeof(uint32_t) + length;
+        File.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    }
+    if (offset != fileSize) {
+        Close();
+        return false;
+    }
+    EndOffset = offset;
+    return true;
+}
+
+void TLabelStore::Close() {
+    if (File.is_open()) {
+        File.close();
+    }
+    File.clear();
+    Offsets.clear();
+    EndOffset = 0;
+    Dirty = false;
+}
+
+uint32_t TLabelStore::Append(const std::string& label) {
+    if (!File.is_open()) {
+        throw std::runtime_error("Label store is not open.");
+    }
+    if (Offsets.size() >= UINT32_MAX) {
+        throw std::runtime_error("Label store is full.");
+    }
+    const uint32_t length = static_cast<uint32_t>(label.length());
+    File.seekp(static_cast<std::streamoff>(EndOffset), std::ios::beg);
+    File.write(reinterpret_cast<const char*>(&length), sizeof(uint32_t));
+    File.write(label.data(), length);
+    if (!File) {
+        throw std::runtime_error("Failed to append to the label store.");
+    }
+
+    const uint32_t id = static_cast<uint32_t>(Offsets.size());
+    Offsets.push_back(EndOffset);
+    EndOffset += sizeof(uint32_t) + length;
+    Dirty = true;
+    return id;
+}
+
+std::string TLabelStore::GetLabel(uint32_t id) {
+    if (id >= Offsets.size()) {
+        throw std::out_of_range("Unknown object ID in label store.");
+    }
+    if (Dirty) {
+        File.flush();
+        Dirty = false;
+    }
+    uint32_t length;
+    File.seekg(static_cast<std::streamoff>(Offsets[id]), std::ios::beg);
+    File.read(reinterpret_cast<char*>(&length), sizeof(uint32_t));
+    std::string label(length, '\0');
+    File.read(&label[0], length);
+    if (!File) {
+        File.clear();
+        throw std::runtime_error("Failed to read from the label store.");
+    }
+    return label;
+}
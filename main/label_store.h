@@ -0,0 +1,91 @@
+#ifndef LABEL_STORE_H
+#define LABEL_STORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Class TLabelStore
+//---------------------------------------------------------------------------
+/**
+* Append-only side file holding the labels of TComplexObject instances,
+* keyed by a 32-bit object ID.
+*
+* Labels are never used by IsEqual() or by the distance, so index entries
+* only carry the object ID (see TComplexObject::SetObjectID) and the label
+* is read back on demand, typically for the objects of an stResult.
+*
+* The file is a sequence of records:
+* <CODE>
+* +--------------------+-------------+
+* | Label Len (uint32) | Label (str) |
+* +--------------------+-------------+
+* </CODE>
+* The ID of a label is its record number. Only the record offsets are kept
+* in memory; they are rebuilt by scanning the file when an existing store
+* is opened.
+*
+* @version 1.0
+*/
+class TLabelStore {
+public:
+    TLabelStore() {}
+    ~TLabelStore() { Close(); }
+
+    /**
+    * Opens (or creates) the label file. Existing records are kept unless
+    * 'truncate' is true.
+    * @return false if the file cannot be opened or is corrupted.
+    */
+    bool Open(const std::string& fileName, bool truncate = false);
+
+    /**
+    * Flushes and closes the label file.
+    */
+    void Close();
+
+    bool IsOpen() const { return File.is_open(); }
+
+    /**
+    * Appends a label and returns its object ID.
+    * Throws std::runtime_error if the store is closed or full.
+    */
+    uint32_t Append(const std::string& label);
+
+    /**
+    * Reads the label of the given object ID from the file.
+    * Throws std::out_of_range for unknown IDs.
+    */
+    std::string GetLabel(uint32_t id);
+
+    /**
+    * Number of labels in the store.
+    */
+    size_t GetCount() const { return Offsets.size(); }
+
+private:
+    std::fstream File;
+
+    /**
+    * File offset of each record, indexed by object ID.
+    */
+    std::vector<uint64_t> Offsets;
+
+    /**
+    * Offset where the next record is written.
+    */
+    uint64_t EndOffset = 0;
+
+    /**
+    * True if records were appended since the last read (the stream must be
+    * flushed before reading them back).
+    */
+    bool Dirty = false;
+
+    TLabelStore(const TLabelStore&) = delete;
+    TLabelStore& operator=(const TLabelStore&) = delete;
+};
+
+#endif // LABEL_STORE_H
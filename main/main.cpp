@@ -7,6 +7,9 @@
 #pragma hdrstop
 #include "app.h"
 #include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
 
 #pragma argsused
 
@@ -14,23 +17,112 @@ extern std::string dataset_file_var;     // Arquivo com o dataset principal
 extern std::string query_file_var;    // Arquivo com os objetos de consulta
 extern double range_query_var;
 extern int disk_page_size;
+extern bool inline_labels_var;
+extern bool print_labels_var;
+extern bool pyramid_var;
+extern bool cold_cache_var;
+extern int dataset_resolution_var;
+extern int query_resolution_var;
+extern int ingest_threads_var;
 
 int main(int argc, char* argv[]){
-  
-   if (argc >= 2) range_query_var = std::stod(argv[1]); // Converte string para double
-   if (argc >= 3) dataset_file_var = argv[2];
-   if (argc >= 4) query_file_var = argv[3];
-   if (argc >= 5) disk_page_size = std::stoi(argv[4]);
 
+   // Argumentos posicionais: [raio] [dataset] [consultas] [tamanho da página]
+   // Opções "--nome valor" podem aparecer em qualquer posição:
+   //   --detail-levels N : grava só a aproximação + N níveis de detalhe
+   //   --serial-format V : formato dos objetos nas páginas, 1 ou 2 (padrão)
+   //   --coefficients C  : 'double' (padrão) ou 'int' (inteiros escalados, sem perda)
+   //   --inline-labels   : mantém os labels nas entradas da árvore
+   //   --print-labels    : imprime os labels dos objetos retornados
+   //   --pyramid         : grava a pirâmide de aproximações em cada entrada
+   //   --cache C         : 'warm' (padrão) ou 'cold' (arquivo da árvore fora do
+   //                       cache de páginas no início de cada consulta)
+   //   --results R       : 'full' (padrão, objetos completos no resultado) ou
+   //                       'ids' (só ID/label e distância de cada objeto)
+   //   --resolution R    : leva os objetos do dataset à resolução R ao ler o
+   //                       arquivo (um único arquivo na resolução 0 serve a todas)
+   //   --query-resolution R : o mesmo para os objetos de consulta
+   //   --ingest-threads N : threads que aplicam a transformada na carga do
+   //                        dataset (0 = automático, conforme as CPUs)
+   int positional = 0;
+   try {
+      for (int i = 1; i < argc; i++) {
+         std::string arg = argv[i];
+         if (arg == "--inline-labels") {
+            inline_labels_var = true;
+            continue;
+         }
+         if (arg == "--print-labels") {
+            print_labels_var = true;
+            continue;
+         }
+         if (arg == "--pyramid") {
+            pyramid_var = true;
+            continue;
+         }
+         if (arg.rfind("--", 0) == 0) {
+            std::string value = (i + 1 < argc) ? argv[++i] : "";
+            if (arg == "--detail-levels") {
+               TComplexObject::SetStoredDetailLevels(std::stoi(value));
+            } else if (arg == "--coefficients") {
+               if (value != "double" && value != "int") {
+                  std::cerr << "ERRO: --coefficients deve ser 'double' ou 'int'." << std::endl;
+                  return 1;
+               }
+               TComplexObject::SetIntegerCoefficients(value == "int");
+            } else if (arg == "--serial-format") {
+               const int serialFormat = std::stoi(value);
+               try {
+                  TComplexObject::SetSerialFormat(serialFormat);
+               } catch (const std::invalid_argument& e) {
+                  std::cerr << "ERRO: --serial-format deve ser 1 ou 2." << std::endl;
+                  return 1;
+               }
+            } else if (arg == "--cache") {
+               if (value != "warm" && value != "cold") {
+                  std::cerr << "ERRO: --cache deve ser 'warm' ou 'cold'." << std::endl;
+                  return 1;
+               }
+               cold_cache_var = (value == "cold");
+            } else if (arg == "--results") {
+               if (value != "full" && value != "ids") {
+                  std::cerr << "ERRO: --results deve ser 'full' ou 'ids'." << std::endl;
+                  return 1;
+               }
+               TComplexObject::SetResultIDsOnly(value == "ids");
+            } else if (arg == "--resolution") {
+               dataset_resolution_var = std::stoi(value);
+            } else if (arg == "--query-resolution") {
+               query_resolution_var = std::stoi(value);
+            } else if (arg == "--ingest-threads") {
+               ingest_threads_var = std::stoi(value);
+            } else {
+               std::cerr << "AVISO: Opção desconhecida ignorada: " << arg << std::endl;
+            }
+            continue;
+         }
+         positional++;
+         if (positional == 1) range_query_var = std::stod(arg); // Converte string para double
+         if (positional == 2) dataset_file_var = arg;
+         if (positional == 3) query_file_var = arg;
+         if (positional == 4) disk_page_size = std::stoi(arg);
+      }
+   } catch (const std::invalid_argument& e) {
+      std::cerr << "ERRO: Argumento inválido. Verifique se as opções numéricas e o raio são números." << std::endl;
+      return 1;
+   } catch (const std::out_of_range& e) {
+      std::cerr << "ERRO: Argumento fora do intervalo válido." << std::endl;
+      return 1;
+   }
 
    TApp app;                                         
 
    // Init application.
    app.Init();
    // Run it.
-   app.Run();
+   const bool ok = app.Run();
    // Release resources.
    app.Done();
 
-   return 0;
+   return ok ? 0 : 1;
 }//end main
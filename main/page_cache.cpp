@@ -0,0 +1,16 @@
+#include "page_cache.h"
+
+#include <fcntl.h>  // for open, posix_fadvise
+#include <unistd.h> // for fdatasync, close
+
+bool evictFileFromPageCache(const std::string& fileName) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // Dirty pages cannot be dropped: write them back first
+    fdatasync(fd);
+    const bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+}
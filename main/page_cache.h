@@ -0,0 +1,13 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <string>
+
+/**
+* Writes back and drops the cached pages of 'fileName' from the operating
+* system page cache, so the next reads come from the device (cold cache).
+* @return false if the file cannot be opened or the hint is not supported.
+*/
+bool evictFileFromPageCache(const std::string& fileName);
+
+#endif // PAGE_CACHE_H
@@ -0,0 +1,113 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+* One result of a query: the object ID (TComplexObject::NO_OBJECT_ID when
+* the object has none) and its distance to the query.
+*/
+struct TResultPair {
+    uint32_t ObjectID;
+    double Distance;
+
+    /**
+    * Orders by distance, then by ID, so equal distances always come out
+    * in the same order.
+    */
+    bool operator<(const TResultPair& other) const {
+        return (Distance != other.Distance) ? Distance < other.Distance : ObjectID < other.ObjectID;
+    }
+};
+
+//---------------------------------------------------------------------------
+// Class TResultSink
+//---------------------------------------------------------------------------
+/**
+* Receives the results of one query of the sequential scan. The scan never
+* copies the objects it finds: it only hands their IDs and distances to
+* the sink, which decides what to keep.
+*
+* @version 1.0
+*/
+class TResultSink {
+public:
+    virtual ~TResultSink() {}
+
+    /**
+    * Receives one result.
+    */
+    virtual void Add(uint32_t objectID, double distance) = 0;
+
+    /**
+    * Number of results received.
+    */
+    virtual size_t GetCount() const = 0;
+
+    /**
+    * Creates an empty sink of the same kind, used by a worker thread to
+    * collect its part of the results.
+    */
+    virtual std::unique_ptr<TResultSink> CreateEmpty() const = 0;
+
+    /**
+    * Appends the results of 'other', a sink created by CreateEmpty().
+    */
+    virtual void Merge(const TResultSink& other) = 0;
+};
+
+//---------------------------------------------------------------------------
+// Class TCountResultSink
+//---------------------------------------------------------------------------
+/**
+* Only counts the results.
+*
+* @version 1.0
+*/
+class TCountResultSink : public TResultSink {
+public:
+    TCountResultSink() : Count(0) {}
+
+    void Add(uint32_t, double) override { Count++; }
+    size_t GetCount() const override { return Count; }
+    std::unique_ptr<TResultSink> CreateEmpty() const override {
+        return std::unique_ptr<TResultSink>(new TCountResultSink());
+    }
+    void Merge(const TResultSink& other) override { Count += other.GetCount(); }
+
+private:
+    size_t Count;
+};
+
+//---------------------------------------------------------------------------
+// Class TPairResultSink
+//---------------------------------------------------------------------------
+/**
+* Keeps the (object ID, distance) pairs in the order they are received.
+*
+* @version 1.0
+*/
+class TPairResultSink : public TResultSink {
+public:
+    void Add(uint32_t objectID, double distance) override {
+        Pairs.push_back(TResultPair{objectID, distance});
+    }
+    size_t GetCount() const override { return Pairs.size(); }
+    std::unique_ptr<TResultSink> CreateEmpty() const override {
+        return std::unique_ptr<TResultSink>(new TPairResultSink());
+    }
+    void Merge(const TResultSink& other) override {
+        const TPairResultSink& pairs = static_cast<const TPairResultSink&>(other);
+        Pairs.insert(Pairs.end(), pairs.Pairs.begin(), pairs.Pairs.end());
+    }
+
+    const std::vector<TResultPair>& GetPairs() const { return Pairs; }
+
+private:
+    std::vector<TResultPair> Pairs;
+};
+
+#endif // RESULT_SINK_H
@@ -0,0 +1,1024 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>   // For memcpy, memset
+#include <cmath>     // For std::ldexp
+#include <stdexcept> // For exceptions
+#include <algorithm> // For std::min, std::sort
+#include <thread>    // For std::thread
+#include <fcntl.h>     // For open
+#include <sys/mman.h>  // For mmap, madvise
+#include <sys/stat.h>  // For fstat
+#include <unistd.h>    // For close
+
+#include "scan_search.h"
+#include "distance_kernels.h"   // Manhattan and cross-resolution kernels
+#include "label_store.h"        // Labels kept outside the pages
+#include "haar_transform.h"     // Query approximations for the zone maps
+#include "coarse_tier.h"        // Coarse copy of the dataset for pre-filtering
+#include "ingest_pipeline.h"    // Parse/transform stages of the dataset load
+
+using namespace std;
+
+static double calculateDistanceToCoefficients(TComplexObject& obj1, const double* data2, int targetResolution,
+                                              size_t vectorSize, long long& distanceCounter, double bound);
+
+//---------------------------------------------------------------------------
+// Função de Cálculo de Distância (Integrada)
+// Baseada na lógica de TComplexObjectDistanceEvaluator::GetDistance2
+//---------------------------------------------------------------------------
+double calculateComplexObjectDistance(TComplexObject& obj1, TComplexObject& obj2, long long& distanceCounter,
+                                      double bound) {
+    return calculateDistanceToCoefficients(obj1, obj2.GetData().data(), obj2.GetResolution(),
+                                           obj2.GetData().size(), distanceCounter, bound);
+}
+
+double calculateComplexObjectDistance(TComplexObject& obj1, const TComplexObjectView& obj2,
+                                      long long& distanceCounter,
+                                      double bound) {
+    const int targetResolution = obj2.GetResolution();
+    const size_t vectorSize = obj2.GetDimension();
+    const bool aligned = obj2.HasAlignedCoefficients();
+    if (aligned && obj2.GetCoefficientEncoding() == TComplexObject::COEFFICIENTS_DOUBLE) {
+        return calculateDistanceToCoefficients(obj1, obj2.GetCoefficients(), targetResolution,
+                                               vectorSize, distanceCounter, bound);
+    }
+
+    // Soma inteira exata dos coeficientes escalados, reescalada uma única vez
+    const size_t approxSize = approximationSize(vectorSize, targetResolution);
+    if (aligned && obj1.GetResolution() == targetResolution && obj1.GetData().size() == vectorSize && approxSize > 0) {
+        const int32_t* query = obj1.GetScaledApproximation();
+        if (query != nullptr) {
+            const double scaledBound = std::ldexp(bound, targetResolution);
+            int64_t sumOfDiff = (obj2.GetCoefficientEncoding() == TComplexObject::COEFFICIENTS_INT16) ?
+                boundedManhattanDistanceInt16(obj2.GetInt16Coefficients(), query, approxSize, scaledBound) :
+                boundedManhattanDistanceInt32(obj2.GetInt32Coefficients(), query, approxSize, scaledBound);
+            distanceCounter++;
+            return std::ldexp(static_cast<double>(sumOfDiff), -targetResolution);
+        }
+    }
+
+    // Somente a aproximação de obj2 entra na distância
+    thread_local vector<double> decoded;
+    decoded.resize(std::min(approxSize, obj2.GetStoredSize()));
+    obj2.DecodeCoefficients(decoded.data(), decoded.size());
+    return calculateDistanceToCoefficients(obj1, decoded.data(), targetResolution,
+                                           vectorSize, distanceCounter, bound);
+}
+
+/**
+ * @brief Núcleo de calculateComplexObjectDistance: compara obj1 com um
+ * segundo objeto dado pelos seus coeficientes, na resolução dele.
+ *
+ * @param obj1 Primeiro TComplexObject.
+ * @param data2 Coeficientes do segundo objeto (ao menos o bloco de aproximação).
+ * @param targetResolution Resolução do segundo objeto.
+ * @param vectorSize Número total de coeficientes do segundo objeto.
+ * @param[in, out] distanceCounter Contador de cálculos de distância.
+ * @param bound Limite de abandono antecipado.
+ */
+static double calculateDistanceToCoefficients(TComplexObject& obj1, const double* data2, int targetResolution,
+                                              size_t vectorSize, long long& distanceCounter, double bound) {
+
+    // --- Seção 1: Validar Tamanhos e Diferenças de Resolução ---
+
+    const int currentResolution = obj1.GetResolution();
+    const std::vector<double>& data1_obj = obj1.GetData();
+
+    if (data1_obj.size() != vectorSize) {
+        throw std::runtime_error("Objetos têm tamanhos de dados subjacentes diferentes, não podem ser comparados.");
+    }
+
+    // obj1 nunca é transformado: o kernel de resolução cruzada calcula sua
+    // aproximação na resolução alvo durante a soma.
+    if (currentResolution != targetResolution &&
+        !canTransformResolution(data1_obj.size(), currentResolution, targetResolution)) {
+        throw std::runtime_error("Falha ao ajustar obj1 para resolução alvo. ObjRes="
+            + std::to_string(currentResolution) + ", TargetRes=" + std::to_string(targetResolution));
+    }
+    // Atingir uma resolução mais fina exige coeficientes de detalhe, que uma
+    // serialização truncada pode não ter mantido
+    if (currentResolution > targetResolution &&
+        obj1.GetStoredSize() < approximationSize(data1_obj.size(), targetResolution)) {
+        throw std::runtime_error("obj1 não armazena os coeficientes de detalhe necessários para a resolução alvo.");
+    }
+
+    // --- Seção 2: Calcular Distância usando Coeficientes de Aproximação ---
+
+    if (vectorSize == 0) {
+         distanceCounter++; // Conta o cálculo de distância
+         return 0.0; // Distância é 0 se os objetos estiverem vazios
+    }
+
+    // Calcula o número de coeficientes de aproximação na resolução alvo
+    size_t approxSize = approximationSize(vectorSize, targetResolution);
+
+    if (approxSize == 0) {
+         // Resolução pode ser muito alta para o tamanho dos dados
+         std::cerr << "Aviso: Resolução " << targetResolution
+                   << " resulta em zero coeficientes de aproximação para tamanho "
+                   << vectorSize << std::endl;
+         distanceCounter++; // Conta o cálculo de distância
+         return 0.0; // Ou lançar std::runtime_error("Não é possível comparar neste nível de resolução.");
+    }
+
+    // Calcula a distância Manhattan usando apenas os coeficientes de aproximação
+    double sumOfDiff;
+    if (currentResolution == targetResolution) {
+        sumOfDiff = boundedManhattanDistance(data1_obj.data(), data2, approxSize, bound);
+    } else {
+        sumOfDiff = crossResolutionManhattan(data1_obj.data(), currentResolution,
+                                             data2, targetResolution, vectorSize, bound);
+    }
+
+    distanceCounter++; // Atualiza o contador de distância
+    return sumOfDiff;
+}
+
+void sequentialRangeSearch(
+    vector<TComplexObject>& dataset, // Non-const because distance func needs it
+    TComplexObject& queryObject,     // Non-const because distance func needs it
+    double radius,
+    TResultSink& sink,
+    long long& distanceCounter)      // Pass counter by reference
+{
+    for (TComplexObject& dataObject : dataset) {
+        try {
+            // Calculate distance using the integrated function, abandoning
+            // it as soon as it exceeds the radius
+            double distance = calculateComplexObjectDistance(queryObject, dataObject, distanceCounter, radius);
+
+            // Check if the object is within the specified radius
+            if (distance <= radius) {
+                sink.Add(dataObject.GetObjectID(), distance);
+            }
+        } catch (const std::exception& e) {
+            // Log error during distance calculation for a specific pair
+            cerr << "ERRO no cálculo de distância entre Query(" << queryObject.GetLabel()
+                 << ") e Data(" << dataObject.GetLabel() << "): " << e.what() << endl;
+            // Continue searching with the next object in the dataset
+        }
+    }
+}
+
+vector<PageZone> loadPageZones(const string& dataFile, size_t pageSize) {
+    vector<PageZone> zones;
+    ifstream inFile(dataFile, ios::binary);
+    if (!inFile) {
+        return zones;
+    }
+    vector<uint8_t> pageBuffer(pageSize);
+    while (inFile.read(reinterpret_cast<char*>(pageBuffer.data()), pageSize)) {
+        if (!TSlottedPageView::IsSlottedPage(pageBuffer.data(), pageSize)) {
+            zones.clear();
+            break;
+        }
+        PageZone zone;
+        try {
+            TSlottedPageView page(pageBuffer.data(), pageSize);
+            zone.resolution = page.GetZoneResolution();
+            if (zone.resolution != SLOTTED_PAGE_NO_ZONE) {
+                zone.minimum.assign(page.GetZoneMin(), page.GetZoneMin() + page.GetZoneCount());
+                zone.maximum.assign(page.GetZoneMax(), page.GetZoneMax() + page.GetZoneCount());
+            }
+        } catch (const std::exception& e) {
+            zone.resolution = SLOTTED_PAGE_NO_ZONE; // Never skipped
+        }
+        zones.push_back(std::move(zone));
+    }
+    return zones;
+}
+
+/**
+ * @brief Approximation block of 'query' at 'resolution', computed with the
+ * Haar transform from the query coefficients (the query is not changed).
+ * @param[out] coefficients The transformed coefficients; the approximation
+ * block is its first approximationSize(dimension, resolution) values.
+ * @return false if 'resolution' cannot be reached.
+ */
+static bool queryAtResolution(TComplexObject& query, int resolution, vector<double>& coefficients) {
+    coefficients = query.GetData();
+    const size_t dimension = coefficients.size();
+    const int current = query.GetResolution();
+    int reached = current;
+    if (resolution > current) {
+        reached = haarForward(coefficients.data(), dimension, current, resolution - current);
+    } else if (resolution < current && query.GetStoredSize() == dimension) {
+        reached = haarInverse(coefficients.data(), dimension, current, current - resolution);
+    }
+    return reached == resolution;
+}
+
+/**
+ * @brief Approximation of a query at the resolution of a zone map. The
+ * distance compares the query at the resolution of each entry, so pages
+ * written at another resolution need the query transformed first; the last
+ * transformation is kept since every page usually shares one resolution.
+ */
+struct ZoneQuery {
+    int resolution = SLOTTED_PAGE_NO_ZONE;
+    bool valid = false;
+    vector<double> coefficients;
+};
+
+/**
+ * @brief Checks if the zone map proves that no object of the page is within
+ * 'radius' of 'query': the L1 distance between the query approximation and
+ * the page box is a lower bound of the distance to every object of the page.
+ */
+static bool pageCannotMatch(const PageZone& zone, TComplexObject& query, double radius, ZoneQuery& zoneQuery) {
+    if (zone.resolution == SLOTTED_PAGE_NO_ZONE) {
+        return false;
+    }
+    if (zoneQuery.resolution != zone.resolution) {
+        zoneQuery.resolution = zone.resolution;
+        zoneQuery.valid = queryAtResolution(query, zone.resolution, zoneQuery.coefficients) &&
+                          approximationSize(zoneQuery.coefficients.size(), zone.resolution) >= zone.minimum.size();
+    }
+    if (!zoneQuery.valid) {
+        return false;
+    }
+    return zoneLowerBound(zone.minimum.data(), zone.maximum.data(), zoneQuery.coefficients.data(),
+                          zone.minimum.size()) > radius;
+}
+
+/**
+ * @brief Visits every object of [firstPage, firstPage + pageLimit) with the
+ * reader selected in 'reader'. 'evaluate' is called as
+ * evaluate(dataObject, dataLabel), where dataObject is a TComplexObject or
+ * a TComplexObjectView and dataLabel() returns its label (for messages).
+ */
+template <class Evaluate>
+static void scanPagedFile(const string& dataFile, size_t pageSize, int& pagesRead, const PageReaderOptions& reader,
+                   size_t firstPage, size_t pageLimit, const function<bool(size_t)>& acceptPage,
+                   const function<bool(size_t)>& pageNeeded, Evaluate& evaluate)
+{
+    auto evaluateView = [&](const TComplexObjectView& dataView) {
+        evaluate(dataView, [&dataView]() { return string(dataView.GetLabelData(), dataView.GetLabelLength()); });
+    };
+    if (reader.mode == PageReaderOptions::READER_MMAP) {
+        forEachObjectViewInMappedFile(dataFile, pageSize, pagesRead, evaluateView, firstPage, pageLimit, acceptPage);
+    } else if (reader.mode == PageReaderOptions::READER_ASYNC) {
+        forEachObjectViewInAsyncFile(dataFile, pageSize, pagesRead, evaluateView, reader,
+                                     firstPage, pageLimit, acceptPage, pageNeeded);
+    } else {
+        forEachObjectInPagedFile(dataFile, pageSize, pagesRead, [&](TComplexObject& dataObject) {
+            evaluate(dataObject, [&dataObject]() { return dataObject.GetLabel(); });
+        }, firstPage, pageLimit, acceptPage);
+    }
+}
+
+size_t runOnPageRanges(const string& dataFile, size_t pageSize, size_t threadCount,
+                       const function<void(size_t, size_t, size_t)>& work)
+{
+    struct stat fileInfo;
+    if (stat(dataFile.c_str(), &fileInfo) != 0) {
+        return 0;
+    }
+    const size_t pageCount = (static_cast<size_t>(fileInfo.st_size) + pageSize - 1) / pageSize;
+    threadCount = std::max<size_t>(1, std::min(threadCount, pageCount));
+    vector<std::thread> workers;
+    for (size_t w = 0; w < threadCount; ++w) {
+        const size_t firstPage = pageCount * w / threadCount;
+        const size_t lastPage = pageCount * (w + 1) / threadCount;
+        workers.emplace_back([&work, w, firstPage, lastPage]() {
+            work(w, firstPage, lastPage - firstPage);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return threadCount;
+}
+
+void batchedRangeSearch(const string& dataFile, size_t pageSize,
+                        vector<TComplexObject*>& queries, double radius, vector<TResultSink*>& sinks,
+                        long long& distanceCounter, int& pagesRead, const PageReaderOptions& reader,
+                        size_t firstPage, size_t pageLimit, const vector<PageZone>* zones)
+{
+    vector<char> active(queries.size(), 1); // Queries that examine the current page
+    vector<ZoneQuery> zoneQueries(queries.size());
+    int queryPageAccesses = 0;
+    auto acceptPage = [&](size_t page) {
+        size_t activeCount = queries.size();
+        if (zones != nullptr && page < zones->size()) {
+            activeCount = 0;
+            for (size_t q = 0; q < queries.size(); ++q) {
+                active[q] = !pageCannotMatch((*zones)[page], *queries[q], radius, zoneQueries[q]);
+                activeCount += active[q];
+            }
+        }
+        queryPageAccesses += static_cast<int>(activeCount);
+        return activeCount > 0;
+    };
+    // Same decision as acceptPage without updating the state of the current
+    // page: the asynchronous reader asks it before submitting each read
+    auto pageNeeded = [&](size_t page) {
+        if (zones == nullptr || page >= zones->size()) {
+            return true;
+        }
+        for (size_t q = 0; q < queries.size(); ++q) {
+            if (!pageCannotMatch((*zones)[page], *queries[q], radius, zoneQueries[q])) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto evaluate = [&](auto& dataObject, const auto& dataLabel) {
+        for (size_t q = 0; q < queries.size(); ++q) {
+            if (!active[q]) {
+                continue;
+            }
+            try {
+                double distance = calculateComplexObjectDistance(*queries[q], dataObject, distanceCounter, radius);
+                if (distance <= radius) {
+                    sinks[q]->Add(dataObject.GetObjectID(), distance);
+                }
+            } catch (const std::exception& e) {
+                cerr << "ERRO no cálculo de distância entre Query(" << queries[q]->GetLabel()
+                     << ") e Data(" << dataLabel() << "): " << e.what() << endl;
+            }
+        }
+    };
+    scanPagedFile(dataFile, pageSize, pagesRead, reader, firstPage, pageLimit, acceptPage, pageNeeded, evaluate);
+    pagesRead = queryPageAccesses;
+}
+
+void parallelRangeSearch(const string& dataFile, size_t pageSize,
+                         vector<TComplexObject*>& queries, double radius, vector<TResultSink*>& sinks,
+                         long long& distanceCounter, int& pagesRead, const PageReaderOptions& reader,
+                         size_t threadCount, const vector<PageZone>* zones)
+{
+    struct WorkerResult {
+        unique_ptr<PartialSinks> sinks;
+        long long distanceCount = 0;
+        int pagesRead = 0;
+    };
+    // The scaled approximation is cached on first use: build it before the
+    // workers share the queries
+    for (TComplexObject* query : queries) {
+        query->GetScaledApproximation();
+    }
+    vector<WorkerResult> results(std::max<size_t>(threadCount, 1));
+    const size_t workerCount = (threadCount <= 1) ? 0 :
+        runOnPageRanges(dataFile, pageSize, threadCount, [&](size_t w, size_t firstPage, size_t pageCount) {
+            WorkerResult& result = results[w];
+            result.sinks.reset(new PartialSinks(sinks));
+            batchedRangeSearch(dataFile, pageSize, queries, radius, result.sinks->sinks,
+                               result.distanceCount, result.pagesRead, reader, firstPage, pageCount, zones);
+        });
+    if (workerCount == 0) {
+        batchedRangeSearch(dataFile, pageSize, queries, radius, sinks, distanceCounter, pagesRead, reader,
+                           0, SIZE_MAX, zones);
+        return;
+    }
+    results.resize(workerCount);
+
+    pagesRead = 0;
+    for (const WorkerResult& result : results) {
+        result.sinks->mergeInto(sinks);
+        distanceCounter += result.distanceCount;
+        pagesRead += result.pagesRead;
+    }
+}
+
+/**
+ * @brief Object of the paged file that survived the coarse filter for one
+ * query of the group.
+ */
+struct TierCandidate {
+    size_t slot;
+    size_t query;
+
+    bool operator<(const TierCandidate& other) const {
+        return (slot != other.slot) ? slot < other.slot : query < other.query;
+    }
+};
+
+/**
+ * @brief Refinement step of tieredRangeSearch: reads the pages in
+ * [firstPage, firstPage + pageLimit) that hold candidates and computes the
+ * full distance only for them.
+ * @param candidates Candidates of each page, sorted by slot.
+ * @param sinks Receive the results of each query.
+ */
+static void refineTierCandidates(const string& dataFile, size_t pageSize,
+                          vector<TComplexObject*>& queries, double radius,
+                          const vector<vector<TierCandidate>>& candidates, vector<TResultSink*>& sinks,
+                          long long& distanceCounter, const PageReaderOptions& reader,
+                          size_t firstPage, size_t pageLimit)
+{
+    const vector<TierCandidate>* pageCandidates = nullptr;
+    size_t slot = 0;
+    size_t next = 0; // First candidate of the current page not yet refined
+    auto pageNeeded = [&](size_t page) {
+        return page < candidates.size() && !candidates[page].empty();
+    };
+    auto acceptPage = [&](size_t page) {
+        if (!pageNeeded(page)) {
+            return false;
+        }
+        pageCandidates = &candidates[page];
+        slot = 0;
+        next = 0;
+        return true;
+    };
+    auto evaluate = [&](auto& dataObject, const auto& dataLabel) {
+        for (; next < pageCandidates->size() && (*pageCandidates)[next].slot == slot; ++next) {
+            const size_t q = (*pageCandidates)[next].query;
+            try {
+                double distance = calculateComplexObjectDistance(*queries[q], dataObject, distanceCounter, radius);
+                if (distance <= radius) {
+                    sinks[q]->Add(dataObject.GetObjectID(), distance);
+                }
+            } catch (const std::exception& e) {
+                cerr << "ERRO no cálculo de distância entre Query(" << queries[q]->GetLabel()
+                     << ") e Data(" << dataLabel() << "): " << e.what() << endl;
+            }
+        }
+        slot++;
+    };
+    int pagesRead = 0;
+    scanPagedFile(dataFile, pageSize, pagesRead, reader, firstPage, pageLimit, acceptPage, pageNeeded, evaluate);
+}
+
+void tieredRangeSearch(const string& dataFile, const TCoarseTier& tier, size_t pageSize,
+                       vector<TComplexObject*>& queries, double radius, vector<TResultSink*>& sinks,
+                       long long& distanceCounter, long long& coarseCounter, int& pagesRead,
+                       const PageReaderOptions& reader, size_t threadCount)
+{
+    // --- Coarse filter ---
+    vector<vector<TierCandidate>> candidates(tier.GetPageCount());
+    const size_t tierPages = (tier.GetFileSize() + pageSize - 1) / pageSize;
+    pagesRead = 0;
+    for (size_t q = 0; q < queries.size(); ++q) {
+        // The query at each coarse level used by the tier (usually one)
+        vector<vector<double>> queryLevels;
+        vector<char> levelReady;
+        size_t lastPage = SIZE_MAX;
+        for (size_t entry = 0; entry < tier.GetCount(); ++entry) {
+            const int level = tier.GetLevel(entry);
+            const double* queryCoarse = nullptr;
+            if (level >= 0) {
+                if (static_cast<size_t>(level) >= queryLevels.size()) {
+                    queryLevels.resize(level + 1);
+                    levelReady.resize(level + 1, 0);
+                }
+                if (!levelReady[level]) {
+                    levelReady[level] = queryAtResolution(*queries[q], level, queryLevels[level]) ? 1 : 2;
+                }
+                if (levelReady[level] == 1) {
+                    queryCoarse = queryLevels[level].data();
+                }
+            }
+            coarseCounter++;
+            // Without the query at that level the record cannot prune
+            if (queryCoarse != nullptr && tier.LowerBound(entry, queryCoarse, radius) > radius) {
+                continue;
+            }
+            const size_t page = tier.GetPage(entry);
+            candidates[page].push_back(TierCandidate{tier.GetSlot(entry), q});
+            if (page != lastPage) {
+                pagesRead++; // Records follow the page order of the file
+                lastPage = page;
+            }
+        }
+        pagesRead += static_cast<int>(tierPages);
+    }
+    for (vector<TierCandidate>& pageCandidates : candidates) {
+        std::sort(pageCandidates.begin(), pageCandidates.end());
+    }
+
+    // --- Refinement ---
+    for (TComplexObject* query : queries) {
+        query->GetScaledApproximation();
+    }
+    struct WorkerResult {
+        unique_ptr<PartialSinks> sinks;
+        long long distanceCount = 0;
+    };
+    vector<WorkerResult> results(std::max<size_t>(threadCount, 1));
+    const size_t workerCount = (threadCount <= 1) ? 0 :
+        runOnPageRanges(dataFile, pageSize, threadCount, [&](size_t w, size_t firstPage, size_t pageCount) {
+            WorkerResult& result = results[w];
+            result.sinks.reset(new PartialSinks(sinks));
+            refineTierCandidates(dataFile, pageSize, queries, radius, candidates, result.sinks->sinks,
+                                 result.distanceCount, reader, firstPage, pageCount);
+        });
+    if (workerCount == 0) {
+        refineTierCandidates(dataFile, pageSize, queries, radius, candidates, sinks, distanceCounter, reader,
+                             0, SIZE_MAX);
+        return;
+    }
+    results.resize(workerCount);
+    for (const WorkerResult& result : results) {
+        result.sinks->mergeInto(sinks);
+        distanceCounter += result.distanceCount;
+    }
+}
+
+void batchedNearestSearch(const string& dataFile, size_t pageSize,
+                          vector<TComplexObject*>& queries, vector<NearestHeap>& heaps,
+                          long long& distanceCounter, int& pagesRead, const PageReaderOptions& reader,
+                          size_t firstPage, size_t pageLimit, const vector<PageZone>* zones)
+{
+    vector<char> active(queries.size(), 1);
+    vector<ZoneQuery> zoneQueries(queries.size());
+    int queryPageAccesses = 0;
+    auto acceptPage = [&](size_t page) {
+        size_t activeCount = queries.size();
+        if (zones != nullptr && page < zones->size()) {
+            activeCount = 0;
+            for (size_t q = 0; q < queries.size(); ++q) {
+                active[q] = !pageCannotMatch((*zones)[page], *queries[q], heaps[q].bound(), zoneQueries[q]);
+                activeCount += active[q];
+            }
+        }
+        queryPageAccesses += static_cast<int>(activeCount);
+        return activeCount > 0;
+    };
+    // The bounds only shrink, so deciding ahead with the current ones never
+    // drops a page acceptPage would keep
+    auto pageNeeded = [&](size_t page) {
+        if (zones == nullptr || page >= zones->size()) {
+            return true;
+        }
+        for (size_t q = 0; q < queries.size(); ++q) {
+            if (!pageCannotMatch((*zones)[page], *queries[q], heaps[q].bound(), zoneQueries[q])) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto evaluate = [&](auto& dataObject, const auto& dataLabel) {
+        for (size_t q = 0; q < queries.size(); ++q) {
+            if (!active[q]) {
+                continue;
+            }
+            try {
+                const double bound = heaps[q].bound();
+                double distance = calculateComplexObjectDistance(*queries[q], dataObject, distanceCounter, bound);
+                if (distance <= bound) {
+                    heaps[q].offer(TResultPair{dataObject.GetObjectID(), distance});
+                }
+            } catch (const std::exception& e) {
+                cerr << "ERRO no cálculo de distância entre Query(" << queries[q]->GetLabel()
+                     << ") e Data(" << dataLabel() << "): " << e.what() << endl;
+            }
+        }
+    };
+    scanPagedFile(dataFile, pageSize, pagesRead, reader, firstPage, pageLimit, acceptPage, pageNeeded, evaluate);
+    pagesRead = queryPageAccesses;
+}
+
+void parallelNearestSearch(const string& dataFile, size_t pageSize,
+                           vector<TComplexObject*>& queries, size_t k, vector<TResultSink*>& sinks,
+                           long long& distanceCounter, int& pagesRead,
+                           const PageReaderOptions& reader, size_t threadCount,
+                           const vector<PageZone>* zones)
+{
+    struct WorkerResult {
+        vector<NearestHeap> heaps;
+        long long distanceCount = 0;
+        int pagesRead = 0;
+    };
+    for (TComplexObject* query : queries) {
+        query->GetScaledApproximation();
+    }
+    vector<NearestHeap> heaps(queries.size(), NearestHeap(k));
+    vector<WorkerResult> results(std::max<size_t>(threadCount, 1));
+    const size_t workerCount = (threadCount <= 1) ? 0 :
+        runOnPageRanges(dataFile, pageSize, threadCount, [&](size_t w, size_t firstPage, size_t pageCount) {
+            WorkerResult& result = results[w];
+            result.heaps.assign(queries.size(), NearestHeap(k));
+            batchedNearestSearch(dataFile, pageSize, queries, result.heaps,
+                                 result.distanceCount, result.pagesRead, reader, firstPage, pageCount, zones);
+        });
+    if (workerCount == 0) {
+        batchedNearestSearch(dataFile, pageSize, queries, heaps, distanceCounter, pagesRead, reader,
+                             0, SIZE_MAX, zones);
+    } else {
+        results.resize(workerCount);
+        pagesRead = 0;
+        for (const WorkerResult& result : results) {
+            for (size_t q = 0; q < queries.size(); ++q) {
+                for (const TResultPair& entry : result.heaps[q].entries) {
+                    heaps[q].offer(entry);
+                }
+            }
+            distanceCounter += result.distanceCount;
+            pagesRead += result.pagesRead;
+        }
+    }
+    for (size_t q = 0; q < queries.size(); ++q) {
+        heaps[q].emit(*sinks[q]);
+    }
+}
+
+void writeComplexObjectsToPagedFile(const string& inputFile, const string& outputFile, size_t pageSize,
+                                    TLabelStore* labelStore, bool slottedPages, size_t zoneCount,
+                                    TCoarseTierWriter* coarseTier, int targetResolution, size_t ingestThreads) {
+    // 1. Prepare for binary writing
+    ofstream outFile(outputFile, ios::binary | ios::trunc); // Truncate if exists
+    if (!outFile) {
+        cerr << "ERRO: Não foi possível abrir o arquivo de saída binário '" << outputFile << "'!" << endl;
+        return;
+    }
+
+    // 2. Write objects page by page, streaming them from the input file
+    vector<uint8_t> pageBuffer(pageSize, 0); // Initialize buffer with zeros (padding)
+    size_t bufferIdx = 0; // Current position within the page buffer
+    TSlottedPageWriter slottedPage(pageSize, zoneCount);
+    const size_t pageCapacity = slottedPages ? slottedPage.GetCapacity() : pageSize;
+    size_t pageIndex = 0; // Page receiving the current object
+    size_t slotIndex = 0; // Position of the current object within it
+    bool writeFailed = false;
+
+    cout << "INFO: Reading input file '" << inputFile << "'..." << endl;
+    cout << "INFO: Escrevendo objetos serializados no arquivo binário '" << outputFile << "'..." << endl;
+    // Parsing and the resolution transform run on other threads; this one
+    // only serializes, and the pipeline hands every record in the same (reused) object
+    TIngestPipeline pipeline(ingestThreads);
+    pipeline.SetTargetResolution(targetResolution);
+    bool readOk = pipeline.Run(inputFile, [&](TComplexObject& obj) {
+        // With a label store the page entry only carries the object ID
+        if (labelStore) {
+            obj.SetObjectID(labelStore->Append(obj.GetLabel()));
+        }
+        const uint8_t* serialized_obj = obj.Serialize(); // Get serialized data
+        size_t obj_size = obj.GetSerializedSize();       // Get its size
+
+        // Sanity check: Object must fit within a page
+        if (obj_size > pageCapacity) {
+            cerr << "ERRO: Objeto serializado (Label: " << obj.GetLabel()
+                 << ", Size: " << obj_size << " bytes) é maior que o espaço útil da página ("
+                 << pageCapacity << " bytes). Abortando." << endl;
+            writeFailed = true;
+            return false;
+        }
+
+        // The zone map and the coarse tier summarize the approximation block
+        const size_t approxCount = std::min(obj.GetStoredSize(),
+                                            approximationSize(obj.GetData().size(), obj.GetResolution()));
+        auto addToCoarseTier = [&]() {
+            if (coarseTier) {
+                coarseTier->Add(pageIndex, slotIndex, obj.GetResolution(), obj.GetData().data(), approxCount,
+                                obj.GetData().size());
+            }
+            slotIndex++;
+        };
+
+        if (slottedPages) {
+            if (!slottedPage.Add(serialized_obj, obj_size, obj.GetResolution(), obj.GetData().data(), approxCount)) {
+                outFile.write(reinterpret_cast<const char*>(slottedPage.Finish()), pageSize);
+                if (!outFile) {
+                     cerr << "ERRO: Falha ao escrever página no disco!" << endl;
+                     writeFailed = true;
+                     return false;
+                }
+                slottedPage.Clear();
+                slottedPage.Add(serialized_obj, obj_size, obj.GetResolution(), obj.GetData().data(), approxCount);
+                pageIndex++;
+                slotIndex = 0;
+            }
+            addToCoarseTier();
+            return true;
+        }
+
+        // Check if the object fits in the remaining space of the current page
+        if (bufferIdx + obj_size <= pageSize) {
+            // Fits: Copy object into the buffer
+            memcpy(pageBuffer.data() + bufferIdx, serialized_obj, obj_size);
+            bufferIdx += obj_size;
+        } else {
+            // Doesn't fit:
+            // 1. Pad the rest of the current buffer (optional, already zeros)
+            //    memset(pageBuffer.data() + bufferIdx, 0, pageSize - bufferIdx); // Already zeroed
+
+            // 2. Write the current (full) page to disk
+            outFile.write(reinterpret_cast<char*>(pageBuffer.data()), pageSize);
+            if (!outFile) {
+                 cerr << "ERRO: Falha ao escrever página no disco!" << endl;
+                 writeFailed = true;
+                 return false; // Abort on write error
+            }
+
+            // 3. Reset buffer (fill with zeros again for padding)
+            memset(pageBuffer.data(), 0, pageSize);
+            bufferIdx = 0;
+            pageIndex++;
+            slotIndex = 0;
+
+            // 4. Copy the current object to the beginning of the new buffer
+            memcpy(pageBuffer.data() + bufferIdx, serialized_obj, obj_size);
+            bufferIdx += obj_size;
+        }
+        addToCoarseTier();
+        return true;
+    }); // End of loop through objects
+
+    if (!readOk || writeFailed) {
+        if (!readOk) {
+            cerr << "ERRO: Falha ao ler o arquivo de entrada com VectorFileReader." << endl;
+        }
+        // Do not leave a partially written file behind
+        outFile.close();
+        remove(outputFile.c_str());
+        return;
+    }
+    if (pipeline.GetCount() == 0) {
+        cout << "AVISO: Nenhum objeto carregado do arquivo de entrada. Arquivo de saída não será criado." << endl;
+        outFile.close();
+        remove(outputFile.c_str());
+        return;
+    }
+    cout << "INFO: " << pipeline.GetCount() << " objetos carregados." << endl;
+
+    if (slottedPages && !slottedPage.IsEmpty()) {
+        outFile.write(reinterpret_cast<const char*>(slottedPage.Finish()), pageSize);
+        if (!outFile) {
+            cerr << "ERRO: Falha ao escrever a última página no disco!" << endl;
+            return;
+        }
+    }
+
+    // Write the last partially filled (or full) page if it contains data
+    if (bufferIdx > 0) {
+        // Optional: Pad the remainder if not already padded
+        // memset(pageBuffer.data() + bufferIdx, 0, pageSize - bufferIdx);
+        outFile.write(reinterpret_cast<char*>(pageBuffer.data()), pageSize);
+         if (!outFile) {
+             cerr << "ERRO: Falha ao escrever a última página no disco!" << endl;
+             // Consider cleanup
+             return;
+         }
+    }
+
+    cout << "INFO: Escrita no arquivo binário concluída." << endl;
+    outFile.close();
+}
+
+/**
+ * @brief Walks the serialized objects stored in one page and hands each one
+ * to 'visit' (bytes, size, offset inside the page). Slotted pages are read
+ * through their slot directory; plain pages hold objects back to back and
+ * the walk stops at the zero padding or at an object that would cross the
+ * page end. Also stops when 'visit' returns false. Shared by the stream and
+ * mmap readers so both parse pages identically.
+ * @param page First byte of the page.
+ * @param pageBytes Number of valid bytes in the page.
+ */
+static void forEachSerializedObjectInPage(const uint8_t* page, size_t pageBytes,
+                                   const function<bool(const uint8_t*, size_t, size_t)>& visit) {
+    if (TSlottedPageView::IsSlottedPage(page, pageBytes)) {
+        try {
+            TSlottedPageView slottedPage(page, pageBytes);
+            for (size_t slot = 0; slot < slottedPage.GetCount(); ++slot) {
+                size_t objSize;
+                const uint8_t* objData = slottedPage.GetObject(slot, objSize);
+                if (!visit(objData, objSize, static_cast<size_t>(objData - page))) {
+                    break;
+                }
+            }
+        } catch (const std::exception& e) {
+            cerr << "ERRO: Página com cabeçalho inválido: " << e.what() << endl;
+        }
+        return;
+    }
+
+    size_t pageBufferIdx = 0;
+    while (pageBufferIdx < pageBytes) {
+         // "Peek" at the header info without deserializing yet and
+         // calculate the full expected size of this object (accounts for
+         // truncated coefficient storage and both serial formats)
+         int tempResolution;
+         size_t expectedObjSize = TComplexObject::PeekSerializedSize(
+             page + pageBufferIdx, pageBytes - pageBufferIdx, tempResolution);
+         if (expectedObjSize == 0) {
+             // Not enough space left in this page for even a header, need next page
+             // cout << "DEBUG: Not enough space for header, breaking inner loop." << endl;
+             pageBufferIdx = pageBytes; // Force reading next page
+             break;
+         }
+
+         // Zero padding never starts with the v2 tag, so it decodes as a
+         // v1 header: Resolution (int), Data Size (size_t), Label Length (size_t)
+         const size_t HEADER_SIZE = sizeof(int) + 2 * sizeof(size_t);
+         // Check if the object starts with resolution 0 AND has 0 size/length.
+         // This *might* indicate padding if we used zeros. Be cautious with this check.
+         // A safer approach is needed if valid objects can have resolution 0 and empty data/label.
+         // Let's assume valid objects have *some* size or non-zero resolution for now.
+         // If resolution is 0 AND expectedObjSize == HEADER_SIZE, it's likely padding.
+         if (tempResolution == 0 && expectedObjSize == HEADER_SIZE) {
+             // Potential padding detected, skip to next page.
+             // This assumes padding starts with 0 for resolution.
+             // If valid objects can have resolution 0, this logic fails.
+             // cout << "DEBUG: Potential padding detected, breaking inner loop." << endl;
+             pageBufferIdx = pageBytes; // Force reading next page
+             break;
+         }
+
+         // Check if the *entire* object fits within the bounds of the current page buffer
+         if (pageBufferIdx + expectedObjSize <= pageBytes) {
+             // Object fits entirely within the current page buffer segment
+             if (!visit(page + pageBufferIdx, expectedObjSize, pageBufferIdx)) {
+                 break;
+             }
+             pageBufferIdx += expectedObjSize; // Advance pointer past the object
+         } else {
+             // Object calculated size extends beyond the current page buffer.
+             // Since the writer ensures objects don't span pages, this signifies
+             // the end of valid data in this page (or a read error/corruption).
+             // cout << "DEBUG: Object spans page boundary (or end of data in page), breaking inner loop." << endl;
+             pageBufferIdx = pageBytes; // Force reading next page
+             break;
+         }
+    } // End while(pageBufferIdx < pageBytes)
+}
+
+vector<TComplexObject> readComplexObjectsFromPagedFile(const string& inputFile, size_t pageSize, int& pageAccessCount) {
+    vector<TComplexObject> loadedObjects;
+    forEachObjectInPagedFile(inputFile, pageSize, pageAccessCount,
+                             [&loadedObjects](TComplexObject& obj) { loadedObjects.push_back(obj); });
+    return loadedObjects;
+}
+
+bool forEachObjectInPagedFile(const string& inputFile, size_t pageSize, int& pageAccessCount,
+                              const function<void(TComplexObject&)>& visitObject,
+                              size_t firstPage, size_t pageLimit,
+                              const function<bool(size_t)>& acceptPage) {
+    pageAccessCount = 0; // Initialize page count
+
+    ifstream inFile(inputFile, ios::binary);
+    if (!inFile) {
+        cerr << "ERRO: Não foi possível abrir o arquivo binário de entrada '" << inputFile << "'!" << endl;
+        return false;
+    }
+
+    TComplexObject obj; // Reused: Unserialize keeps the Data capacity
+    vector<uint8_t> pageBuffer(pageSize); // Buffer to hold one page
+    size_t pageBufferIdx = pageSize; // Start as if buffer is "empty" or fully processed
+    size_t pagesVisited = 0; // Pages of the range read or skipped so far
+    inFile.seekg(0, ios::end);
+    const size_t pageCount = (static_cast<size_t>(inFile.tellg()) + pageSize - 1) / pageSize;
+    pageLimit = (firstPage < pageCount) ? std::min(pageLimit, pageCount - firstPage) : 0;
+    inFile.seekg(static_cast<std::streamoff>(firstPage * pageSize), ios::beg);
+
+    // cout << "INFO: Lendo objetos serializados do arquivo binário '" << inputFile << "'..." << endl;
+
+    // Loop reading page by page
+    while (true) {
+        // If the internal page buffer pointer is at the end, read a new page
+        if (pageBufferIdx >= pageSize) {
+            if (pagesVisited >= pageLimit) {
+                break; // End of the requested page range
+            }
+            const size_t page = firstPage + pagesVisited++;
+            if (acceptPage && !acceptPage(page)) {
+                inFile.seekg(static_cast<std::streamoff>(pageSize), ios::cur);
+                continue;
+            }
+            inFile.read(reinterpret_cast<char*>(pageBuffer.data()), pageSize);
+            if (inFile.gcount() == 0) { // Check if read failed or reached EOF immediately
+                 if(inFile.eof()){
+                    // Expected EOF if file size is multiple of page size and fully processed
+                     // cout << "DEBUG: EOF reached after processing full page." << endl;
+                 } else {
+                     cerr << "ERRO: Falha ao ler página do arquivo binário!" << endl;
+                 }
+                 break; // Stop reading
+            }
+             if (inFile.gcount() < static_cast<std::streamsize>(pageSize)) {
+                // Read less than a full page - likely the last partial page.
+                // Adjust effective buffer size for this last read.
+                // cout << "DEBUG: Read last partial page (" << inFile.gcount() << " bytes)." << endl;
+                 // For simplicity in this reader, we might just process what we can
+                 // or decide how to handle potentially incomplete objects at EOF.
+                 // If the writer *always* pads to pageSize, gcount() should always be pageSize until EOF.
+                 if (!inFile.eof()) { // If not EOF, it's a read error
+                    cerr << "ERRO: Leitura incompleta de página antes do EOF!" << endl;
+                    break;
+                 }
+            }
+            pageAccessCount++; // Count successful page read
+            pageBufferIdx = 0;  // Reset internal pointer to start of new page
+        }
+
+        // Deserialize the objects of the page in place
+        forEachSerializedObjectInPage(pageBuffer.data(), pageSize,
+                                      [&](const uint8_t* objData, size_t objSize, size_t pageOffset) {
+            try {
+                obj.Unserialize(objData, objSize);
+            } catch (const std::exception& e) {
+                cerr << "ERRO: Falha ao deserializar objeto na posição " << pageOffset
+                     << " da página " << pageAccessCount << ". Erro: " << e.what() << endl;
+                // Critical error - move to next page, hoping it recovers
+                return false;
+            }
+            visitObject(obj);
+            return true;
+        });
+        pageBufferIdx = pageSize; // Page fully processed
+
+    } // End while(true) reading pages
+
+    // cout << "INFO: Leitura do arquivo binário concluída." << endl;
+
+    inFile.close();
+    return true;
+}
+
+bool forEachObjectViewInMappedFile(const string& inputFile, size_t pageSize, int& pageAccessCount,
+                                   const function<void(const TComplexObjectView&)>& visitView,
+                                   size_t firstPage, size_t pageLimit,
+                                   const function<bool(size_t)>& acceptPage) {
+    pageAccessCount = 0;
+
+    int fd = open(inputFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "ERRO: Não foi possível abrir o arquivo binário de entrada '" << inputFile << "'!" << endl;
+        return false;
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        cerr << "ERRO: Não foi possível obter o tamanho de '" << inputFile << "'!" << endl;
+        close(fd);
+        return false;
+    }
+    const size_t fileSize = static_cast<size_t>(fileInfo.st_size);
+    if (fileSize == 0) {
+        close(fd);
+        return true; // Nothing to map
+    }
+    void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file
+    if (mapped == MAP_FAILED) {
+        cerr << "ERRO: Falha ao mapear o arquivo binário '" << inputFile << "'!" << endl;
+        return false;
+    }
+    // Pages are visited once, in order: let the kernel read ahead
+    madvise(mapped, fileSize, MADV_SEQUENTIAL);
+
+    const uint8_t* fileData = static_cast<const uint8_t*>(mapped);
+    const size_t pageCount = (fileSize + pageSize - 1) / pageSize;
+    const size_t lastPage = (firstPage < pageCount) ? firstPage + std::min(pageLimit, pageCount - firstPage) : firstPage;
+    for (size_t page = firstPage; page < lastPage; ++page) {
+        if (acceptPage && !acceptPage(page)) {
+            continue;
+        }
+        const size_t pageStart = page * pageSize;
+        pageAccessCount++;
+        const size_t pageBytes = std::min(pageSize, fileSize - pageStart);
+        forEachSerializedObjectInPage(fileData + pageStart, pageBytes,
+                                      [&](const uint8_t* objData, size_t objSize, size_t pageOffset) {
+            try {
+                visitView(TComplexObjectView(objData, objSize));
+            } catch (const std::exception& e) {
+                cerr << "ERRO: Falha ao ler objeto na posição " << pageOffset
+                     << " da página " << pageAccessCount << ". Erro: " << e.what() << endl;
+                return false;
+            }
+            return true;
+        });
+    }
+
+    munmap(mapped, fileSize);
+    return true;
+}
+
+bool forEachObjectViewInAsyncFile(const string& inputFile, size_t pageSize, int& pageAccessCount,
+                                  const function<void(const TComplexObjectView&)>& visitView,
+                                  const PageReaderOptions& options,
+                                  size_t firstPage, size_t pageLimit,
+                                  const function<bool(size_t)>& acceptPage,
+                                  const function<bool(size_t)>& pageNeeded) {
+    pageAccessCount = 0;
+
+    TAsyncPageReader pageReader(pageSize, options.queueDepth, options.engine, options.directIO);
+    if (!pageReader.Open(inputFile)) {
+        cerr << "ERRO: Não foi possível abrir o arquivo binário de entrada '" << inputFile << "'!" << endl;
+        return false;
+    }
+    bool ok = pageReader.ReadPages(firstPage, pageLimit, pageNeeded,
+                                   [&](size_t page, const uint8_t* pageData, size_t pageBytes) {
+        if (acceptPage && !acceptPage(page)) {
+            return;
+        }
+        pageAccessCount++;
+        forEachSerializedObjectInPage(pageData, pageBytes,
+                                      [&](const uint8_t* objData, size_t objSize, size_t pageOffset) {
+            try {
+                visitView(TComplexObjectView(objData, objSize));
+            } catch (const std::exception& e) {
+                cerr << "ERRO: Falha ao ler objeto na posição " << pageOffset
+                     << " da página " << pageAccessCount << ". Erro: " << e.what() << endl;
+                return false;
+            }
+            return true;
+        });
+    });
+    if (!ok) {
+        cerr << "ERRO: Falha ao ler página do arquivo binário!" << endl;
+    }
+    return ok;
+}
+
@@ -0,0 +1,392 @@
+#ifndef SCAN_SEARCH_H
+#define SCAN_SEARCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "async_page_reader.h" // TAsyncPageReader::Engine
+#include "complex_object.h"
+#include "result_sink.h"
+#include "slotted_page.h"      // SLOTTED_PAGE_NO_ZONE
+
+class TLabelStore;
+class TCoarseTier;
+class TCoarseTierWriter;
+
+//---------------------------------------------------------------------------
+// Sequential scan over a paged file
+//---------------------------------------------------------------------------
+/**
+* Searches of sequential_scan: the dataset is written once to a file of
+* fixed-size pages (plain or slotted, see slotted_page.h) and every query
+* reads the pages back, with a stream, mmap or asynchronous reader, and
+* compares the query with each object. Range and k-nearest-neighbor
+* searches can serve a group of queries per pass, split the pages among
+* threads, skip pages through their zone maps and pre-filter with a coarse
+* tier (coarse_tier.h); all of them give the results of a plain per-object
+* loop, in the same order.
+*/
+
+/**
+ * @brief How the scan reads the paged file.
+ */
+struct PageReaderOptions {
+    enum Mode {
+        READER_STREAM, // ifstream, one page at a time, objects deserialized
+        READER_MMAP,   // mapped file, objects evaluated in place
+        READER_ASYNC   // TAsyncPageReader, 'queueDepth' reads in flight
+    };
+    Mode mode = READER_STREAM;
+    size_t queueDepth = 8;
+    TAsyncPageReader::Engine engine = TAsyncPageReader::ENGINE_AUTO;
+    bool directIO = false; // O_DIRECT (READER_ASYNC only)
+};
+
+//---------------------------------------------------------------------------
+// Paged file
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Writes the objects of a text dataset to a page-aligned binary file.
+ * @param slottedPages Writes TSlottedPageWriter pages (header, slot
+ * directory and zone map) instead of objects followed by zero padding.
+ * @param zoneCount Approximation coefficients summarized in the zone map of
+ * each slotted page (0 disables it).
+ * @param coarseTier Open TCoarseTierWriter that receives the coarse copy of
+ * each object with its page and slot, or NULL.
+ * @param targetResolution Resolution the objects are brought to while they
+ * are read (see VectorFileReader::setTargetResolution), or -1 to keep the
+ * resolution of the input file.
+ * @param ingestThreads Transform threads of the TIngestPipeline that reads
+ * the input file (0 = automatic).
+ */
+void writeComplexObjectsToPagedFile(const std::string& inputFile, const std::string& outputFile, size_t pageSize,
+                                    TLabelStore* labelStore = nullptr, bool slottedPages = false,
+                                    size_t zoneCount = 0, TCoarseTierWriter* coarseTier = nullptr,
+                                    int targetResolution = -1, size_t ingestThreads = 0);
+
+/**
+ * @brief Reads serialized TComplexObject data from a page-aligned binary file.
+ * @param inputFile Path to the binary input file created by writeComplexObjectsToPagedFile.
+ * @param pageSize The simulated disk page size in bytes (must match writer).
+ * @param[out] pageAccessCount Reference to store the number of pages read.
+ * @return A vector containing the deserialized TComplexObject instances.
+ */
+std::vector<TComplexObject> readComplexObjectsFromPagedFile(const std::string& inputFile, size_t pageSize, int& pageAccessCount);
+
+/**
+ * @brief Reads a page-aligned binary file page by page and hands every
+ * deserialized object to 'visitObject'. The same TComplexObject instance
+ * is reused for every object (it is only valid during the call), so no
+ * copy of the dataset is kept in memory.
+ * @param inputFile Path to the binary input file created by writeComplexObjectsToPagedFile.
+ * @param pageSize The simulated disk page size in bytes (must match writer).
+ * @param[out] pageAccessCount Reference to store the number of pages read.
+ * @param visitObject Called once per object, in file order.
+ * @param firstPage First page to read (pages before it are skipped).
+ * @param pageLimit Maximum number of pages to read from firstPage.
+ * @param acceptPage Optional filter called with each page number before it
+ * is read; pages it rejects are neither read nor counted.
+ * @return false if the file could not be opened.
+ */
+bool forEachObjectInPagedFile(const std::string& inputFile, size_t pageSize, int& pageAccessCount,
+                              const std::function<void(TComplexObject&)>& visitObject,
+                              size_t firstPage = 0, size_t pageLimit = SIZE_MAX,
+                              const std::function<bool(size_t)>& acceptPage = nullptr);
+
+/**
+ * @brief Same walk as forEachObjectInPagedFile, but the file is mapped
+ * with mmap and each object is handed over as a TComplexObjectView over
+ * the mapped bytes: nothing is copied or deserialized, so the memory used
+ * by the scan does not grow with the dataset. Every page touched counts as
+ * one access, exactly like a page read by the stream reader.
+ * @param inputFile Path to the binary input file created by writeComplexObjectsToPagedFile.
+ * @param pageSize The simulated disk page size in bytes (must match writer).
+ * @param[out] pageAccessCount Reference to store the number of pages read.
+ * @param visitView Called once per object, in file order. The view is only
+ * valid during the call.
+ * @param firstPage First page to visit.
+ * @param pageLimit Maximum number of pages to visit from firstPage.
+ * @param acceptPage Optional filter, as in forEachObjectInPagedFile.
+ * @return false if the file could not be opened or mapped.
+ */
+bool forEachObjectViewInMappedFile(const std::string& inputFile, size_t pageSize, int& pageAccessCount,
+                                   const std::function<void(const TComplexObjectView&)>& visitView,
+                                   size_t firstPage = 0, size_t pageLimit = SIZE_MAX,
+                                   const std::function<bool(size_t)>& acceptPage = nullptr);
+
+/**
+ * @brief Same walk as forEachObjectViewInMappedFile, but the pages are read
+ * by a TAsyncPageReader that keeps options.queueDepth reads in flight:
+ * the objects of a page are evaluated while the following pages are still
+ * being read. Page accesses are counted as in the other readers.
+ * @param options Queue depth and engine of the reader.
+ * @param acceptPage Optional filter, called in page order right before the
+ * objects of a page are visited.
+ * @param pageNeeded Optional side-effect free version of acceptPage,
+ * asked before each read is submitted (ahead of the visits).
+ * @return false if the file could not be opened or a read failed.
+ */
+bool forEachObjectViewInAsyncFile(const std::string& inputFile, size_t pageSize, int& pageAccessCount,
+                                  const std::function<void(const TComplexObjectView&)>& visitView,
+                                  const PageReaderOptions& options,
+                                  size_t firstPage = 0, size_t pageLimit = SIZE_MAX,
+                                  const std::function<bool(size_t)>& acceptPage = nullptr,
+                                  const std::function<bool(size_t)>& pageNeeded = nullptr);
+
+/**
+ * @brief Zone map of one slotted page, kept in memory by the scan.
+ */
+struct PageZone {
+    int resolution = SLOTTED_PAGE_NO_ZONE;
+    std::vector<double> minimum;
+    std::vector<double> maximum;
+};
+
+
+/**
+ * @brief Reads the header of every page of a slotted paged file once and
+ * keeps the zone maps in memory, so the scan can decide which pages to read
+ * without touching them.
+ * @return One entry per page, or an empty vector if the file does not use
+ * slotted pages.
+ */
+std::vector<PageZone> loadPageZones(const std::string& dataFile, size_t pageSize);
+
+//---------------------------------------------------------------------------
+// Distance
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Calcula a distância (Manhattan nos coeficientes de aproximação)
+ * entre dois objetos TComplexObject.
+ * Se as resoluções diferem, a aproximação de obj1 na resolução de obj2 é
+ * calculada diretamente a partir dos seus coeficientes (sem clone).
+ *
+ * @param obj1 Primeiro TComplexObject.
+ * @param obj2 Segundo TComplexObject (resolução alvo).
+ * @param[in, out] distanceCounter Contador para registrar o número de cálculos de distância.
+ * @param bound Limite de abandono antecipado: a soma para assim que o
+ * parcial ultrapassa este valor (infinito calcula a distância completa).
+ * @return double A distância calculada (exata se <= bound; caso contrário,
+ * apenas garantidamente maior que bound).
+ * @throws std::runtime_error Se os tamanhos de dados subjacentes forem diferentes,
+ * ou se obj1 não puder ser levado à resolução alvo.
+ */
+double calculateComplexObjectDistance(TComplexObject& obj1, TComplexObject& obj2, long long& distanceCounter,
+                                      double bound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Versão de calculateComplexObjectDistance em que obj2 é uma visão
+ * sobre os bytes serializados (página mapeada), sem deserialização.
+ * Entradas com coeficientes inteiros na mesma resolução da consulta usam os
+ * kernels inteiros; as demais são convertidas apenas no bloco de aproximação.
+ * Coeficientes fora do alinhamento do seu tipo (formato v1, em que objetos
+ * começam em qualquer posição da página) também são copiados, com memcpy,
+ * antes de chegar aos kernels.
+ */
+double calculateComplexObjectDistance(TComplexObject& obj1, const TComplexObjectView& obj2,
+                                      long long& distanceCounter,
+                                      double bound = std::numeric_limits<double>::infinity());
+
+//---------------------------------------------------------------------------
+// Range search
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Performs a sequential range search.
+ * Finds all objects in the dataset that are within a given radius of the query object.
+ * Uses the integrated distance calculation function.
+ *
+ * @param dataset The vector of TComplexObject representing the dataset to search within.
+ * @param queryObject The query TComplexObject.
+ * @param radius The search radius.
+ * @param sink Receives the ID and distance of each object found (the
+ * objects themselves are not copied).
+ * @param[in, out] distanceCounter Counter for distance calculations.
+ */
+void sequentialRangeSearch(std::vector<TComplexObject>& dataset, TComplexObject& queryObject, double radius,
+                           TResultSink& sink, long long& distanceCounter);
+
+/**
+ * @brief Splits the pages of 'dataFile' into 'threadCount' contiguous
+ * ranges (differing by at most one page) and runs
+ * work(worker, firstPage, pageCount) for each of them on its own thread.
+ * @return Number of workers used, or 0 if the file cannot be examined (the
+ * caller then scans it by itself).
+ */
+size_t runOnPageRanges(const std::string& dataFile, size_t pageSize, size_t threadCount,
+                       const std::function<void(size_t, size_t, size_t)>& work);
+
+/**
+ * @brief Empty sinks of the same kind as 'sinks' (one per query), where a
+ * worker thread collects its part of the results.
+ */
+struct PartialSinks {
+    std::vector<std::unique_ptr<TResultSink>> owned;
+    std::vector<TResultSink*> sinks;
+
+    explicit PartialSinks(const std::vector<TResultSink*>& model) {
+        for (TResultSink* sink : model) {
+            owned.push_back(sink->CreateEmpty());
+            sinks.push_back(owned.back().get());
+        }
+    }
+
+    void mergeInto(std::vector<TResultSink*>& target) const {
+        for (size_t q = 0; q < target.size(); ++q) {
+            target[q]->Merge(*owned[q]);
+        }
+    }
+};
+
+
+/**
+ * @brief Range search for a group of queries in a single pass over the
+ * paged file: every page is read once and each object on it is compared
+ * with all the queries of the group.
+ *
+ * @param dataFile Paged file written by writeComplexObjectsToPagedFile.
+ * @param pageSize The simulated disk page size in bytes.
+ * @param queries Query objects of the group.
+ * @param radius The search radius.
+ * @param sinks Receive the results of each query (one per query).
+ * @param[in, out] distanceCounter Counter for distance calculations.
+ * @param[out] pagesRead Page accesses summed over the queries of the group:
+ * each query counts every page it had to examine, as in a per-query scan.
+ * @param reader How the pages are read (see PageReaderOptions).
+ * @param firstPage First page of the file to scan.
+ * @param pageLimit Maximum number of pages to scan from firstPage.
+ * @param zones Zone maps from loadPageZones, or NULL. A page is skipped for
+ * the queries whose lower bound exceeds the radius, and not read at all
+ * when that holds for every query of the group.
+ */
+void batchedRangeSearch(const std::string& dataFile, size_t pageSize,
+                        std::vector<TComplexObject*>& queries, double radius, std::vector<TResultSink*>& sinks,
+                        long long& distanceCounter, int& pagesRead, const PageReaderOptions& reader,
+                        size_t firstPage = 0, size_t pageLimit = SIZE_MAX,
+                        const std::vector<PageZone>* zones = nullptr);
+
+/**
+ * @brief batchedRangeSearch with the pages of the file split into
+ * 'threadCount' contiguous ranges, one per worker thread. Each worker keeps
+ * its own distance counter, page counter and result sinks; they are
+ * merged in worker order after all threads finish, so the totals (and the
+ * order of the results) do not depend on scheduling.
+ *
+ * @param threadCount Number of workers (1 runs batchedRangeSearch directly).
+ * @param zones Zone maps from loadPageZones, or NULL.
+ */
+void parallelRangeSearch(const std::string& dataFile, size_t pageSize,
+                         std::vector<TComplexObject*>& queries, double radius, std::vector<TResultSink*>& sinks,
+                         long long& distanceCounter, int& pagesRead, const PageReaderOptions& reader,
+                         size_t threadCount, const std::vector<PageZone>* zones = nullptr);
+
+/**
+ * @brief Two-tier range search for a group of queries. Every query is
+ * first compared with the coarse copy of each object (TCoarseTier, read
+ * from memory); only the objects whose lower bound is within the radius
+ * are refined, reading just the pages of the paged file that hold them.
+ *
+ * @param tier Coarse tier written next to 'dataFile'.
+ * @param[in, out] coarseCounter Counter for coarse (lower bound)
+ * comparisons; distanceCounter only counts the refinements.
+ * @param[out] pagesRead Page accesses summed over the queries: each query
+ * counts the pages of the tier file plus the data pages holding its
+ * candidates.
+ * @param threadCount Workers for the refinement (see parallelRangeSearch).
+ * Other parameters as in batchedRangeSearch.
+ */
+void tieredRangeSearch(const std::string& dataFile, const TCoarseTier& tier, size_t pageSize,
+                       std::vector<TComplexObject*>& queries, double radius, std::vector<TResultSink*>& sinks,
+                       long long& distanceCounter, long long& coarseCounter, int& pagesRead,
+                       const PageReaderOptions& reader, size_t threadCount);
+
+//---------------------------------------------------------------------------
+// k-nearest-neighbor search
+//---------------------------------------------------------------------------
+
+/**
+ * @brief The 'k' nearest results seen so far by a kNN scan, kept as a
+ * max-heap (by distance, then ID) so the current k-th distance is always at
+ * the front.
+ */
+struct NearestHeap {
+    size_t k = 0;
+    std::vector<TResultPair> entries;
+
+    explicit NearestHeap(size_t neighbors = 0) : k(neighbors) {
+        entries.reserve(k);
+    }
+
+    /**
+     * @brief Largest distance that can still enter the heap: infinite while
+     * it holds fewer than k entries, the current k-th distance afterwards.
+     */
+    double bound() const {
+        return (entries.size() < k) ? std::numeric_limits<double>::infinity() : entries.front().Distance;
+    }
+
+    void offer(const TResultPair& entry) {
+        if (k == 0) {
+            return;
+        }
+        if (entries.size() < k) {
+            entries.push_back(entry);
+            std::push_heap(entries.begin(), entries.end());
+        } else if (entry < entries.front()) {
+            std::pop_heap(entries.begin(), entries.end());
+            entries.back() = entry;
+            std::push_heap(entries.begin(), entries.end());
+        }
+    }
+
+    /**
+     * @brief Hands the entries to 'sink' in increasing order of distance.
+     */
+    void emit(TResultSink& sink) const {
+        std::vector<TResultPair> sorted = entries;
+        std::sort(sorted.begin(), sorted.end());
+        for (const TResultPair& entry : sorted) {
+            sink.Add(entry.ObjectID, entry.Distance);
+        }
+    }
+};
+
+
+/**
+ * @brief k-nearest-neighbor search for a group of queries in a single pass
+ * over the paged file. Each query keeps a NearestHeap; its current k-th
+ * distance is the early-abandon bound of the distance kernel and, with zone
+ * maps, the radius used to skip pages.
+ *
+ * Parameters as in batchedRangeSearch, with the heaps in place of the
+ * radius and the sinks.
+ * @param[in, out] heaps One NearestHeap per query, updated with the objects
+ * of the scanned pages.
+ */
+void batchedNearestSearch(const std::string& dataFile, size_t pageSize,
+                          std::vector<TComplexObject*>& queries, std::vector<NearestHeap>& heaps,
+                          long long& distanceCounter, int& pagesRead, const PageReaderOptions& reader,
+                          size_t firstPage = 0, size_t pageLimit = SIZE_MAX,
+                          const std::vector<PageZone>* zones = nullptr);
+
+/**
+ * @brief batchedNearestSearch with the pages split among 'threadCount'
+ * workers, as in parallelRangeSearch. Each worker finds the k nearest
+ * objects of its range; the k smallest of those are kept, merging in worker
+ * order, and handed to 'sinks' in increasing order of distance.
+ */
+void parallelNearestSearch(const std::string& dataFile, size_t pageSize,
+                           std::vector<TComplexObject*>& queries, size_t k, std::vector<TResultSink*>& sinks,
+                           long long& distanceCounter, int& pagesRead,
+                           const PageReaderOptions& reader, size_t threadCount,
+                           const std::vector<PageZone>* zones = nullptr);
+
+#endif // SCAN_SEARCH_H
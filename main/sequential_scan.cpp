@@ -10,444 +10,150 @@
 #include <chrono>    // For timing
 #include <cmath>     // For std::pow, std::abs, std::isfinite
 #include <memory>    // For std::unique_ptr
+#include <limits>    // For std::numeric_limits
+#include <functional> // For std::function
+#include <algorithm> // For std::min
+#include <thread>    // For std::thread
 
 // Include our classes (EXCETO distance_calculator.h)
 #include "VectorFileReader.hpp" // Assumes this exists and works
 #include "complex_object.h"     // Includes TComplexObject definition
+#include "distance_kernels.h"   // Manhattan and cross-resolution kernels
+#include "label_store.h"        // Labels kept outside the pages
+#include "slotted_page.h"       // Page header, slots and zone maps
+#include "haar_transform.h"     // Query approximations for the zone maps
+#include "async_page_reader.h"  // Page reads with several requests in flight
+#include "page_cache.h"         // Cold-cache runs
+#include "coarse_tier.h"        // Coarse copy of the dataset for pre-filtering
+#include "result_sink.h"        // IDs and distances of the results
+#include "ingest_pipeline.h"    // Parse/transform stages of the dataset load
+#include "scan_search.h"        // Paged file, range and kNN searches
 // #include "distance_calculator.h" // REMOVIDO
 
 using namespace std;
 using namespace std::chrono;
 
-// Forward declarations das funções que estavam no início (se necessário)
-void writeComplexObjectsToPagedFile(const string& inputFile, const string& outputFile, size_t pageSize);
-vector<TComplexObject> readComplexObjectsFromPagedFile(const string& inputFile, size_t pageSize, int& pageAccessCount);
-// vector<TComplexObject> sequentialRangeSearch(...); // Declarado mais abaixo
-
-//---------------------------------------------------------------------------
-// Função de Cálculo de Distância (Integrada)
-// Baseada na lógica de TComplexObjectDistanceEvaluator::GetDistance2
-//---------------------------------------------------------------------------
-/**
- * @brief Calcula a distância (Manhattan nos coeficientes de aproximação)
- * entre dois objetos TComplexObject.
- * Ajusta a resolução do obj1 para corresponder ao obj2, se necessário,
- * usando um clone temporário.
- *
- * @param obj1 Primeiro TComplexObject (pode ser clonado temporariamente).
- * @param obj2 Segundo TComplexObject (resolução alvo).
- * @param[in, out] distanceCounter Contador para registrar o número de cálculos de distância.
- * @return double A distância calculada.
- * @throws std::runtime_error Se os tamanhos de dados subjacentes forem diferentes,
- * ou se a clonagem/transformação falhar.
- */
-double calculateComplexObjectDistance(TComplexObject& obj1, TComplexObject& obj2, long long& distanceCounter) {
-
-    // --- Seção 1: Preparar Ponteiros de Dados e Lidar com Diferenças de Resolução ---
-
-    const int targetResolution = obj2.GetResolution();
-    const std::vector<double>& data2_obj = obj2.GetData();
-
-    // Ponteiro para o vetor de dados de obj1 (ou seu clone temporário)
-    const std::vector<double>* data1_ptr = &obj1.GetData();
-
-    // Smart pointer para gerenciar a vida útil de um clone temporário de obj1
-    std::unique_ptr<TComplexObject> obj1_temp_clone_ptr = nullptr;
-
-    int currentResolution = obj1.GetResolution();
-
-    // Verifica se obj1 precisa de ajuste de resolução
-    if (currentResolution != targetResolution) {
-        // Clona obj1 para evitar modificar o objeto original permanentemente
-        try {
-            // obj1.Clone() deve retornar TComplexObject*
-            obj1_temp_clone_ptr.reset(obj1.Clone()); // Transfere posse para unique_ptr
-        } catch (const std::bad_alloc& e) {
-            throw std::runtime_error("Falha ao alocar memória para o clone de obj1.");
-        }
-        if (!obj1_temp_clone_ptr) {
-            throw std::runtime_error("Falha ao clonar obj1 para cálculo de distância (resultado nulo).");
-        }
-
-        // Verifica incompatibilidade fundamental de tamanho antes de transformar
-        // Assume que GetData() retorna um vetor válido mesmo após clone
-        if (obj1_temp_clone_ptr->GetData().size() != data2_obj.size()) {
-            // unique_ptr lida com a deleção do clone
-            throw std::runtime_error("Objetos têm tamanhos de dados subjacentes diferentes, não podem ser comparados (pós-clone).");
-        }
-
-        // Calcula o nível de transformação necessário para o clone
-        int levelsToTransform = targetResolution - currentResolution; // Positivo = comprime, Negativo = descomprime
-
-        // Aplica a transformação *ao clone* usando o método público dataCompression
-        // Este método deve tratar níveis positivos e negativos internamente.
-        // Assume que dataCompression existe e é público em TComplexObject
-        obj1_temp_clone_ptr->dataCompression(levelsToTransform);
-
-        // Verifica se a transformação resultou na resolução alvo
-        if (obj1_temp_clone_ptr->GetResolution() != targetResolution) {
-             throw std::runtime_error("Falha ao ajustar clone de obj1 para resolução alvo. CloneRes="
-                 + std::to_string(obj1_temp_clone_ptr->GetResolution()) + ", TargetRes=" + std::to_string(targetResolution));
-        }
-
-        // Atualiza o ponteiro para usar os dados transformados do clone
-        data1_ptr = &obj1_temp_clone_ptr->GetData();
-
-    } else {
-         // Resoluções já coincidem, ainda verifica compatibilidade de tamanho
-         if (obj1.GetData().size() != data2_obj.size()) {
-             throw std::runtime_error("Objetos têm tamanhos de dados subjacentes diferentes, não podem ser comparados.");
-         }
-         // data1_ptr já aponta para obj1.GetData() - nenhum clone necessário
-    }
-
-    // --- Seção 2: Calcular Distância usando Coeficientes de Aproximação ---
-
-    // Agora, data1_ptr aponta para os dados de obj1 (ou seu clone) na targetResolution
-    // e data2_obj são os dados de obj2 na targetResolution. Seus tamanhos subjacentes coincidem.
-
-    // Calcula o número de coeficientes de aproximação na resolução alvo
-    if (data2_obj.empty()) {
-         distanceCounter++; // Conta o cálculo de distância
-         return 0.0; // Distância é 0 se os objetos estiverem vazios
-    }
-     // Verificação de segurança adicional para data1_ptr
-    if (!data1_ptr || data1_ptr->empty()) {
-         // Não deve acontecer se data2_obj não estiver vazio e os tamanhos coincidirem, mas verifica
-         distanceCounter++; // Conta o cálculo de distância
-         return 0.0; // Ou lançar erro? Retornar 0 se ambos vazios parece ok.
-    }
-
-    // Usa double para tamanho potencialmente grande ou resultado intermediário de pow
-    double powerOfTwo = std::pow(2.0, static_cast<double>(targetResolution));
-     // Verificações básicas para o resultado de pow
-    if (powerOfTwo <= 0 || !std::isfinite(powerOfTwo)) {
-         throw std::runtime_error("Cálculo inválido de potência para resolução.");
-    }
-     // Evita divisão por zero ou próximo de zero (se resolução for muito alta)
-    if (powerOfTwo < 1.0) powerOfTwo = 1.0; // Resolução 0 ou negativa resulta em 2^0=1
-
-    // Calcula o tamanho aproximado, garantindo que não exceda o tamanho real do vetor
-    size_t vectorSize = data2_obj.size(); // Usa tamanho comum
-    // Cuidado com divisão de inteiros aqui, use double no cálculo
-    size_t approxSize = static_cast<size_t>(static_cast<double>(vectorSize) / powerOfTwo);
-    approxSize = std::min(approxSize, vectorSize); // Garante não ser maior que o tamanho total
-
-    if (approxSize == 0 && vectorSize > 0) {
-         // Resolução pode ser muito alta para o tamanho dos dados
-         std::cerr << "Aviso: Resolução " << targetResolution
-                   << " resulta em zero coeficientes de aproximação para tamanho "
-                   << vectorSize << std::endl;
-         distanceCounter++; // Conta o cálculo de distância
-         return 0.0; // Ou lançar std::runtime_error("Não é possível comparar neste nível de resolução.");
-    }
-
-    // Calcula a distância Manhattan usando apenas os coeficientes de aproximação
-    double sumOfDiff = 0.0;
-    for (size_t i = 0; i < approxSize; ++i) {
-         // Acessa os dados usando desreferência do ponteiro (*data1_ptr)
-         // Verifica limites (embora approxSize já deva ser seguro)
-         if (i >= data1_ptr->size() || i >= data2_obj.size()) {
-             throw std::runtime_error("Índice fora dos limites durante cálculo de distância - lógica interna falhou.");
-         }
-         double diff = (*data1_ptr)[i] - data2_obj[i];
-         sumOfDiff += std::abs(diff); // Usa std::abs para double
-    }
-
-    distanceCounter++; // Atualiza o contador de distância
-    return sumOfDiff;
-
-    // unique_ptr (obj1_temp_clone_ptr) será destruído automaticamente ao sair do escopo,
-    // liberando a memória do clone se ele foi criado.
-}
-
-
-/**
- * @brief Performs a sequential range search.
- * Finds all objects in the dataset that are within a given radius of the query object.
- * Uses the integrated distance calculation function.
- *
- * @param dataset The vector of TComplexObject representing the dataset to search within.
- * @param queryObject The query TComplexObject.
- * @param radius The search radius.
- * @param[in, out] distanceCounter Counter for distance calculations.
- * @return A vector containing copies of the TComplexObject instances found within the radius.
- */
-vector<TComplexObject> sequentialRangeSearch(
-    vector<TComplexObject>& dataset, // Non-const because distance func needs it
-    TComplexObject& queryObject,     // Non-const because distance func needs it
-    double radius,
-    long long& distanceCounter)      // Pass counter by reference
-{
-    vector<TComplexObject> results;
-    results.reserve(dataset.size() / 10); // Pre-allocate some space (heuristic)
-
-    for (TComplexObject& dataObject : dataset) {
-        try {
-            // Calculate distance using the integrated function
-            double distance = calculateComplexObjectDistance(queryObject, dataObject, distanceCounter);
-
-            // Check if the object is within the specified radius
-            if (distance <= radius) {
-                results.push_back(dataObject); // Add a copy to the results
-            }
-        } catch (const std::exception& e) {
-            // Log error during distance calculation for a specific pair
-            cerr << "ERRO no cálculo de distância entre Query(" << queryObject.GetLabel()
-                 << ") e Data(" << dataObject.GetLabel() << "): " << e.what() << endl;
-            // Continue searching with the next object in the dataset
-        }
-    }
-    return results;
-}
-
-void writeComplexObjectsToPagedFile(const string& inputFile, const string& outputFile, size_t pageSize) {
-    // 1. Read data using VectorFileReader
-    VectorFileReader reader;
-    cout << "INFO: Reading input file '" << inputFile << "'..." << endl;
-    if (!reader.loadFromFile(inputFile)) {
-        cerr << "ERRO: Falha ao ler o arquivo de entrada com VectorFileReader." << endl;
-        return;
-    }
-
-    vector<TComplexObject> objects = reader.createVectorTComplexObject();
-    if (objects.empty()) {
-        cout << "AVISO: Nenhum objeto carregado do arquivo de entrada. Arquivo de saída não será criado." << endl;
-        return;
-    }
-    cout << "INFO: " << objects.size() << " objetos carregados." << endl;
-
-    // 2. Prepare for binary writing
-    ofstream outFile(outputFile, ios::binary | ios::trunc); // Truncate if exists
-    if (!outFile) {
-        cerr << "ERRO: Não foi possível abrir o arquivo de saída binário '" << outputFile << "'!" << endl;
-        return;
-    }
-
-    // 3. Write objects page by page
-    vector<uint8_t> pageBuffer(pageSize, 0); // Initialize buffer with zeros (padding)
-    size_t bufferIdx = 0; // Current position within the page buffer
-
-    cout << "INFO: Escrevendo objetos serializados no arquivo binário '" << outputFile << "'..." << endl;
-    for (TComplexObject& obj : objects) { // Iterate through objects (needs non-const for Serialize potentially)
-        const uint8_t* serialized_obj = obj.Serialize(); // Get serialized data
-        size_t obj_size = obj.GetSerializedSize();       // Get its size
-
-        // Sanity check: Object must fit within a page
-        if (obj_size > pageSize) {
-            cerr << "ERRO: Objeto serializado (Label: " << obj.GetLabel()
-                 << ", Size: " << obj_size << " bytes) é maior que o tamanho da página ("
-                 << pageSize << " bytes). Abortando." << endl;
-            outFile.close();
-            // Consider removing the partially written file
-            remove(outputFile.c_str());
-            return;
-        }
-
-        // Check if the object fits in the remaining space of the current page
-        if (bufferIdx + obj_size <= pageSize) {
-            // Fits: Copy object into the buffer
-            memcpy(pageBuffer.data() + bufferIdx, serialized_obj, obj_size);
-            bufferIdx += obj_size;
-        } else {
-            // Doesn't fit:
-            // 1. Pad the rest of the current buffer (optional, already zeros)
-            //    memset(pageBuffer.data() + bufferIdx, 0, pageSize - bufferIdx); // Already zeroed
-
-            // 2. Write the current (full) page to disk
-            outFile.write(reinterpret_cast<char*>(pageBuffer.data()), pageSize);
-            if (!outFile) {
-                 cerr << "ERRO: Falha ao escrever página no disco!" << endl;
-                 return; // Abort on write error
-            }
-
-            // 3. Reset buffer (fill with zeros again for padding)
-            memset(pageBuffer.data(), 0, pageSize);
-            bufferIdx = 0;
-
-            // 4. Copy the current object to the beginning of the new buffer
-            memcpy(pageBuffer.data() + bufferIdx, serialized_obj, obj_size);
-            bufferIdx += obj_size;
-        }
-    } // End of loop through objects
-
-    // Write the last partially filled (or full) page if it contains data
-    if (bufferIdx > 0) {
-        // Optional: Pad the remainder if not already padded
-        // memset(pageBuffer.data() + bufferIdx, 0, pageSize - bufferIdx);
-        outFile.write(reinterpret_cast<char*>(pageBuffer.data()), pageSize);
-         if (!outFile) {
-             cerr << "ERRO: Falha ao escrever a última página no disco!" << endl;
-             // Consider cleanup
-             return;
-         }
-    }
-
-    cout << "INFO: Escrita no arquivo binário concluída." << endl;
-    outFile.close();
-}
-
-/**
- * @brief Reads serialized TComplexObject data from a page-aligned binary file.
- * @param inputFile Path to the binary input file created by writeComplexObjectsToPagedFile.
- * @param pageSize The simulated disk page size in bytes (must match writer).
- * @param[out] pageAccessCount Reference to store the number of pages read.
- * @return A vector containing the deserialized TComplexObject instances.
- */
- vector<TComplexObject> readComplexObjectsFromPagedFile(const string& inputFile, size_t pageSize, int& pageAccessCount) {
-    pageAccessCount = 0; // Initialize page count
-
-    ifstream inFile(inputFile, ios::binary);
-    if (!inFile) {
-        cerr << "ERRO: Não foi possível abrir o arquivo binário de entrada '" << inputFile << "'!" << endl;
-        return {}; // Return empty vector on error
-    }
-
-    vector<TComplexObject> loadedObjects;
-    vector<uint8_t> pageBuffer(pageSize); // Buffer to hold one page
-    size_t pageBufferIdx = pageSize; // Start as if buffer is "empty" or fully processed
-
-    // cout << "INFO: Lendo objetos serializados do arquivo binário '" << inputFile << "'..." << endl;
-
-    // Loop reading page by page
-    while (true) {
-        // If the internal page buffer pointer is at the end, read a new page
-        if (pageBufferIdx >= pageSize) {
-            inFile.read(reinterpret_cast<char*>(pageBuffer.data()), pageSize);
-            if (inFile.gcount() == 0) { // Check if read failed or reached EOF immediately
-                 if(inFile.eof()){
-                    // Expected EOF if file size is multiple of page size and fully processed
-                     // cout << "DEBUG: EOF reached after processing full page." << endl;
-                 } else {
-                     cerr << "ERRO: Falha ao ler página do arquivo binário!" << endl;
-                 }
-                 break; // Stop reading
-            }
-             if (inFile.gcount() < static_cast<std::streamsize>(pageSize)) {
-                // Read less than a full page - likely the last partial page.
-                // Adjust effective buffer size for this last read.
-                // cout << "DEBUG: Read last partial page (" << inFile.gcount() << " bytes)." << endl;
-                 // For simplicity in this reader, we might just process what we can
-                 // or decide how to handle potentially incomplete objects at EOF.
-                 // If the writer *always* pads to pageSize, gcount() should always be pageSize until EOF.
-                 if (!inFile.eof()) { // If not EOF, it's a read error
-                    cerr << "ERRO: Leitura incompleta de página antes do EOF!" << endl;
-                    break;
-                 }
-            }
-            pageAccessCount++; // Count successful page read
-            pageBufferIdx = 0;  // Reset internal pointer to start of new page
-        }
-
-        // Try to deserialize objects from the current position within the page buffer
-        bool deserializedSomething = false;
-        while (pageBufferIdx < pageSize) {
-             // Check if enough bytes remain for the *fixed size header* of TComplexObject
-             // Header: Resolution (int), Data Size (size_t), Label Length (size_t)
-             const size_t HEADER_SIZE = sizeof(int) + 2 * sizeof(size_t);
-             if (pageBufferIdx + HEADER_SIZE > pageSize) {
-                 // Not enough space left in this page for even a header, need next page
-                 // cout << "DEBUG: Not enough space for header, breaking inner loop." << endl;
-                 pageBufferIdx = pageSize; // Force reading next page
-                 break;
-             }
-
-             // "Peek" at the header info without deserializing yet
-             int tempResolution;
-             size_t dataSize, labelLen;
-             size_t currentReadPos = pageBufferIdx;
-             memcpy(&tempResolution, pageBuffer.data() + currentReadPos, sizeof(int));
-             currentReadPos += sizeof(int);
-             memcpy(&dataSize, pageBuffer.data() + currentReadPos, sizeof(size_t));
-             currentReadPos += sizeof(size_t);
-             memcpy(&labelLen, pageBuffer.data() + currentReadPos, sizeof(size_t));
-             // currentReadPos += sizeof(size_t); // No need to advance read pos yet
-
-             // Calculate the full expected size of this object
-             size_t expectedObjSize = HEADER_SIZE + labelLen + (dataSize * sizeof(double));
-
-             // Check if the object starts with resolution 0 AND has 0 size/length.
-             // This *might* indicate padding if we used zeros. Be cautious with this check.
-             // A safer approach is needed if valid objects can have resolution 0 and empty data/label.
-             // Let's assume valid objects have *some* size or non-zero resolution for now.
-             // If resolution is 0 AND expectedObjSize == HEADER_SIZE, it's likely padding.
-             if (tempResolution == 0 && expectedObjSize == HEADER_SIZE) {
-                 // Potential padding detected, skip to next page.
-                 // This assumes padding starts with 0 for resolution.
-                 // If valid objects can have resolution 0, this logic fails.
-                 // cout << "DEBUG: Potential padding detected, breaking inner loop." << endl;
-                 pageBufferIdx = pageSize; // Force reading next page
-                 break;
-             }
-
-             // Check if the *entire* object fits within the bounds of the current page buffer
-             if (pageBufferIdx + expectedObjSize <= pageSize) {
-                 // Object fits entirely within the current page buffer segment
-                 try {
-                     TComplexObject obj;
-                     obj.Unserialize(pageBuffer.data() + pageBufferIdx, expectedObjSize);
-                     loadedObjects.push_back(obj);
-                     pageBufferIdx += expectedObjSize; // Advance pointer past the object
-                     deserializedSomething = true;
-                 } catch (const std::exception& e) {
-                     cerr << "ERRO: Falha ao deserializar objeto na posição " << pageBufferIdx
-                          << " da página " << pageAccessCount << ". Erro: " << e.what() << endl;
-                     // Critical error - stop processing this page / file?
-                     pageBufferIdx = pageSize; // Move to next page, hoping it recovers
-                     break;
-                 }
-             } else {
-                 // Object calculated size extends beyond the current page buffer.
-                 // Since the writer ensures objects don't span pages, this signifies
-                 // the end of valid data in this page (or a read error/corruption).
-                 // cout << "DEBUG: Object spans page boundary (or end of data in page), breaking inner loop." << endl;
-                 pageBufferIdx = pageSize; // Force reading next page
-                 break;
-             }
-        } // End while(pageBufferIdx < pageSize)
-
-        // If we iterated through the whole page buffer and didn't deserialize anything,
-        // it might mean we only read padding on the last read. Stop.
-        // (This check might be redundant depending on EOF handling).
-        // if (!deserializedSomething && pageBufferIdx >= pageSize) {
-            // break;
-        //}
-
-    } // End while(true) reading pages
-
-    // cout << "INFO: Leitura do arquivo binário concluída." << endl;
-    // cout << "INFO: Total de objetos deserializados: " << loadedObjects.size() << endl;
-
-    inFile.close();
-    return loadedObjects;
-}
-
-
 //===========================================================================
 //                           FUNÇÃO MAIN
 //===========================================================================
 int main(int argc, char* argv[]) {
 
     // --- Argument Parsing ---
-    if (argc < 5) {
-        cerr << "Uso: " << argv[0] << " <pageSize> <searchRadius> <queryFilePath>" << endl;
+    // Argumentos posicionais, seguidos (ou intercalados) de opções "--nome valor"
+    vector<string> positionalArgs;
+    vector<pair<string, string>> optionArgs;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            string value = (i + 1 < argc) ? argv[++i] : "";
+            optionArgs.emplace_back(arg, value);
+        } else {
+            positionalArgs.push_back(arg);
+        }
+    }
+
+    if (positionalArgs.size() < 4) {
+        cerr << "Uso: " << argv[0] << " <pageSize> <searchRadius> <dataFilePath> <queryFilePath> [opções]" << endl;
         cerr << "Exemplo: " << argv[0] << " 4096 100.0 ../data/queries/query_10.txt" << endl;
          cerr << "   <pageSize>: Tamanho da página de disco simulada em bytes (ex: 4096, 8192, 131072)." << endl;
          cerr << "   <searchRadius>: Raio para a busca de vizinhos (ex: 50.0, 1000.0)." << endl;
-         cerr << "   <dataFilePath>: Caminho para o arquivo texto contendo os objetos do dataset." << endl;
+         cerr << "   <dataFilePath>: Caminho para o arquivo texto contendo os objetos do dataset (ou a versão binária gerada por convert_dataset)." << endl;
          cerr << "   <queryFilePath>: Caminho para o arquivo texto contendo os objetos de consulta (mesmo formato do dataset)." << endl;
+         cerr << "Opções:" << endl;
+         cerr << "   --detail-levels N: Grava apenas o bloco de aproximação e N níveis de detalhe por objeto (padrão: todos os coeficientes)." << endl;
+         cerr << "   --label-store F: Grava os labels no arquivo F e apenas o ID do objeto nas páginas (requer formato 2)." << endl;
+         cerr << "   --coefficients C: Armazena os coeficientes como 'double' (padrão) ou 'int' (inteiros escalados por 2^resolução, sem perda)." << endl;
+         cerr << "   --reader R: Leitura das páginas por 'stream' (padrão, deserializa cada objeto), 'mmap' (mapeia o arquivo e calcula sobre os bytes) ou 'async' (várias leituras em andamento)." << endl;
+         cerr << "   --queue-depth N: Leituras de página em andamento no modo 'async' (padrão: 8)." << endl;
+         cerr << "   --io-mode M: 'buffered' (padrão) ou 'direct' (O_DIRECT, ignora o cache de páginas; usa a leitura 'async' e exige pageSize múltiplo de 4096)." << endl;
+         cerr << "   --cache C: 'warm' (padrão) ou 'cold' (descarta o arquivo do cache de páginas antes de cada passada)." << endl;
+         cerr << "   --io-engine E: Motor do modo 'async': 'auto' (padrão), 'io_uring' ou 'threads' (pread em um pool de threads)." << endl;
+         cerr << "   --page-format P: Layout das páginas, 'plain' (objetos + preenchimento, padrão) ou 'slotted' (cabeçalho, slots e zone map)." << endl;
+         cerr << "   --zone-map M: Coeficientes de aproximação resumidos no zone map de cada página 'slotted' (padrão: 8; 0 desativa)." << endl;
+         cerr << "   --threads N: Divide as páginas do arquivo entre N threads em cada passada (padrão: 1)." << endl;
+         cerr << "   --batch N: Avalia N consultas por leitura do arquivo (0 = todas em uma única passada; padrão: 1)." << endl;
+         cerr << "   --coarse-tier M: Grava uma cópia grossa do dataset (até M coeficientes por objeto) e filtra por ela antes de ler as páginas (0 desativa, padrão)." << endl;
+         cerr << "   --results-file F: Grava em F os pares (consulta, ID do objeto, distância) de cada resultado; requer --label-store, que numera os objetos na ordem do dataset." << endl;
+         cerr << "   --knn K: Busca os K vizinhos mais próximos de cada consulta em vez da busca por raio (searchRadius é ignorado)." << endl;
+         cerr << "   --resolution R: Leva os objetos do dataset à resolução R ao ler o arquivo (transformada de Haar; permite usar um único arquivo na resolução 0)." << endl;
+         cerr << "   --query-resolution R: O mesmo para os objetos de consulta (padrão: a resolução do arquivo)." << endl;
+         cerr << "   --ingest-threads N: Threads que aplicam a transformada ao gravar o dataset (padrão: 0 = automático)." << endl;
+         cerr << "   --serial-format V: Formato de serialização dos objetos, 1 (original) ou 2 (compacto, padrão)." << endl;
         return 1;
     }
 
     size_t pageSize = 4096; // Default page size
     double searchRadius = 0.0;
     string queryFilePath, dataInputFile;
+    int detailLevels = -1; // -1 = todos os coeficientes
+    int serialFormat = TComplexObject::GetSerialFormat();
+    string labelStoreFile; // Vazio = labels dentro das páginas
+    string resultsFile;    // Vazio = só conta os resultados
+    string coefficientMode = "double";
+    size_t batchSize = 1; // Consultas por passada sobre o arquivo (0 = todas)
+    string readerMode = "stream";
+    PageReaderOptions readerOptions;
+    string ioEngine = "auto";
+    string ioMode = "buffered";
+    string cacheMode = "warm";
+    size_t threadCount = 1;
+    string pageFormat = "plain";
+    size_t zoneCount = 8;
+    size_t knnCount = 0; // 0 = busca por raio
+    size_t coarseCoefficients = 0; // 0 = sem camada grossa
+    int dataResolution = -1;  // -1 = resolução do arquivo de dados
+    int queryResolution = -1; // -1 = resolução do arquivo de consulta
+    size_t ingestThreads = 0; // 0 = conforme o número de CPUs
 
     try {
-        pageSize = std::stoul(argv[1]); // Use stoul for unsigned long (size_t)
-        searchRadius = std::stod(argv[2]); // Use stod for double
-        dataInputFile = argv[3];
-        queryFilePath = argv[4];
+        pageSize = std::stoul(positionalArgs[0]); // Use stoul for unsigned long (size_t)
+        searchRadius = std::stod(positionalArgs[1]); // Use stod for double
+        dataInputFile = positionalArgs[2];
+        queryFilePath = positionalArgs[3];
+
+        for (const auto& [name, value] : optionArgs) {
+            if (name == "--detail-levels") {
+                detailLevels = std::stoi(value);
+            } else if (name == "--batch") {
+                batchSize = std::stoul(value);
+            } else if (name == "--coarse-tier") {
+                coarseCoefficients = std::stoul(value);
+            } else if (name == "--knn") {
+                knnCount = std::stoul(value);
+            } else if (name == "--resolution") {
+                dataResolution = std::stoi(value);
+            } else if (name == "--ingest-threads") {
+                ingestThreads = std::stoul(value);
+            } else if (name == "--query-resolution") {
+                queryResolution = std::stoi(value);
+            } else if (name == "--page-format") {
+                pageFormat = value;
+            } else if (name == "--zone-map") {
+                zoneCount = std::stoul(value);
+            } else if (name == "--threads") {
+                threadCount = std::stoul(value);
+            } else if (name == "--reader") {
+                readerMode = value;
+            } else if (name == "--queue-depth") {
+                readerOptions.queueDepth = std::stoul(value);
+            } else if (name == "--io-engine") {
+                ioEngine = value;
+            } else if (name == "--io-mode") {
+                ioMode = value;
+            } else if (name == "--cache") {
+                cacheMode = value;
+            } else if (name == "--coefficients") {
+                coefficientMode = value;
+            } else if (name == "--label-store") {
+                labelStoreFile = value;
+            } else if (name == "--results-file") {
+                resultsFile = value;
+            } else if (name == "--serial-format") {
+                serialFormat = std::stoi(value);
+            } else {
+                cerr << "AVISO: Opção desconhecida ignorada: " << name << endl;
+            }
+        }
     } catch (const std::invalid_argument& e) {
         cerr << "ERRO: Argumento inválido. Verifique se pageSize é um inteiro positivo e searchRadius é um número." << endl;
         return 1;
@@ -466,21 +172,142 @@ int main(int argc, char* argv[]) {
 
     // --- Configuration ---
     string dataOutputFile = "complex_objects_paged.dat"; // Output binary file for dataset
+    TComplexObject::SetStoredDetailLevels(detailLevels);
+    try {
+        TComplexObject::SetSerialFormat(serialFormat);
+    } catch (const std::invalid_argument& e) {
+        cerr << "ERRO: --serial-format deve ser 1 ou 2." << endl;
+        return 1;
+    }
+    cout << "INFO: Formato de serialização: v" << serialFormat << endl;
+    if (coefficientMode != "double" && coefficientMode != "int") {
+        cerr << "ERRO: --coefficients deve ser 'double' ou 'int'." << endl;
+        return 1;
+    }
+    TComplexObject::SetIntegerCoefficients(coefficientMode == "int");
+    if (coefficientMode == "int") {
+        cout << "INFO: Coeficientes inteiros (escala 2^resolução) quando exatos." << endl;
+    }
+    if (readerMode == "stream") {
+        readerOptions.mode = PageReaderOptions::READER_STREAM;
+    } else if (readerMode == "mmap") {
+        readerOptions.mode = PageReaderOptions::READER_MMAP;
+    } else if (readerMode == "async") {
+        readerOptions.mode = PageReaderOptions::READER_ASYNC;
+    } else {
+        cerr << "ERRO: --reader deve ser 'stream', 'mmap' ou 'async'." << endl;
+        return 1;
+    }
+    if (!TAsyncPageReader::ParseEngine(ioEngine, readerOptions.engine)) {
+        cerr << "ERRO: --io-engine deve ser 'auto', 'io_uring' ou 'threads'." << endl;
+        return 1;
+    }
+    if (readerOptions.queueDepth == 0) {
+        readerOptions.queueDepth = 1;
+    }
+    if (ioMode != "buffered" && ioMode != "direct") {
+        cerr << "ERRO: --io-mode deve ser 'buffered' ou 'direct'." << endl;
+        return 1;
+    }
+    readerOptions.directIO = (ioMode == "direct");
+    if (readerOptions.directIO) {
+        if (pageSize % ASYNC_PAGE_ALIGNMENT != 0) {
+            cerr << "ERRO: --io-mode direct exige pageSize múltiplo de " << ASYNC_PAGE_ALIGNMENT << "." << endl;
+            return 1;
+        }
+        if (readerOptions.mode != PageReaderOptions::READER_ASYNC) {
+            cout << "INFO: --io-mode direct usa a leitura 'async' (buffers alinhados)." << endl;
+            readerMode = "async";
+            readerOptions.mode = PageReaderOptions::READER_ASYNC;
+        }
+    }
+    if (cacheMode != "warm" && cacheMode != "cold") {
+        cerr << "ERRO: --cache deve ser 'warm' ou 'cold'." << endl;
+        return 1;
+    }
+    const bool coldCache = (cacheMode == "cold");
+    const bool viewReader = (readerOptions.mode != PageReaderOptions::READER_STREAM);
+    if (pageFormat != "plain" && pageFormat != "slotted") {
+        cerr << "ERRO: --page-format deve ser 'plain' ou 'slotted'." << endl;
+        return 1;
+    }
+    const bool slottedPages = (pageFormat == "slotted");
+    if (coarseCoefficients > 0 && knnCount > 0) {
+        cerr << "ERRO: --coarse-tier só está disponível na busca por raio." << endl;
+        return 1;
+    }
+    if (detailLevels >= 0) {
+        cout << "INFO: Armazenamento truncado: aproximação + " << detailLevels << " nível(is) de detalhe." << endl;
+    }
 
     // --- Writing Dataset (Optional) ---
     cout << "========= ESCREVENDO DADOS DO DATASET EM PÁGINAS =========" << endl;
-    writeComplexObjectsToPagedFile(dataInputFile, dataOutputFile, pageSize);
+    TLabelStore labelStore;
+    if (!resultsFile.empty() && labelStoreFile.empty()) {
+        // Os pares precisam do ID de cada objeto, que só o arquivo de labels
+        // atribui; criá-lo aqui mudaria o formato das páginas medidas
+        cerr << "ERRO: --results-file requer --label-store (os IDs dos objetos vêm do arquivo de labels)." << endl;
+        return 1;
+    }
+    if (!resultsFile.empty() && serialFormat == 1) {
+        cerr << "ERRO: --results-file requer o formato de serialização 2 (IDs dos objetos)." << endl;
+        return 1;
+    }
+    if (!labelStoreFile.empty()) {
+        if (!labelStore.Open(labelStoreFile, true)) {
+            cerr << "ERRO: Não foi possível criar o arquivo de labels '" << labelStoreFile << "'." << endl;
+            return 1;
+        }
+        cout << "INFO: Labels gravados em '" << labelStoreFile << "'." << endl;
+    }
+    // A camada grossa fica ao lado do arquivo de páginas
+    string coarseTierFile = "complex_objects_coarse.dat";
+    TCoarseTierWriter coarseTierWriter(coarseCoefficients);
+    if (coarseCoefficients > 0 && !coarseTierWriter.Open(coarseTierFile)) {
+        cerr << "ERRO: Não foi possível criar a camada grossa '" << coarseTierFile << "'." << endl;
+        return 1;
+    }
+    writeComplexObjectsToPagedFile(dataInputFile, dataOutputFile, pageSize,
+                                   labelStore.IsOpen() ? &labelStore : nullptr, slottedPages, zoneCount,
+                                   coarseCoefficients > 0 ? &coarseTierWriter : nullptr, dataResolution,
+                                   ingestThreads);
+    TCoarseTier coarseTier;
+    if (coarseCoefficients > 0) {
+        if (!coarseTierWriter.Close() || !coarseTier.Load(coarseTierFile)) {
+            cerr << "ERRO: Falha ao gravar a camada grossa '" << coarseTierFile << "'." << endl;
+            return 1;
+        }
+        cout << "INFO: Camada grossa '" << coarseTierFile << "': " << coarseTier.GetCount() << " objetos, "
+             << coarseTier.GetFileSize() << " bytes (até " << coarseCoefficients << " coeficiente(s) por objeto)." << endl;
+    }
+    // Os zone maps ficam em memória (lidos uma vez, fora da contagem de
+    // acessos) e decidem quais páginas cada consulta precisa ler
+    vector<PageZone> pageZones;
+    if (slottedPages) {
+        pageZones = loadPageZones(dataOutputFile, pageSize);
+        size_t zonedPages = 0;
+        for (const PageZone& zone : pageZones) {
+            zonedPages += (zone.resolution != SLOTTED_PAGE_NO_ZONE);
+        }
+        cout << "INFO: Páginas com cabeçalho: " << pageZones.size() << " (" << zonedPages
+             << " com zone map de " << zoneCount << " coeficiente(s))." << endl;
+    }
     cout << "=========================================================\n" << endl;
 
     // --- Reading Query Data ---
     cout << "========= LENDO DADOS DE CONSULTA =========" << endl;
     VectorFileReader queryReader;
+    queryReader.setTargetResolution(queryResolution);
     cout << "INFO: Lendo arquivo de consulta '" << queryFilePath << "'..." << endl;
-    if (!queryReader.loadFromFile(queryFilePath)) {
+    vector<TComplexObject> queryData;
+    bool queriesRead = queryReader.forEachObject(queryFilePath, [&](TComplexObject& query) {
+        queryData.push_back(query); // Única cópia de cada consulta
+        return true;
+    });
+    if (!queriesRead) {
         cerr << "ERRO: Falha ao ler o arquivo de consulta com VectorFileReader." << endl;
         return 1;
     }
-    vector<TComplexObject> queryData = queryReader.createVectorTComplexObject();
     if (queryData.empty()) {
         cout << "AVISO: Nenhum objeto carregado do arquivo de consulta. Nenhuma busca será realizada." << endl;
         return 0;
@@ -490,35 +317,155 @@ int main(int argc, char* argv[]) {
 
 
     // --- Performing Sequential Range Search ---
-    cout << "========= REALIZANDO BUSCA SEQUENCIAL POR RAIO =========" << endl;
-    cout << "Raio de busca: " << fixed << setprecision(4) << searchRadius << endl;
+    cout << fixed << setprecision(4);
+    if (knnCount > 0) {
+        cout << "========= REALIZANDO BUSCA SEQUENCIAL DOS K VIZINHOS =========" << endl;
+        cout << "Vizinhos (k): " << knnCount << endl;
+    } else {
+        cout << "========= REALIZANDO BUSCA SEQUENCIAL POR RAIO =========" << endl;
+        cout << "Raio de busca: " << searchRadius << endl;
+    }
+    cout << "Kernel de distância: " << manhattanKernelName() << endl;
+    if (batchSize == 0 || batchSize > queryData.size()) {
+        batchSize = queryData.size();
+    }
+    cout << "Consultas por passada: " << batchSize << endl;
+    cout << "Leitura das páginas: " << readerMode << endl;
+    if (readerOptions.mode == PageReaderOptions::READER_ASYNC) {
+        TAsyncPageReader probe(pageSize, readerOptions.queueDepth, readerOptions.engine, readerOptions.directIO);
+        if (!probe.Open(dataOutputFile)) {
+            cerr << "ERRO: Motor de leitura '" << ioEngine << "' indisponível." << endl;
+            return 1;
+        }
+        cout << "Motor de E/S: " << probe.GetEngineName() << " (profundidade " << readerOptions.queueDepth
+             << (readerOptions.directIO ? ", O_DIRECT" : "") << ")" << endl;
+    }
+    cout << "Cache de páginas: " << cacheMode << endl;
+    if (coarseCoefficients > 0) {
+        cout << "Camada grossa: " << coarseTier.GetCoefficientCount() << " coeficiente(s)" << endl;
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    cout << "Threads: " << threadCount << endl;
 
     // TComplexObjectDistanceEvaluator distEval; // REMOVIDO
     long long totalDistanceCalculations = 0;    // Contador local
+    long long totalCoarseCalculations = 0;      // Comparações com a camada grossa
     size_t totalFoundObjects = 0;
 
+    // Um destino por consulta: só a contagem, ou os pares (ID, distância)
+    vector<unique_ptr<TResultSink>> querySinks;
+    for (size_t q = 0; q < queryData.size(); ++q) {
+        if (resultsFile.empty()) {
+            querySinks.emplace_back(new TCountResultSink());
+        } else {
+            querySinks.emplace_back(new TPairResultSink());
+        }
+    }
+
+    // Descarta os arquivos lidos do cache de páginas antes de cada passada
+    // (--cache cold). O tempo gasto é descontado do tempo da busca.
+    std::chrono::steady_clock::duration evictionTime(0);
+    bool evictionWarned = false;
+    auto evictColdCache = [&]() {
+        std::chrono::steady_clock::time_point evictBegin = std::chrono::steady_clock::now();
+        bool evicted = evictFileFromPageCache(dataOutputFile);
+        if (coarseCoefficients > 0) {
+            evicted = evictFileFromPageCache(coarseTierFile) && evicted;
+        }
+        evictionTime += std::chrono::steady_clock::now() - evictBegin;
+        if (!evicted && !evictionWarned) {
+            cerr << "AVISO: Não foi possível descartar '" << dataOutputFile << "' do cache de páginas." << endl;
+            evictionWarned = true;
+        }
+    };
+
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
     int queryCount = 0;
     int pagesReadTotal = 0;
 
-    for (TComplexObject& queryObj : queryData) {
-        int pagesRead = 0;
+    if (batchSize > 1 || viewReader || threadCount > 1 || slottedPages || knnCount > 0 ||
+        coarseCoefficients > 0) {
+        // Modo em lote: cada página é lida uma vez por grupo de consultas.
+        // Cada consulta do grupo conta as páginas que examinou, como na busca
+        // individual, para que disk_access continue comparável. As leituras
+        // por mmap e assíncrona sempre passam por aqui (grupos de uma
+        // consulta quando --batch é 1), já que não montam cópias do dataset,
+        // assim como a busca com várias threads, que divide as páginas de
+        // cada passada, a leitura de páginas com zone map, que pula
+        // páginas por consulta, a busca dos k vizinhos e a busca em duas
+        // camadas, que só lê as páginas com candidatos.
+        for (size_t first = 0; first < queryData.size(); first += batchSize) {
+            size_t last = std::min(first + batchSize, queryData.size());
+            vector<TComplexObject*> group;
+            vector<TResultSink*> groupSinks;
+            for (size_t q = first; q < last; ++q) {
+                group.push_back(&queryData[q]);
+                groupSinks.push_back(querySinks[q].get());
+            }
+            int pagesRead = 0;
+            if (coldCache) {
+                evictColdCache();
+            }
+            const vector<PageZone>* zones = pageZones.empty() ? nullptr : &pageZones;
+            if (knnCount > 0) {
+                parallelNearestSearch(dataOutputFile, pageSize, group, knnCount, groupSinks,
+                                      totalDistanceCalculations, pagesRead, readerOptions, threadCount, zones);
+            } else if (coarseCoefficients > 0) {
+                tieredRangeSearch(dataOutputFile, coarseTier, pageSize, group, searchRadius, groupSinks,
+                                  totalDistanceCalculations, totalCoarseCalculations, pagesRead,
+                                  readerOptions, threadCount);
+            } else {
+                parallelRangeSearch(dataOutputFile, pageSize, group, searchRadius, groupSinks,
+                                    totalDistanceCalculations, pagesRead, readerOptions, threadCount, zones);
+            }
+            pagesReadTotal += pagesRead; // Já somado por consulta
+            queryCount += static_cast<int>(group.size());
+        }
+    } else {
+        for (size_t q = 0; q < queryData.size(); ++q) {
+            TComplexObject& queryObj = queryData[q];
+            int pagesRead = 0;
+            if (coldCache) {
+                evictColdCache();
+            }
 
-        vector<TComplexObject> loadedData = readComplexObjectsFromPagedFile(dataOutputFile, pageSize, pagesRead);
-        pagesReadTotal += pagesRead;
-        queryCount++;
+            vector<TComplexObject> loadedData = readComplexObjectsFromPagedFile(dataOutputFile, pageSize, pagesRead);
+            pagesReadTotal += pagesRead;
+            queryCount++;
 
-        // Perform the search for the current query object, passing the counter
-        vector<TComplexObject> foundObjects = sequentialRangeSearch(loadedData, queryObj, searchRadius, totalDistanceCalculations);
+            // Perform the search for the current query object, passing the counter
+            sequentialRangeSearch(loadedData, queryObj, searchRadius, *querySinks[q], totalDistanceCalculations);
 
-        // Report results for this query
-        // cout << "Consulta " << queryCount << " (Label: " << queryObj.GetLabel() << "): Encontrados " << foundObjects.size() << " objetos dentro do raio." << endl;
-        totalFoundObjects += foundObjects.size();
-    } // End loop through query objects
+            // Report results for this query
+            // cout << "Consulta " << queryCount << " (Label: " << queryObj.GetLabel() << "): Encontrados " << querySinks[q]->GetCount() << " objetos dentro do raio." << endl;
+        } // End loop through query objects
+    }
 
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin - evictionTime).count();
+
+    for (const unique_ptr<TResultSink>& sink : querySinks) {
+        totalFoundObjects += sink->GetCount();
+    }
+    if (!resultsFile.empty()) {
+        ofstream resultsOut(resultsFile, ios::trunc);
+        // Distâncias com todos os dígitos, para comparar execuções bit a bit
+        resultsOut << setprecision(numeric_limits<double>::max_digits10);
+        for (size_t q = 0; q < querySinks.size(); ++q) {
+            const TPairResultSink& pairs = static_cast<const TPairResultSink&>(*querySinks[q]);
+            for (const TResultPair& pair : pairs.GetPairs()) {
+                resultsOut << q << " " << pair.ObjectID << " " << pair.Distance << "\n";
+            }
+        }
+        if (!resultsOut) {
+            cerr << "ERRO: Falha ao gravar os resultados em '" << resultsFile << "'." << endl;
+            return 1;
+        }
+        cout << "INFO: Pares (consulta, ID, distância) gravados em '" << resultsFile << "'." << endl;
+    }
 
     cout << "\n--- Estatísticas da Busca Sequencial ---" << endl;
     cout << "Número total de consultas realizadas: " << queryData.size() << endl;
@@ -533,8 +480,17 @@ int main(int argc, char* argv[]) {
     std::cout << "\t\"" << "avg_time" << "\" : " << duration_ms/queryData.size() << "," << std::endl;
     std::cout << "\t\"" << "disk_access" << "\" : " << double(pagesReadTotal)/queryData.size() << "," << std::endl;
     std::cout << "\t\"" << "avg_dist_calc" << "\" : " << double(totalDistanceCalculations)/queryData.size() << "," << std::endl;
+    if (coarseCoefficients > 0) {
+        std::cout << "\t\"" << "avg_coarse_dist_calc" << "\" : " << double(totalCoarseCalculations)/queryData.size() << "," << std::endl;
+    }
     std::cout << "\t\"" << "avg_obj_result" << "\" : " << double(totalFoundObjects)/queryData.size() << "," << std::endl;
-    std::cout << "\t\"" << "radius" << "\" : " << searchRadius << "," << std::endl;
+    if (knnCount > 0) {
+        std::cout << "\t\"" << "k" << "\" : " << knnCount << "," << std::endl;
+    } else {
+        std::cout << "\t\"" << "radius" << "\" : " << searchRadius << "," << std::endl;
+    }
+    std::cout << "\t\"" << "cache" << "\" : \"" << cacheMode << "\"," << std::endl;
+    std::cout << "\t\"" << "io_mode" << "\" : \"" << ioMode << "\"," << std::endl;
     std::cout << "\t\"" << "num_consults" << "\" : " << queryData.size() << std::endl;
     std::cout << "}";
     std::cout << "\n================JSON================\n";
@@ -0,0 +1,169 @@
+#include "slotted_page.h"
+
+#include <algorithm> // for std::min, std::max
+#include <cstring>   // for memcpy, memset
+#include <stdexcept> // for std::runtime_error
+
+// Header field offsets
+static const size_t OFFSET_MAGIC = 0;
+static const size_t OFFSET_COUNT = 4;
+static const size_t OFFSET_ZONE_COUNT = 8;
+static const size_t OFFSET_ZONE_RESOLUTION = 10;
+static const size_t OFFSET_DATA_END = 12;
+
+size_t slottedPageHeaderSize(size_t zoneCount) {
+    return SLOTTED_PAGE_HEADER_SIZE + 2 * zoneCount * sizeof(double);
+}
+
+double zoneLowerBound(const double* zoneMin, const double* zoneMax, const double* query, size_t count) {
+    double bound = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        if (query[i] < zoneMin[i]) {
+            bound += zoneMin[i] - query[i];
+        } else if (query[i] > zoneMax[i]) {
+            bound += query[i] - zoneMax[i];
+        }
+    }
+    return bound;
+}
+
+//---------------------------------------------------------------------------
+// Class TSlottedPageWriter
+//---------------------------------------------------------------------------
+
+TSlottedPageWriter::TSlottedPageWriter(size_t pageSize, size_t zoneCount) :
+    Page(pageSize, 0), ZoneCount(std::min<size_t>(zoneCount, UINT16_MAX)), Count(0),
+    DataEnd(0), ZoneResolution(SLOTTED_PAGE_NO_ZONE) {
+    // No room for a zone map: the page keeps only the slots
+    if (slottedPageHeaderSize(ZoneCount) + sizeof(uint32_t) > pageSize) {
+        ZoneCount = 0;
+    }
+    ZoneMin.resize(ZoneCount);
+    ZoneMax.resize(ZoneCount);
+    Clear();
+}
+
+size_t TSlottedPageWriter::GetCapacity() const {
+    const size_t used = slottedPageHeaderSize(ZoneCount) + sizeof(uint32_t);
+    return (Page.size() > used) ? Page.size() - used : 0;
+}
+
+bool TSlottedPageWriter::Add(const uint8_t* object, size_t size, int resolution,
+                             const double* approx, size_t approxCount) {
+    // Every object starts 8-byte aligned; the padding was zeroed by Clear()
+    const size_t start = (DataEnd + 7) & ~size_t(7);
+    const size_t slotsEnd = Page.size() - (Count + 1) * sizeof(uint32_t);
+    if (start > slotsEnd || size > slotsEnd - start) {
+        return false;
+    }
+    memcpy(Page.data() + start, object, size);
+    const uint32_t offset = static_cast<uint32_t>(start);
+    memcpy(Page.data() + slotsEnd, &offset, sizeof(uint32_t));
+    DataEnd = start + size;
+
+    // The zone map only holds while every object shares its resolution
+    const bool summarizable = ZoneCount > 0 && approx != nullptr && approxCount >= ZoneCount &&
+                              resolution >= 0 && resolution <= INT16_MAX;
+    if (Count == 0) {
+        if (summarizable) {
+            ZoneResolution = resolution;
+            std::copy(approx, approx + ZoneCount, ZoneMin.begin());
+            std::copy(approx, approx + ZoneCount, ZoneMax.begin());
+        }
+    } else if (ZoneResolution != SLOTTED_PAGE_NO_ZONE) {
+        if (!summarizable || resolution != ZoneResolution) {
+            ZoneResolution = SLOTTED_PAGE_NO_ZONE;
+        } else {
+            for (size_t i = 0; i < ZoneCount; ++i) {
+                ZoneMin[i] = std::min(ZoneMin[i], approx[i]);
+                ZoneMax[i] = std::max(ZoneMax[i], approx[i]);
+            }
+        }
+    }
+    Count++;
+    return true;
+}
+
+const uint8_t* TSlottedPageWriter::Finish() {
+    const uint32_t magic = SLOTTED_PAGE_MAGIC;
+    const uint32_t count = static_cast<uint32_t>(Count);
+    const uint16_t zoneCount = static_cast<uint16_t>(ZoneCount);
+    const int16_t zoneResolution = static_cast<int16_t>(ZoneResolution);
+    const uint32_t dataEnd = static_cast<uint32_t>(DataEnd);
+    memcpy(Page.data() + OFFSET_MAGIC, &magic, sizeof(magic));
+    memcpy(Page.data() + OFFSET_COUNT, &count, sizeof(count));
+    memcpy(Page.data() + OFFSET_ZONE_COUNT, &zoneCount, sizeof(zoneCount));
+    memcpy(Page.data() + OFFSET_ZONE_RESOLUTION, &zoneResolution, sizeof(zoneResolution));
+    memcpy(Page.data() + OFFSET_DATA_END, &dataEnd, sizeof(dataEnd));
+    if (ZoneCount > 0) {
+        memcpy(Page.data() + SLOTTED_PAGE_HEADER_SIZE, ZoneMin.data(), ZoneCount * sizeof(double));
+        memcpy(Page.data() + SLOTTED_PAGE_HEADER_SIZE + ZoneCount * sizeof(double),
+               ZoneMax.data(), ZoneCount * sizeof(double));
+    }
+    return Page.data();
+}
+
+void TSlottedPageWriter::Clear() {
+    memset(Page.data(), 0, Page.size());
+    Count = 0;
+    DataEnd = slottedPageHeaderSize(ZoneCount);
+    ZoneResolution = SLOTTED_PAGE_NO_ZONE;
+}
+
+//---------------------------------------------------------------------------
+// Class TSlottedPageView
+//---------------------------------------------------------------------------
+
+bool TSlottedPageView::IsSlottedPage(const uint8_t* page, size_t pageSize) {
+    if (page == nullptr || pageSize < SLOTTED_PAGE_HEADER_SIZE) {
+        return false;
+    }
+    uint32_t magic;
+    memcpy(&magic, page + OFFSET_MAGIC, sizeof(magic));
+    return magic == SLOTTED_PAGE_MAGIC;
+}
+
+TSlottedPageView::TSlottedPageView(const uint8_t* page, size_t pageSize) :
+    Page(page), PageSize(pageSize) {
+    if (!IsSlottedPage(page, pageSize)) {
+        throw std::runtime_error("Buffer does not hold a slotted page.");
+    }
+    uint32_t count, dataEnd;
+    uint16_t zoneCount;
+    int16_t zoneResolution;
+    memcpy(&count, page + OFFSET_COUNT, sizeof(count));
+    memcpy(&zoneCount, page + OFFSET_ZONE_COUNT, sizeof(zoneCount));
+    memcpy(&zoneResolution, page + OFFSET_ZONE_RESOLUTION, sizeof(zoneResolution));
+    memcpy(&dataEnd, page + OFFSET_DATA_END, sizeof(dataEnd));
+
+    Count = count;
+    DataEnd = dataEnd;
+    ZoneCount = zoneCount;
+    ZoneResolution = zoneResolution;
+    const size_t headerSize = slottedPageHeaderSize(ZoneCount);
+    if (headerSize > pageSize || DataEnd < headerSize || DataEnd > pageSize ||
+        Count > (pageSize - DataEnd) / sizeof(uint32_t)) {
+        throw std::runtime_error("Corrupted slotted page header.");
+    }
+    ZoneMin = reinterpret_cast<const double*>(page + SLOTTED_PAGE_HEADER_SIZE);
+    ZoneMax = ZoneMin + ZoneCount;
+}
+
+uint32_t TSlottedPageView::GetSlot(size_t slot) const {
+    uint32_t offset;
+    memcpy(&offset, Page + PageSize - (slot + 1) * sizeof(uint32_t), sizeof(offset));
+    return offset;
+}
+
+const uint8_t* TSlottedPageView::GetObject(size_t slot, size_t& size) const {
+    if (slot >= Count) {
+        throw std::out_of_range("Slot out of range.");
+    }
+    const size_t start = GetSlot(slot);
+    const size_t end = (slot + 1 < Count) ? GetSlot(slot + 1) : DataEnd;
+    if (start < slottedPageHeaderSize(ZoneCount) || end < start || end > DataEnd) {
+        throw std::runtime_error("Corrupted slot in slotted page.");
+    }
+    size = end - start;
+    return Page + start;
+}
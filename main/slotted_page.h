@@ -0,0 +1,161 @@
+#ifndef SLOTTED_PAGE_H
+#define SLOTTED_PAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Slotted page layout
+//---------------------------------------------------------------------------
+/**
+* Page layout used by the sequential scan for serialized TComplexObject
+* instances:
+*
+* <CODE>
+* +--------+-------+------+-----+---------+----------+----------+---------+------+-------------+
+* | Magic  | Count | M    | Res | DataEnd | ZoneMin  | ZoneMax  | Objects | Free | Slots[Count]|
+* +--------+-------+------+-----+---------+----------+----------+---------+------+-------------+
+* </CODE>
+* Magic, Count and DataEnd are uint32_t, M is a uint16_t and Res an
+* int16_t (SLOTTED_PAGE_HEADER_SIZE bytes). ZoneMin and ZoneMax hold M
+* doubles each: the per-coordinate minimum and maximum of the first M
+* approximation coefficients of the objects of the page. They are only
+* meaningful when Res is not SLOTTED_PAGE_NO_ZONE, which happens when every
+* object of the page has resolution Res and at least M approximation
+* coefficients. Objects are stored in order from the end of the zone map up
+* to DataEnd, each one starting at an 8-byte aligned offset (objects whose
+* size is not a multiple of 8, as in serial format 1, are followed by zero
+* padding). The slot directory grows
+* backwards from the end of the page: slot i is the uint32_t at
+* pageSize - 4 * (i + 1) and holds the page offset of object i.
+*/
+const uint32_t SLOTTED_PAGE_MAGIC = 0x31504C53; // "SLP1"
+const size_t SLOTTED_PAGE_HEADER_SIZE = 16;
+const int SLOTTED_PAGE_NO_ZONE = -1;
+
+/**
+* Number of bytes taken by the header and a zone map of 'zoneCount'
+* coefficients.
+*/
+size_t slottedPageHeaderSize(size_t zoneCount);
+
+/**
+* L1 lower bound between 'query' (the first 'count' approximation
+* coefficients of a query at the zone resolution) and any point of the box
+* [zoneMin, zoneMax]. Never larger than the Manhattan distance between the
+* query and an object of the page at that resolution.
+*/
+double zoneLowerBound(const double* zoneMin, const double* zoneMax, const double* query, size_t count);
+
+//---------------------------------------------------------------------------
+// Class TSlottedPageWriter
+//---------------------------------------------------------------------------
+/**
+* Builds one slotted page in memory. Objects are added until one does not
+* fit; Finish() then writes the header and returns the page bytes.
+*
+* @version 1.0
+*/
+class TSlottedPageWriter {
+public:
+    /**
+    * @param pageSize Size of the page in bytes.
+    * @param zoneCount Number of approximation coefficients summarized in
+    * the zone map (0 disables it).
+    */
+    TSlottedPageWriter(size_t pageSize, size_t zoneCount);
+
+    /**
+    * Largest serialized object that fits in an empty page.
+    */
+    size_t GetCapacity() const;
+
+    /**
+    * Copies a serialized object into the page and updates the zone map
+    * with its approximation block ('approx', 'approxCount' coefficients at
+    * 'resolution').
+    * @return false if the object does not fit in the remaining space.
+    */
+    bool Add(const uint8_t* object, size_t size, int resolution, const double* approx, size_t approxCount);
+
+    size_t GetCount() const { return Count; }
+    bool IsEmpty() const { return Count == 0; }
+
+    /**
+    * Writes the header and returns the page (GetPageSize() bytes). The
+    * pointer is valid until the next Add() or Clear().
+    */
+    const uint8_t* Finish();
+
+    /**
+    * Empties the page so it can be reused.
+    */
+    void Clear();
+
+    size_t GetPageSize() const { return Page.size(); }
+
+private:
+    std::vector<uint8_t> Page;
+    size_t ZoneCount;
+    size_t Count;
+    size_t DataEnd;
+    int ZoneResolution;
+    std::vector<double> ZoneMin;
+    std::vector<double> ZoneMax;
+};
+
+//---------------------------------------------------------------------------
+// Class TSlottedPageView
+//---------------------------------------------------------------------------
+/**
+* Read-only access to a slotted page in a buffer (a page read from disk or
+* a mapped file).
+*
+* @version 1.0
+*/
+class TSlottedPageView {
+public:
+    /**
+    * Checks if 'page' starts with a slotted page header.
+    */
+    static bool IsSlottedPage(const uint8_t* page, size_t pageSize);
+
+    /**
+    * Decodes the header of 'page'. Throws std::runtime_error if it is not
+    * a valid slotted page of 'pageSize' bytes.
+    */
+    TSlottedPageView(const uint8_t* page, size_t pageSize);
+
+    size_t GetCount() const { return Count; }
+
+    /**
+    * Serialized bytes of object 'slot' (< GetCount()); its size is
+    * written to 'size'. The size includes the padding up to the next
+    * object, if any.
+    */
+    const uint8_t* GetObject(size_t slot, size_t& size) const;
+
+    /**
+    * Resolution of the zone map, or SLOTTED_PAGE_NO_ZONE if the page has
+    * none.
+    */
+    int GetZoneResolution() const { return ZoneResolution; }
+    size_t GetZoneCount() const { return ZoneCount; }
+    const double* GetZoneMin() const { return ZoneMin; }
+    const double* GetZoneMax() const { return ZoneMax; }
+
+private:
+    const uint8_t* Page;
+    size_t PageSize;
+    size_t Count;
+    size_t DataEnd;
+    size_t ZoneCount;
+    int ZoneResolution;
+    const double* ZoneMin;
+    const double* ZoneMax;
+
+    uint32_t GetSlot(size_t slot) const;
+};
+
+#endif // SLOTTED_PAGE_H
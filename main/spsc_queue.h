@@ -0,0 +1,173 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Class TSpscQueue
+//---------------------------------------------------------------------------
+/**
+* Bounded lock-free queue between one producer thread and one consumer
+* thread. The slots are allocated once and reused: the producer fills the
+* slot returned by BeginPush() in place and the consumer reads the one
+* returned by Front(), so a T that owns buffers (a std::vector, say) keeps
+* their capacity from one record to the next and the queue never
+* allocates after construction.
+*
+* A full (producer) or empty (consumer) queue is waited on by yielding the
+* CPU for a few rounds and then sleeping in std::atomic::wait() until the
+* other side signals, so a stalled stage does not keep a CPU busy. Close()
+* tells the consumer that no more items will come; Cancel() makes both
+* sides give up at once.
+*
+* @version 1.0
+*/
+template <class T>
+class TSpscQueue {
+public:
+    /**
+    * Creates a queue with room for 'capacity' items, rounded up to a power
+    * of two (at least 2).
+    */
+    explicit TSpscQueue(size_t capacity) :
+        Head(0), Tail(0), ProducerSignal(0), ConsumerSignal(0), Closed(false), Cancelled(false) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        Slots.resize(size);
+        Mask = size - 1;
+    }
+
+    TSpscQueue(const TSpscQueue&) = delete;
+    TSpscQueue& operator=(const TSpscQueue&) = delete;
+
+    size_t GetCapacity() const { return Slots.size(); }
+
+    /**
+    * Producer: waits for a free slot and returns it, to be filled and then
+    * published by EndPush().
+    * @return The slot, or NULL if the queue was cancelled.
+    */
+    T* BeginPush() {
+        const size_t tail = Tail.load(std::memory_order_relaxed);
+        const bool ready = WaitFor(ProducerSignal, [&]() {
+            return tail - Head.load(std::memory_order_acquire) < Slots.size();
+        });
+        return ready ? &Slots[tail & Mask] : nullptr;
+    }
+
+    /**
+    * Producer: publishes the slot returned by BeginPush().
+    */
+    void EndPush() {
+        Tail.store(Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        Signal(ConsumerSignal);
+    }
+
+    /**
+    * Producer: no more items will be pushed.
+    */
+    void Close() {
+        Closed.store(true, std::memory_order_release);
+        Signal(ConsumerSignal);
+    }
+
+    /**
+    * Consumer: waits for the oldest item and returns it. The item stays in
+    * the queue until Pop().
+    * @return The item, or NULL once the queue is closed and empty or when
+    * it was cancelled.
+    */
+    T* Front() {
+        const size_t head = Head.load(std::memory_order_relaxed);
+        const bool ready = WaitFor(ConsumerSignal, [&]() {
+            return Tail.load(std::memory_order_acquire) != head || Closed.load(std::memory_order_acquire);
+        });
+        // Items pushed before Close() are visible now
+        if (!ready || Tail.load(std::memory_order_acquire) == head) {
+            return nullptr;
+        }
+        return Cancelled.load(std::memory_order_relaxed) ? nullptr : &Slots[head & Mask];
+    }
+
+    /**
+    * Consumer: tells whether an item is ready, without waiting.
+    */
+    bool IsReady() const {
+        return Tail.load(std::memory_order_acquire) != Head.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * Consumer: releases the item returned by Front().
+    */
+    void Pop() {
+        Head.store(Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        Signal(ProducerSignal);
+    }
+
+    /**
+    * Either side: makes every pending and future BeginPush() and Front()
+    * return NULL.
+    */
+    void Cancel() {
+        Cancelled.store(true, std::memory_order_release);
+        Signal(ProducerSignal);
+        Signal(ConsumerSignal);
+    }
+
+private:
+    /**
+    * Rounds of yielding before a waiting side goes to sleep.
+    */
+    static const unsigned SPIN_ROUNDS = 64;
+
+    /**
+    * Waits until 'ready' returns true (true) or the queue is cancelled
+    * (false). The value of 'signal' is read before each check, so a
+    * Signal() made after the check ends the wait at once.
+    */
+    template <class Ready>
+    bool WaitFor(std::atomic<uint32_t>& signal, Ready ready) {
+        for (unsigned round = 0;; ++round) {
+            const uint32_t seen = signal.load(std::memory_order_acquire);
+            if (ready()) {
+                return true;
+            }
+            if (Cancelled.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (round < SPIN_ROUNDS) {
+                std::this_thread::yield();
+            } else {
+                signal.wait(seen, std::memory_order_acquire);
+            }
+        }
+    }
+
+    /**
+    * Wakes the side sleeping on 'signal', if any.
+    */
+    static void Signal(std::atomic<uint32_t>& signal) {
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+
+    std::vector<T> Slots;
+    size_t Mask;
+    // Written by the consumer and by the producer; kept on separate cache lines
+    alignas(64) std::atomic<size_t> Head;
+    alignas(64) std::atomic<size_t> Tail;
+    // Bumped by Pop() and Cancel() (producer waits) and by EndPush(),
+    // Close() and Cancel() (consumer waits)
+    alignas(64) std::atomic<uint32_t> ProducerSignal;
+    alignas(64) std::atomic<uint32_t> ConsumerSignal;
+    alignas(64) std::atomic<bool> Closed;
+    std::atomic<bool> Cancelled;
+};
+
+#endif // SPSC_QUEUE_H
@@ -1,16 +1,31 @@
 // unit_test.cpp
 
+#include <algorithm> // Para std::equal
 #include <iostream>
 #include <string>
 #include <vector>
 #include <cmath>     // Para std::abs, std::sqrt
 #include <stdexcept> // Para std::runtime_error (em try-catch)
 #include <limits>    // Para std::numeric_limits (para epsilon)
+#include <cstdio>    // Para std::remove
+#include <fstream>   // Para std::ofstream
+#include <memory>    // Para std::unique_ptr
+#include <cstdint>   // Para uintptr_t
+#include <iterator>  // Para std::istreambuf_iterator
+#include <sstream>   // Para std::ostringstream
 
 // Includes das classes a serem testadas
 #include "VectorFileReader.hpp" // Presumindo que este arquivo existe
+#include "binary_dataset.h"
+#include "ingest_pipeline.h"
 #include "complex_object.h"
 #include "distance_calculator.h"
+#include "label_store.h"
+#include "slotted_page.h"
+#include "async_page_reader.h"
+#include "coarse_tier.h"
+#include "result_sink.h"
+#include "scan_search.h"
 
 #define VERDE "\033[32m"
 #define VERMELHO "\033[31m"
@@ -77,6 +92,302 @@ bool testVectorFileReader() {
     return success;
 }
 
+// --- Teste do parser paralelo do VectorFileReader ---
+bool testVectorFileReaderParser() {
+    std::cout << "\n--- Iniciando Teste: Parser do VectorFileReader ---" << std::endl;
+    bool success = true;
+    const std::string filename = "vector_reader_test.txt";
+
+    // Linhas válidas, em branco, mal formatadas e com '\r', divididas em vários blocos
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "a 0 1.5 -2 3e2\r\n"
+            << "\n"
+            << "sem_resolucao\n"
+            << "b +1 +4 .5 6.\n"
+            << "c 2 1 2 x\n"
+            << "d 3 7 8 9";
+    }
+    for (unsigned threads = 1; threads <= 4; ++threads) {
+        VectorFileReader reader;
+        reader.setParseThreads(threads);
+        const std::vector<VectorEntry>& entries = reader.getVectors();
+        if (!reader.loadFromFile(filename) || reader.getNumLines() != 3 || reader.getNumElements() != 3 ||
+            std::string(entries[0].label) != "a" || entries[0].data[2] != 300.0 ||
+            std::string(entries[1].label) != "b" || entries[1].resolution != 1 || entries[1].data[1] != 0.5 ||
+            entries[1].data[2] != 6.0 || std::string(entries[2].label) != "d" || entries[2].data[0] != 7.0) {
+            std::cerr << VERMELHO << "[FALHA] Leitura incorreta com " << threads << " thread(s)." << RESET << std::endl;
+            success = false;
+        }
+    }
+
+    std::cout << "[TESTE] Rejeição de tamanho inconsistente..." << std::endl;
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "a 0 1 2 3\n" << "b 0 4 5 6\n" << "c 0 7 8\n" << "d 0 1 2 3\n";
+    }
+    for (unsigned threads = 1; threads <= 4; ++threads) {
+        VectorFileReader reader;
+        reader.setParseThreads(threads);
+        if (reader.loadFromFile(filename) || reader.getNumLines() != 0 || !reader.getVectors().empty()) {
+            std::cerr << VERMELHO << "[FALHA] Linha inconsistente aceita com " << threads << " thread(s)." << RESET << std::endl;
+            success = false;
+        }
+    }
+
+    std::cout << "[TESTE] Resolução derivada do arquivo base..." << std::endl;
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "a 0 1 3 5 7\n" << "b 1 2 6 -1 -1\n";
+    }
+    // Resolução 1 de {1, 3, 5, 7}: médias {2, 6} e diferenças {-1, -1};
+    // resolução 2: média {4} e diferença {-2}
+    const std::vector<double> level2 = {4.0, -2.0, -1.0, -1.0};
+    for (unsigned threads = 1; threads <= 2; ++threads) {
+        VectorFileReader reader;
+        reader.setParseThreads(threads);
+        reader.setTargetResolution(2);
+        const std::vector<VectorEntry>& entries = reader.getVectors();
+        if (!reader.loadFromFile(filename) || entries.size() != 2 || entries[0].resolution != 2 ||
+            entries[0].data != level2 || entries[1].resolution != 2 || entries[1].data != level2) {
+            std::cerr << VERMELHO << "[FALHA] Transformada para a resolução 2 incorreta." << RESET << std::endl;
+            success = false;
+        }
+    }
+    // Na leitura registro a registro, 'b' volta à resolução 0 pela transformada inversa
+    VectorFileReader streaming;
+    streaming.setTargetResolution(0);
+    const std::vector<double> level0 = {1.0, 3.0, 5.0, 7.0};
+    std::vector<std::vector<double>> streamed;
+    if (!streaming.forEachObject(filename, [&](TComplexObject& obj) {
+            streamed.push_back(obj.GetData());
+            return obj.GetResolution() == 0;
+        }) || streamed.size() != 2 || streamed[0] != level0 || streamed[1] != level0) {
+        std::cerr << VERMELHO << "[FALHA] Transformada inversa para a resolução 0 incorreta." << RESET << std::endl;
+        success = false;
+    }
+    std::remove(filename.c_str());
+    if (success) {
+        std::cout << "[INFO] Parser OK." << std::endl;
+    }
+
+    std::cout << "--- Teste Parser do VectorFileReader Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
+// --- Teste da leitura registro a registro do VectorFileReader ---
+bool testVectorFileReaderStreaming() {
+    std::cout << "\n--- Iniciando Teste: Leitura registro a registro ---" << std::endl;
+    bool success = true;
+    const std::string filename = "vector_stream_test.txt";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "a 0 1 2 3\n" << "mal_formada\n" << "b 1 4 5 6\n" << "c 2 7 8 9\n";
+    }
+
+    // O visitante recebe sempre o mesmo objeto, com o conteúdo de cada linha
+    VectorFileReader reader;
+    std::vector<std::string> labels;
+    const TComplexObject* previous = nullptr;
+    bool sameObject = true;
+    bool ok = reader.forEachObject(filename, [&](TComplexObject& obj) {
+        sameObject = sameObject && (previous == nullptr || previous == &obj);
+        previous = &obj;
+        labels.push_back(obj.GetLabel() + ":" + std::to_string(obj.GetResolution()) + ":" +
+                         std::to_string(static_cast<int>(obj.GetData()[2])));
+        return true;
+    });
+    if (!ok || !sameObject || reader.getNumLines() != 3 || reader.getNumElements() != 3 ||
+        !reader.getVectors().empty() || labels != std::vector<std::string>{"a:0:3", "b:1:6", "c:2:9"}) {
+        std::cerr << VERMELHO << "[FALHA] Registros entregues incorretamente." << RESET << std::endl;
+        success = false;
+    }
+
+    std::cout << "[TESTE] Interrupção pelo visitante e por linha inconsistente..." << std::endl;
+    int visited = 0;
+    ok = reader.forEachObject(filename, [&](TComplexObject&) { return ++visited < 2; });
+    if (!ok || visited != 2) {
+        std::cerr << VERMELHO << "[FALHA] O visitante não interrompeu a leitura." << RESET << std::endl;
+        success = false;
+    }
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "a 0 1 2 3\n" << "b 0 4 5\n" << "c 0 7 8 9\n";
+    }
+    visited = 0;
+    if (reader.forEachObject(filename, [&](TComplexObject&) { visited++; return true; }) || visited != 1) {
+        std::cerr << VERMELHO << "[FALHA] Linha inconsistente não interrompeu a leitura." << RESET << std::endl;
+        success = false;
+    }
+    std::remove(filename.c_str());
+    if (success) {
+        std::cout << "[INFO] Leitura registro a registro OK." << std::endl;
+    }
+
+    std::cout << "--- Teste Leitura registro a registro Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
+// --- Teste da carga em estágios (parser -> transformada -> inserção) ---
+bool testIngestPipeline() {
+    std::cout << "\n--- Iniciando Teste: Pipeline de carga ---" << std::endl;
+    bool success = true;
+    const std::string filename = "ingest_pipeline_test.txt";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        for (int i = 0; i < 200; ++i) {
+            out << "obj_" << i << " " << (i % 3 == 0 ? 1 : 0);
+            for (int j = 0; j < 8; ++j) {
+                out << " " << (i * 8 + j) % 37;
+            }
+            out << "\n";
+        }
+    }
+
+    // Referência: o mesmo arquivo lido registro a registro na mesma resolução
+    VectorFileReader reader;
+    reader.setTargetResolution(2);
+    std::vector<TComplexObject> expected;
+    reader.forEachObject(filename, [&](TComplexObject& obj) { expected.push_back(obj); return true; });
+
+    std::cout << "[TESTE] Ordem e transformada com 3 threads e filas pequenas..." << std::endl;
+    TIngestPipeline pipeline(3, 4);
+    pipeline.SetTargetResolution(2);
+    size_t index = 0;
+    bool sameRecords = true;
+    bool ok = pipeline.Run(filename, [&](TComplexObject& obj) {
+        sameRecords = sameRecords && index < expected.size() && obj.GetLabel() == expected[index].GetLabel() &&
+                      obj.GetResolution() == expected[index].GetResolution() &&
+                      obj.GetData() == expected[index].GetData();
+        index++;
+        return true;
+    });
+    if (!ok || !sameRecords || expected.size() != 200 || pipeline.GetCount() != 200 ||
+        pipeline.GetNumElements() != 8 || pipeline.GetTransformThreads() != 3) {
+        std::cerr << VERMELHO << "[FALHA] Registros entregues fora de ordem ou sem a transformada." << RESET << std::endl;
+        success = false;
+    }
+
+    std::cout << "[TESTE] Sem resolução alvo: parser direto para a inserção..." << std::endl;
+    std::vector<TComplexObject> original;
+    VectorFileReader plainReader;
+    plainReader.forEachObject(filename, [&](TComplexObject& obj) { original.push_back(obj); return true; });
+    TIngestPipeline direct(3, 4);
+    index = 0;
+    sameRecords = true;
+    ok = direct.Run(filename, [&](TComplexObject& obj) {
+        sameRecords = sameRecords && index < original.size() && obj.GetLabel() == original[index].GetLabel() &&
+                      obj.GetResolution() == original[index].GetResolution() &&
+                      obj.GetData() == original[index].GetData();
+        index++;
+        return true;
+    });
+    if (!ok || !sameRecords || direct.GetCount() != 200 || direct.GetTransformThreads() != 0) {
+        std::cerr << VERMELHO << "[FALHA] Registros sem transformada entregues incorretamente." << RESET << std::endl;
+        success = false;
+    }
+
+    std::cout << "[TESTE] Interrupção pela inserção e por linha inconsistente..." << std::endl;
+    size_t inserted = 0;
+    ok = pipeline.Run(filename, [&](TComplexObject&) { return ++inserted < 10; });
+    if (!ok || inserted != 10 || pipeline.GetCount() != 10) {
+        std::cerr << VERMELHO << "[FALHA] A inserção não interrompeu a carga." << RESET << std::endl;
+        success = false;
+    }
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "a 0 1 2 3 4\n" << "b 0 4 5\n" << "c 0 7 8 9 10\n";
+    }
+    inserted = 0;
+    if (pipeline.Run(filename, [&](TComplexObject&) { inserted++; return true; }) || inserted != 1) {
+        std::cerr << VERMELHO << "[FALHA] Linha inconsistente não interrompeu a carga." << RESET << std::endl;
+        success = false;
+    }
+    std::remove(filename.c_str());
+
+    std::cout << "[TESTE] Linha de progresso..." << std::endl;
+    std::ostringstream line;
+    TIngestProgress progress(line, "carga: ", 0.0);
+    for (int i = 0; i < 128; ++i) {
+        progress.Add();
+    }
+    progress.Finish();
+    if (progress.GetCount() != 128 || line.str().find("\rcarga: 64 objetos") != 0 ||
+        line.str().find("\rcarga: 128 objetos em ") == std::string::npos || line.str().back() != '\n') {
+        std::cerr << VERMELHO << "[FALHA] Linha de progresso incorreta: '" << line.str() << "'." << RESET << std::endl;
+        success = false;
+    }
+    if (success) {
+        std::cout << "[INFO] Pipeline de carga OK." << std::endl;
+    }
+
+    std::cout << "--- Teste Pipeline de carga Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
+// --- Teste do formato binário de datasets ---
+bool testBinaryDataset() {
+    std::cout << "\n--- Iniciando Teste: Dataset binário ---" << std::endl;
+    bool success = true;
+    const std::string filename = "binary_dataset_test.vds";
+
+    // Resoluções diferentes: o arquivo inclui a coluna de resoluções
+    std::vector<VectorEntry> entries(3);
+    const char* labels[3] = {"img_a.jpg", "", "img_c.jpg"};
+    for (size_t i = 0; i < entries.size(); ++i) {
+        snprintf(entries[i].label, sizeof(entries[i].label), "%s", labels[i]);
+        entries[i].resolution = static_cast<int>(i % 2);
+        entries[i].data = {1.0 + i, -2.5 * i, 1e300, 0.125};
+    }
+    if (!writeBinaryDataset(filename, entries)) {
+        std::cerr << VERMELHO << "[FALHA] Falha ao gravar '" << filename << "'." << RESET << std::endl;
+        success = false;
+    }
+
+    std::cout << "[TESTE] Leitura pelo VectorFileReader..." << std::endl;
+    VectorFileReader reader;
+    if (!reader.loadFromFile(filename) || reader.getNumLines() != 3 || reader.getNumElements() != 4) {
+        std::cerr << VERMELHO << "[FALHA] Cabeçalho do dataset binário incorreto." << RESET << std::endl;
+        success = false;
+    } else {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const VectorEntry& entry = reader.getVectors()[i];
+            if (std::string(entry.label) != labels[i] || entry.resolution != entries[i].resolution ||
+                entry.data != entries[i].data) {
+                std::cerr << VERMELHO << "[FALHA] Entrada " << i << " lida incorretamente." << RESET << std::endl;
+                success = false;
+            }
+        }
+    }
+
+    std::cout << "[TESTE] Tamanhos diferentes e arquivo truncado..." << std::endl;
+    entries[1].data.pop_back();
+    if (writeBinaryDataset(filename, entries)) {
+        std::cerr << VERMELHO << "[FALHA] Entradas de tamanhos diferentes aceitas." << RESET << std::endl;
+        success = false;
+    }
+    entries[1].data.push_back(0.0);
+    writeBinaryDataset(filename, entries);
+    {
+        std::ifstream in(filename, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 1));
+    }
+    VectorFileReader truncated;
+    if (truncated.loadFromFile(filename) || truncated.getNumLines() != 0) {
+        std::cerr << VERMELHO << "[FALHA] Arquivo binário truncado aceito." << RESET << std::endl;
+        success = false;
+    }
+    std::remove(filename.c_str());
+    if (success) {
+        std::cout << "[INFO] Dataset binário OK." << std::endl;
+    }
+
+    std::cout << "--- Teste Dataset binário Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
 // --- Função de Teste para TComplexObject ---
 bool testComplexObject() {
     std::cout << "\n--- Iniciando Teste: TComplexObject ---" << std::endl;
@@ -229,6 +540,184 @@ bool testComplexObject() {
         success = false;
     }
 
+    // 5. Teste de Serialização truncada (apenas aproximação + níveis de detalhe)
+    std::cout << "[TESTE] Serialize/Unserialize truncado..." << std::endl;
+    try {
+        std::vector<double> data_tr(64);
+        for (size_t i = 0; i < data_tr.size(); ++i) data_tr[i] = static_cast<double>(i % 7);
+        TComplexObject obj_tr("Truncate", 0, data_tr);
+        obj_tr.dataCompression(3); // 8 coeficientes de aproximação
+
+        size_t full_size = obj_tr.GetSerializedSize();
+        TComplexObject::SetStoredDetailLevels(1); // Aproximação + 1 nível = 16 coeficientes
+        TComplexObject obj_tr_dest;
+        size_t tr_size = obj_tr.GetSerializedSize();
+        obj_tr_dest.Unserialize(obj_tr.Serialize(), tr_size);
+        TComplexObject::SetStoredDetailLevels(-1);
+
+        bool prefix_ok = obj_tr_dest.GetData().size() == 64 && obj_tr_dest.GetStoredSize() == 16;
+        for (size_t i = 0; prefix_ok && i < 64; ++i) {
+            prefix_ok = obj_tr_dest.GetData()[i] == ((i < 16) ? obj_tr.GetData()[i] : 0.0);
+        }
+        if (tr_size != full_size - 48 * sizeof(double) || !prefix_ok ||
+            obj_tr_dest.GetResolution() != 3 || obj_tr_dest.GetLabel() != "Truncate") {
+            std::cerr << VERMELHO << "[FALHA] Objeto truncado deserializado incorretamente." << RESET << std::endl;
+            success = false;
+        }
+
+        // Voltar uma resolução usa os detalhes armazenados; duas exigem detalhes ausentes
+        TComplexObject one_up(obj_tr_dest);
+        one_up.dataCompression(-1);
+        bool exception_caught = false;
+        try {
+            obj_tr_dest.dataCompression(-2);
+        } catch (const std::runtime_error&) {
+            exception_caught = true;
+        }
+        if (!exception_caught) {
+            std::cerr << VERMELHO << "[FALHA] Descompressão sem os detalhes armazenados não lançou exceção." << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] Serialize/Unserialize truncado OK." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << VERMELHO << "[ERRO] Exceção durante o teste de serialização truncada: " << e.what() << RESET << std::endl;
+        TComplexObject::SetStoredDetailLevels(-1);
+        success = false;
+    }
+
+    // 6. Teste dos formatos de serialização v1 e v2
+    std::cout << "[TESTE] Formatos de serialização v1/v2..." << std::endl;
+    try {
+        std::vector<double> data_fmt = {1.5, -2.5, 3.25, 4.0};
+        TComplexObject obj_v2("Formato", 2, data_fmt);
+        TComplexObject obj_v1("Formato", 2, data_fmt);
+
+        // v2 (padrão): cabeçalho de 8 bytes, coeficientes logo após, tamanho múltiplo de 8
+        const uint8_t* ser_v2 = obj_v2.Serialize();
+        size_t size_v2 = obj_v2.GetSerializedSize();
+        TComplexObjectView view_v2(ser_v2, size_v2);
+        bool v2_ok = ser_v2[0] == TComplexObject::SERIAL_V2_TAG &&
+                     size_v2 == 8 + 4 * sizeof(double) + 8 &&
+                     view_v2.GetSerialFormat() == 2 &&
+                     reinterpret_cast<const uint8_t*>(view_v2.GetCoefficients()) == ser_v2 + 8;
+
+        // v1: layout original, continua legível
+        TComplexObject::SetSerialFormat(1);
+        const uint8_t* ser_v1 = obj_v1.Serialize();
+        size_t size_v1 = obj_v1.GetSerializedSize();
+        TComplexObject::SetSerialFormat(2);
+        bool v1_ok = size_v1 == sizeof(int) + 2 * sizeof(size_t) + 7 + 4 * sizeof(double) &&
+                     TComplexObjectView(ser_v1, size_v1).GetSerialFormat() == 1;
+
+        TComplexObject dest_v1, dest_v2;
+        dest_v1.Unserialize(ser_v1, size_v1);
+        dest_v2.Unserialize(ser_v2, size_v2);
+        int peek_res = -1;
+        if (!v2_ok || !v1_ok ||
+            !dest_v1.IsEqual(&obj_v1) || dest_v1.GetLabel() != "Formato" ||
+            !dest_v2.IsEqual(&obj_v2) || dest_v2.GetLabel() != "Formato" ||
+            TComplexObject::PeekSerializedSize(ser_v2, size_v2, peek_res) != size_v2 || peek_res != 2) {
+            std::cerr << VERMELHO << "[FALHA] Formatos v1/v2 não foram gravados ou lidos corretamente." << RESET << std::endl;
+            success = false;
+        }
+
+        // Campos que não cabem no v2 (resolução > 255) voltam para o v1
+        TComplexObject obj_big_res("Formato", 300, data_fmt);
+        if (obj_big_res.Serialize()[0] == TComplexObject::SERIAL_V2_TAG) {
+            std::cerr << VERMELHO << "[FALHA] Objeto fora dos limites do v2 não foi gravado em v1." << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] Formatos de serialização v1/v2 OK." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << VERMELHO << "[ERRO] Exceção durante o teste de formatos de serialização: " << e.what() << RESET << std::endl;
+        TComplexObject::SetSerialFormat(2);
+        success = false;
+    }
+
+    // 7. Teste do ID de objeto (label fora da entrada serializada)
+    std::cout << "[TESTE] Serialize/Unserialize com ID de objeto..." << std::endl;
+    try {
+        std::vector<double> data_id = {1.0, 2.0, 3.0, 4.0};
+        TComplexObject obj_id("n02088364_11458.jpg", 1, data_id);
+        size_t size_with_label = obj_id.GetSerializedSize();
+        obj_id.SetObjectID(42);
+        size_t size_with_id = obj_id.GetSerializedSize();
+
+        TComplexObject obj_id_dest;
+        obj_id_dest.Unserialize(obj_id.Serialize(), size_with_id);
+        TComplexObjectView view_id(obj_id.Serialize(), size_with_id);
+
+        // Com labels inline o ID e o label são gravados juntos
+        TComplexObject::SetInlineLabels(true);
+        TComplexObject obj_inline("n02088364_11458.jpg", 1, data_id);
+        obj_inline.SetObjectID(7);
+        TComplexObject obj_inline_dest;
+        obj_inline_dest.Unserialize(obj_inline.Serialize(), obj_inline.GetSerializedSize());
+        TComplexObject::SetInlineLabels(false);
+
+        if (size_with_id >= size_with_label || obj_id_dest.GetObjectID() != 42 ||
+            !obj_id_dest.GetLabel().empty() || !obj_id_dest.IsEqual(&obj_id) ||
+            view_id.GetObjectID() != 42 || view_id.GetLabelLength() != 0 ||
+            reinterpret_cast<const uint8_t*>(view_id.GetCoefficients()) != obj_id.Serialize() + 8 ||
+            obj_inline_dest.GetObjectID() != 7 || obj_inline_dest.GetLabel() != "n02088364_11458.jpg") {
+            std::cerr << VERMELHO << "[FALHA] ID de objeto não foi gravado ou lido corretamente." << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] Serialize/Unserialize com ID de objeto OK." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << VERMELHO << "[ERRO] Exceção durante o teste de ID de objeto: " << e.what() << RESET << std::endl;
+        TComplexObject::SetInlineLabels(false);
+        success = false;
+    }
+
+    // 8. Teste da transformada de Haar in-place contra a implementação com buffer
+    std::cout << "[TESTE] dataCompression in-place..." << std::endl;
+    try {
+        bool haar_ok = true;
+        // 1000 não é potência de 2: a compressão para em 125 coeficientes
+        for (size_t dim : {size_t(8), size_t(256), size_t(1000), size_t(38)}) {
+            std::vector<double> base(dim);
+            for (size_t i = 0; i < dim; ++i) base[i] = std::sin(0.37 * i) * 100.0 + (i % 5);
+
+            // Referência: um buffer temporário por nível, como a versão original
+            std::vector<double> expected = base;
+            int expected_res = 0;
+            for (int level = 0; level < 6; ++level) {
+                size_t approx = dim >> expected_res;
+                if (approx <= 1 || approx % 2 != 0) break;
+                std::vector<double> tmp(expected);
+                for (size_t i = 0; i < approx / 2; ++i) {
+                    tmp[i] = (expected[2 * i] + expected[2 * i + 1]) / 2.0;
+                    tmp[i + approx / 2] = (expected[2 * i] - expected[2 * i + 1]) / 2.0;
+                }
+                expected = tmp;
+                expected_res++;
+            }
+
+            TComplexObject obj_haar("Haar", 0, base);
+            obj_haar.dataCompression(6);
+            if (obj_haar.GetResolution() != expected_res || obj_haar.GetData() != expected) {
+                haar_ok = false;
+            }
+            obj_haar.dataCompression(-6);
+            for (size_t i = 0; haar_ok && i < dim; ++i) {
+                haar_ok = obj_haar.GetResolution() == 0 && std::abs(obj_haar.GetData()[i] - base[i]) < 1e-9;
+            }
+        }
+        if (!haar_ok) {
+            std::cerr << VERMELHO << "[FALHA] Transformada in-place difere da implementação de referência." << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] dataCompression in-place OK." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << VERMELHO << "[ERRO] Exceção durante o teste da transformada de Haar: " << e.what() << RESET << std::endl;
+        success = false;
+    }
+
 
     std::cout << "--- Teste TComplexObject Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
     return success;
@@ -312,7 +801,245 @@ bool testDistanceCalculator() {
             success = false;
         }
 
+        // 5. Teste com resoluções diferentes (deve coincidir com clone + dataCompression)
+        std::cout << "[TESTE] Distância entre resoluções diferentes..." << std::endl;
+        std::vector<double> base_a(256), base_b(256);
+        for (size_t i = 0; i < base_a.size(); ++i) {
+            base_a[i] = static_cast<double>((i * 37) % 101);
+            base_b[i] = static_cast<double>((i * 53 + 7) % 89);
+        }
+        bool cross_ok = true;
+        for (int res_a = 0; res_a <= 4 && cross_ok; ++res_a) {
+            for (int res_b = 0; res_b <= 4 && cross_ok; ++res_b) {
+                TComplexObject obj_a("A", 0, base_a);
+                TComplexObject obj_b("B", 0, base_b);
+                obj_a.dataCompression(res_a);
+                obj_b.dataCompression(res_b);
+
+                // Referência: clone de obj_a transformado para a resolução de obj_b
+                TComplexObject ref_a(obj_a);
+                ref_a.dataCompression(res_b - res_a);
+                double expected = evaluator.GetDistance(ref_a, obj_b);
+                double obtained = evaluator.GetDistance(obj_a, obj_b);
+
+                if (expected != obtained) {
+                    std::cerr << VERMELHO << "[FALHA] Distância entre resoluções " << res_a << " e " << res_b
+                              << " incorreta. Obtida=" << obtained << ", Esperada=" << expected << RESET << std::endl;
+                    cross_ok = false;
+                }
+            }
+        }
+        if (cross_ok) {
+            std::cout << "[INFO] Distância entre resoluções diferentes OK." << std::endl;
+        } else {
+            success = false;
+        }
+
+        // 6. Teste da distância limitada (abandono antecipado)
+        std::cout << "[TESTE] Distância limitada (bound)..." << std::endl;
+        TComplexObject bnd_a("A", 0, base_a);
+        TComplexObject bnd_b("B", 0, base_b);
+        double full_dist = evaluator.GetDistance(bnd_a, bnd_b);
+        double above = evaluator.GetDistance(bnd_a, bnd_b, full_dist + 1.0); // Não abandona
+        double below = evaluator.GetDistance(bnd_a, bnd_b, full_dist / 4.0); // Abandona
+        // Com dados não inteiros, limite igual à distância completa não abandona
+        std::vector<double> frac_a(37), frac_b(37);
+        for (size_t i = 0; i < frac_a.size(); ++i) {
+            frac_a[i] = 0.1 * i + 1.0 / 3.0;
+            frac_b[i] = 1.7 - 0.3 * i;
+        }
+        const double frac_full = boundedManhattanDistance(frac_a.data(), frac_b.data(), frac_a.size(),
+                                                          std::numeric_limits<double>::infinity());
+        const double frac_at = boundedManhattanDistance(frac_a.data(), frac_b.data(), frac_a.size(), frac_full);
+        if (above != full_dist || !(below > full_dist / 4.0) || below > full_dist || frac_at != frac_full) {
+            std::cerr << VERMELHO << "[FALHA] Distância limitada incorreta. Completa=" << full_dist
+                      << ", Acima=" << above << ", Abaixo=" << below << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] Distância limitada OK." << std::endl;
+        }
+
+        // 7. Teste da distância sobre uma visão dos bytes serializados
+        std::cout << "[TESTE] Distância via TComplexObjectView..." << std::endl;
+        TComplexObject view_src("ViewMe", 2, base_a);
+        TComplexObjectView view(view_src.Serialize(), view_src.GetSerializedSize());
+        TComplexObject* materialized = view.Materialize();
+        double dist_obj = evaluator.GetDistance(view_src, bnd_b);
+        double dist_view = evaluator.GetDistance(view, bnd_b);
+        if (dist_obj != dist_view || !materialized->IsEqual(&view_src) ||
+            materialized->GetLabel() != view_src.GetLabel()) {
+            std::cerr << VERMELHO << "[FALHA] Distância ou materialização via visão incorreta. Objeto=" << dist_obj
+                      << ", Visão=" << dist_view << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] Distância via TComplexObjectView OK." << std::endl;
+        }
+        delete materialized;
+
+        // v1: coeficientes após o label, fora do alinhamento de double
+        TComplexObject::SetSerialFormat(1);
+        TComplexObject misaligned_src("ViewMe", 2, base_a);
+        std::vector<uint8_t> misaligned_bytes(misaligned_src.Serialize(),
+                                              misaligned_src.Serialize() + misaligned_src.GetSerializedSize());
+        TComplexObject::SetSerialFormat(2);
+        TComplexObjectView misaligned(misaligned_bytes.data(), misaligned_bytes.size());
+        const double* aligned_coefficients = misaligned.GetCoefficients();
+        if (misaligned.HasAlignedCoefficients() ||
+            reinterpret_cast<uintptr_t>(aligned_coefficients) % alignof(double) != 0 ||
+            !std::equal(base_a.begin(), base_a.end(), aligned_coefficients) ||
+            evaluator.GetDistance(misaligned, bnd_b) != dist_obj) {
+            std::cerr << VERMELHO << "[FALHA] Coeficientes desalinhados da visão v1 incorretos." << RESET << std::endl;
+            success = false;
+        }
+
+        // Modo de resultados só com a identidade do objeto
+        TComplexObject::SetResultIDsOnly(true);
+        TComplexObject* resultObj = view.MaterializeResult();
+        TComplexObject::SetResultIDsOnly(false);
+        TComplexObject* fullObj = view.MaterializeResult();
+        if (!resultObj->GetData().empty() || resultObj->GetLabel() != "ViewMe" || resultObj->GetResolution() != 2 ||
+            !fullObj->IsEqual(&view_src)) {
+            std::cerr << VERMELHO << "[FALHA] Objeto de resultado só com ID incorreto." << RESET << std::endl;
+            success = false;
+        }
+        delete resultObj;
+        delete fullObj;
+
+        // 8. Teste da distância com coeficientes inteiros (histogramas)
+        std::cout << "[TESTE] Distância com coeficientes inteiros..." << std::endl;
+        bool int_ok = true;
+        for (double scale : {1.0, 1000.0}) { // 1000 força int32 em vez de int16
+            std::vector<double> hist_a(256), hist_b(256);
+            for (size_t i = 0; i < 256; ++i) {
+                hist_a[i] = static_cast<double>((i * 37) % 101) * scale;
+                hist_b[i] = static_cast<double>((i * 53 + 7) % 89) * scale;
+            }
+            TComplexObject entry("Hist", 0, hist_a);
+            entry.dataCompression(3);
+            TComplexObject query("Query", 0, hist_b);
+            query.dataCompression(3);
+            TComplexObject query_fine("Query", 0, hist_b);
+            query_fine.dataCompression(2);
+
+            TComplexObject::SetIntegerCoefficients(true);
+            const uint8_t* int_bytes = entry.Serialize();
+            size_t int_size = entry.GetSerializedSize();
+            TComplexObjectView int_view(int_bytes, int_size);
+            TComplexObject::SetIntegerCoefficients(false);
+            TComplexObject entry_double(entry); // Cópia serializa como double
+
+            // Os valores são inteiros divididos por 2^3, então todas as somas
+            // em double são exatas e os dois caminhos dão o mesmo resultado;
+            // com dados quaisquer eles só coincidem até o arredondamento
+            TComplexObject::CoefficientEncoding expected_encoding = (scale == 1.0) ?
+                TComplexObject::COEFFICIENTS_INT16 : TComplexObject::COEFFICIENTS_INT32;
+            double exact = evaluator.GetDistance(entry_double, query);
+            double partial = evaluator.GetDistance(int_view, query, exact / 4.0);
+            TComplexObject decoded;
+            decoded.Unserialize(int_bytes, int_size);
+            if (int_view.GetCoefficientEncoding() != expected_encoding ||
+                int_size >= entry_double.GetSerializedSize() ||
+                evaluator.GetDistance(int_view, query) != exact ||
+                !(partial > exact / 4.0) ||
+                evaluator.GetDistance(int_view, query_fine) != evaluator.GetDistance(entry_double, query_fine) ||
+                !decoded.IsEqual(&entry)) {
+                int_ok = false;
+            }
+        }
+        // Coeficientes que não são inteiros após a escala continuam double
+        TComplexObject::SetIntegerCoefficients(true);
+        TComplexObject frac("Frac", 0, {0.1, 0.2, 0.3, 0.4});
+        TComplexObjectView frac_view(frac.Serialize(), frac.GetSerializedSize());
+        TComplexObject::SetIntegerCoefficients(false);
+        if (frac_view.GetCoefficientEncoding() != TComplexObject::COEFFICIENTS_DOUBLE) {
+            int_ok = false;
+        }
+        if (!int_ok) {
+            std::cerr << VERMELHO << "[FALHA] Distância ou codificação com coeficientes inteiros incorreta." << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] Distância com coeficientes inteiros OK." << std::endl;
+        }
+
+        // 9. Teste da pirâmide de aproximações (consulta em resolução mais grossa)
+        std::cout << "[TESTE] Distância via pirâmide de aproximações..." << std::endl;
+        bool pyramid_ok = true;
+        for (bool integer_mode : {false, true}) {
+            TComplexObject pyr_src("Pyramid", 1, base_a);
+            TComplexObject::SetStorePyramid(true);
+            TComplexObject::SetIntegerCoefficients(integer_mode);
+            const uint8_t* pyr_bytes = pyr_src.Serialize();
+            size_t pyr_size = pyr_src.GetSerializedSize();
+            TComplexObject::SetStorePyramid(false);
+            TComplexObject::SetIntegerCoefficients(false);
+            TComplexObjectView pyr_view(pyr_bytes, pyr_size);
+
+            TComplexObject pyr_dest;
+            pyr_dest.Unserialize(pyr_bytes, pyr_size);
+            if (!pyr_view.HasPyramid() || pyr_view.GetPyramidLevel(1) != nullptr ||
+                !pyr_dest.IsEqual(&pyr_src) || pyr_dest.GetLabel() != "Pyramid") {
+                pyramid_ok = false;
+            }
+            // Cada nível da pirâmide deve dar a mesma distância que o kernel de resolução cruzada
+            for (int target = 2; target <= 5; ++target) {
+                TComplexObject query("Q", 0, base_b);
+                query.dataCompression(target);
+                if (pyr_view.GetPyramidLevel(target) == nullptr ||
+                    evaluator.GetDistance(pyr_view, query) != evaluator.GetDistance(pyr_src, query)) {
+                    pyramid_ok = false;
+                }
+            }
+        }
+        if (!pyramid_ok) {
+            std::cerr << VERMELHO << "[FALHA] Distância via pirâmide difere do cálculo direto." << RESET << std::endl;
+            success = false;
+        } else {
+            std::cout << "[INFO] Distância via pirâmide de aproximações OK." << std::endl;
+        }
+
+        // 10. Teste do kernel SIMD selecionado contra um laço escalar
+        std::cout << "[TESTE] Kernel de Manhattan (" << manhattanKernelName() << ")..." << std::endl;
+        // Valores inteiros: as somas são exatas em qualquer ordem, então o
+        // kernel (laços principais e restos) deve coincidir bit a bit
+        std::vector<double> kernel_a(257 + 1), kernel_b(257 + 1);
+        for (size_t i = 0; i < kernel_a.size(); ++i) {
+            kernel_a[i] = static_cast<double>((i * 37) % 101) - 50.0;
+            kernel_b[i] = static_cast<double>((i * 53 + 7) % 89) - 44.0;
+        }
+        std::vector<size_t> kernel_lengths;
+        for (size_t n = 0; n <= 40; ++n) {
+            kernel_lengths.push_back(n);
+        }
+        kernel_lengths.insert(kernel_lengths.end(), {255, 256, 257});
+        bool kernel_ok = true;
+        for (size_t n : kernel_lengths) {
+            for (size_t offset_a = 0; offset_a <= 1; ++offset_a) {
+                for (size_t offset_b = 0; offset_b <= 1; ++offset_b) {
+                    const double* a = kernel_a.data() + offset_a;
+                    const double* b = kernel_b.data() + offset_b;
+                    double expected = 0.0;
+                    for (size_t i = 0; i < n; ++i) {
+                        expected += std::abs(a[i] - b[i]);
+                    }
+                    const double obtained = manhattanDistance(a, b, n);
+                    if (obtained != expected) {
+                        std::cerr << VERMELHO << "[FALHA] Kernel de Manhattan com " << n << " elemento(s), deslocamentos "
+                                  << offset_a << "/" << offset_b << ": Obtida=" << obtained << ", Esperada=" << expected
+                                  << RESET << std::endl;
+                        kernel_ok = false;
+                    }
+                }
+            }
+        }
+        if (!kernel_ok) {
+            success = false;
+        } else {
+            std::cout << "[INFO] Kernel de Manhattan OK." << std::endl;
+        }
+
     } catch (const std::exception& e) {
+        TComplexObject::SetIntegerCoefficients(false);
+        TComplexObject::SetStorePyramid(false);
         std::cerr << VERMELHO << "[ERRO] Exceção inesperada durante o teste de DistanceCalculator: " << e.what() << RESET << std::endl;
         success = false;
     }
@@ -322,7 +1049,471 @@ bool testDistanceCalculator() {
 }
 
 
+// --- Função de Teste para TLabelStore ---
+bool testLabelStore() {
+    std::cout << "\n--- Iniciando Teste: TLabelStore ---" << std::endl;
+    bool success = true;
+    const std::string filename = "label_store_test.dat";
+
+    try {
+        std::cout << "[TESTE] Append/GetLabel..." << std::endl;
+        uint32_t id_a, id_b, id_c;
+        {
+            TLabelStore store;
+            if (!store.Open(filename, true)) {
+                std::cerr << VERMELHO << "[FALHA] Não foi possível criar '" << filename << "'." << RESET << std::endl;
+                return false;
+            }
+            id_a = store.Append("n02088364_11458.jpg");
+            id_b = store.Append("");
+            id_c = store.Append("n02099601_3004.jpg");
+            if (id_a != 0 || id_b != 1 || id_c != 2 || store.GetCount() != 3 ||
+                store.GetLabel(id_c) != "n02099601_3004.jpg" || !store.GetLabel(id_b).empty()) {
+                std::cerr << VERMELHO << "[FALHA] Labels lidos não batem com os gravados." << RESET << std::endl;
+                success = false;
+            }
+        }
+
+        // Reabrir reconstrói os offsets e permite continuar anexando
+        std::cout << "[TESTE] Reabrir arquivo de labels..." << std::endl;
+        TLabelStore reopened;
+        if (!reopened.Open(filename) || reopened.GetCount() != 3 ||
+            reopened.GetLabel(id_a) != "n02088364_11458.jpg" ||
+            reopened.Append("extra") != 3 || reopened.GetLabel(3) != "extra") {
+            std::cerr << VERMELHO << "[FALHA] Arquivo de labels reaberto incorretamente." << RESET << std::endl;
+            success = false;
+        }
+
+        bool exception_caught = false;
+        try {
+            reopened.GetLabel(10);
+        } catch (const std::out_of_range&) {
+            exception_caught = true;
+        }
+        if (!exception_caught) {
+            std::cerr << VERMELHO << "[FALHA] ID inexistente não lançou std::out_of_range." << RESET << std::endl;
+            success = false;
+        } else if (success) {
+            std::cout << "[INFO] TLabelStore OK." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << VERMELHO << "[ERRO] Exceção durante o teste de TLabelStore: " << e.what() << RESET << std::endl;
+        success = false;
+    }
+    std::remove(filename.c_str());
+
+    std::cout << "--- Teste TLabelStore Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
+// --- Função de Teste para TSlottedPageWriter/TSlottedPageView ---
+bool testSlottedPage() {
+    std::cout << "\n--- Iniciando Teste: Páginas com slots ---" << std::endl;
+    bool success = true;
+    const size_t pageSize = 512;
+
+    try {
+        std::cout << "[TESTE] Escrita e leitura dos slots..." << std::endl;
+        TComplexObject a("a", 1, {1.0, 4.0, 9.0, 2.0, 0.5, -0.5, 1.0, 1.0});
+        TComplexObject b("b", 1, {3.0, 0.0, 5.0, 6.0, 0.0, 0.0, 0.0, 0.0});
+        TSlottedPageWriter writer(pageSize, 2);
+        const uint8_t* bytesA = a.Serialize();
+        const size_t sizeA = a.GetSerializedSize();
+        std::vector<uint8_t> copyA(bytesA, bytesA + sizeA);
+        bool added = writer.Add(copyA.data(), sizeA, 1, a.GetData().data(), 4);
+        added = writer.Add(b.Serialize(), b.GetSerializedSize(), 1, b.GetData().data(), 4) && added;
+        TSlottedPageView page(writer.Finish(), pageSize);
+
+        size_t size0, size1;
+        TComplexObject restoredA, restoredB;
+        const uint8_t* obj0 = page.GetObject(0, size0);
+        const uint8_t* obj1 = page.GetObject(1, size1);
+        restoredA.Unserialize(obj0, size0);
+        restoredB.Unserialize(obj1, size1);
+        if (!added || page.GetCount() != 2 || size0 != sizeA || !restoredA.IsEqual(&a) || !restoredB.IsEqual(&b)) {
+            std::cerr << VERMELHO << "[FALHA] Objetos lidos dos slots não batem com os gravados." << RESET << std::endl;
+            success = false;
+        }
+
+        std::cout << "[TESTE] Zone map e limite inferior..." << std::endl;
+        const double* zoneMin = page.GetZoneMin();
+        const double* zoneMax = page.GetZoneMax();
+        if (page.GetZoneResolution() != 1 || page.GetZoneCount() != 2 ||
+            zoneMin[0] != 1.0 || zoneMax[0] != 3.0 || zoneMin[1] != 0.0 || zoneMax[1] != 4.0) {
+            std::cerr << VERMELHO << "[FALHA] Zone map incorreto." << RESET << std::endl;
+            success = false;
+        }
+        // Consulta fora da caixa: |0 - 1| + |10 - 4| = 7, sem passar da distância real
+        const double query[2] = {0.0, 10.0};
+        const double bound = zoneLowerBound(zoneMin, zoneMax, query, 2);
+        const double distanceA = std::abs(query[0] - 1.0) + std::abs(query[1] - 4.0);
+        if (bound != 7.0 || bound > distanceA) {
+            std::cerr << VERMELHO << "[FALHA] Limite inferior incorreto: " << bound << RESET << std::endl;
+            success = false;
+        }
+
+        std::cout << "[TESTE] Resoluções mistas e página cheia..." << std::endl;
+        TSlottedPageWriter mixed(pageSize, 2);
+        TComplexObject c("c", 2, {1.0, 2.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
+        mixed.Add(copyA.data(), sizeA, 1, a.GetData().data(), 4);
+        mixed.Add(c.Serialize(), c.GetSerializedSize(), 2, c.GetData().data(), 2);
+        size_t count = 2;
+        while (mixed.Add(copyA.data(), sizeA, 1, a.GetData().data(), 4)) {
+            count++;
+        }
+        TSlottedPageView mixedPage(mixed.Finish(), pageSize);
+        if (mixedPage.GetZoneResolution() != SLOTTED_PAGE_NO_ZONE || mixedPage.GetCount() != count ||
+            count * (sizeA + sizeof(uint32_t)) > pageSize) {
+            std::cerr << VERMELHO << "[FALHA] Página com resoluções mistas ou cheia tratada incorretamente." << RESET << std::endl;
+            success = false;
+        }
+
+        std::cout << "[TESTE] Alinhamento de objetos no formato v1..." << std::endl;
+        TComplexObject::SetSerialFormat(1);
+        TComplexObject odd("odd", 1, {1.0, 4.0, 9.0, 2.0, 0.5, -0.5, 1.0, 1.0});
+        std::vector<uint8_t> oddBytes(odd.Serialize(), odd.Serialize() + odd.GetSerializedSize());
+        TComplexObject::SetSerialFormat(2);
+        TSlottedPageWriter packed(pageSize, 0);
+        while (packed.Add(oddBytes.data(), oddBytes.size(), 1, nullptr, 0)) {
+        }
+        TSlottedPageView packedPage(packed.Finish(), pageSize);
+        bool aligned = oddBytes.size() % 8 != 0 && packedPage.GetCount() > 1;
+        for (size_t slot = 0; slot < packedPage.GetCount(); ++slot) {
+            size_t size;
+            const uint8_t* object = packedPage.GetObject(slot, size);
+            TComplexObject restored;
+            restored.Unserialize(object, size);
+            aligned = aligned && (object - packed.Finish()) % 8 == 0 && restored.IsEqual(&odd);
+        }
+        if (!aligned) {
+            std::cerr << VERMELHO << "[FALHA] Objetos v1 fora do alinhamento de 8 bytes na página." << RESET << std::endl;
+            success = false;
+        }
+
+        std::vector<uint8_t> plain(pageSize, 0);
+        if (TSlottedPageView::IsSlottedPage(plain.data(), pageSize)) {
+            std::cerr << VERMELHO << "[FALHA] Página sem cabeçalho reconhecida como página com slots." << RESET << std::endl;
+            success = false;
+        } else if (success) {
+            std::cout << "[INFO] Páginas com slots OK." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << VERMELHO << "[ERRO] Exceção durante o teste de páginas com slots: " << e.what() << RESET << std::endl;
+        success = false;
+    }
+
+    std::cout << "--- Teste Páginas com slots Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
+// --- Função de Teste para TAsyncPageReader ---
+bool testAsyncPageReader() {
+    std::cout << "\n--- Iniciando Teste: TAsyncPageReader ---" << std::endl;
+    bool success = true;
+    const std::string filename = "async_page_reader_test.dat";
+    const size_t pageSize = 64;
+    const size_t pageCount = 9;
+
+    // Cada página é preenchida com o seu número; a última é parcial
+    {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        for (size_t page = 0; page < pageCount; ++page) {
+            std::vector<char> bytes(page + 1 == pageCount ? pageSize / 2 : pageSize, static_cast<char>(page));
+            out.write(bytes.data(), bytes.size());
+        }
+    }
+
+    const TAsyncPageReader::Engine engines[] = {TAsyncPageReader::ENGINE_AUTO, TAsyncPageReader::ENGINE_THREADS};
+    for (TAsyncPageReader::Engine engine : engines) {
+        TAsyncPageReader reader(pageSize, 4, engine);
+        if (!reader.Open(filename)) {
+            std::cerr << VERMELHO << "[FALHA] Não foi possível abrir '" << filename << "'." << RESET << std::endl;
+            success = false;
+            continue;
+        }
+        std::cout << "[TESTE] Leitura em ordem com motor " << reader.GetEngineName() << "..." << std::endl;
+        std::vector<size_t> visited;
+        bool contentOk = true;
+        bool readOk = reader.ReadPages(1, 100, [](size_t page) { return page % 3 != 0; },
+            [&](size_t page, const uint8_t* data, size_t bytes) {
+                visited.push_back(page);
+                const size_t expectedBytes = (page + 1 == pageCount) ? pageSize / 2 : pageSize;
+                contentOk = contentOk && bytes == expectedBytes && data[0] == page && data[bytes - 1] == page;
+            });
+        const std::vector<size_t> expected = {1, 2, 4, 5, 7, 8};
+        if (!readOk || !contentOk || visited != expected || reader.GetPageCount() != pageCount) {
+            std::cerr << VERMELHO << "[FALHA] Páginas lidas fora de ordem ou com conteúdo incorreto." << RESET << std::endl;
+            success = false;
+        }
+    }
+    std::remove(filename.c_str());
+
+    std::cout << "[TESTE] Reuso de buffers do TAlignedBufferPool..." << std::endl;
+    TAlignedBufferPool& pool = TAlignedBufferPool::Instance();
+    uint8_t* first = pool.Acquire(100);
+    const size_t allocated = pool.GetAllocatedCount();
+    pool.Release(first, 100);
+    uint8_t* second = pool.Acquire(100);
+    if (first == nullptr || second == nullptr || pool.GetAllocatedCount() != allocated ||
+        reinterpret_cast<uintptr_t>(second) % ASYNC_PAGE_ALIGNMENT != 0) {
+        std::cerr << VERMELHO << "[FALHA] Buffer não foi reutilizado ou está desalinhado." << RESET << std::endl;
+        success = false;
+    }
+    pool.Release(second, 100);
+
+    if (success) {
+        std::cout << "[INFO] TAsyncPageReader OK." << std::endl;
+    }
+
+    std::cout << "--- Teste TAsyncPageReader Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
+bool testCoarseTier() {
+    std::cout << "\n--- Iniciando Teste: Camada grossa ---" << std::endl;
+    bool success = true;
+    const std::string filename = "coarse_tier_test.dat";
+
+    // Aproximações na resolução 1 (4 coeficientes de 8); com M = 2 a cópia
+    // grossa fica na resolução 2
+    const double a[4] = {1.0, 4.0, 9.0, 2.0};
+    const double b[4] = {3.0, 0.0, 5.0, 6.0};
+    const double odd[3] = {1.0, 2.0, 3.0};
+    {
+        TCoarseTierWriter writer(2);
+        bool ok = writer.Open(filename);
+        ok = writer.Add(0, 0, 1, a, 4, 8) && ok;
+        ok = writer.Add(0, 1, 1, b, 4, 8) && ok;
+        ok = writer.Add(3, 0, 0, odd, 3, 3) && ok; // 3 coeficientes não chegam a 2
+        if (!writer.Close() || !ok) {
+            std::cerr << VERMELHO << "[FALHA] Falha ao gravar '" << filename << "'." << RESET << std::endl;
+            success = false;
+        }
+    }
+
+    std::cout << "[TESTE] Leitura dos registros..." << std::endl;
+    TCoarseTier tier;
+    size_t countA = 0, countOdd = 0;
+    const double* coarseA = nullptr;
+    if (!tier.Load(filename) || tier.GetCount() != 3 || tier.GetPageCount() != 4) {
+        std::cerr << VERMELHO << "[FALHA] Cabeçalho da camada grossa incorreto." << RESET << std::endl;
+        success = false;
+    } else {
+        coarseA = tier.GetCoefficients(0, countA);
+        tier.GetCoefficients(2, countOdd);
+        if (tier.GetSlot(1) != 1 || tier.GetPage(2) != 3 || tier.GetLevel(0) != 2 || tier.GetResolution(0) != 1 ||
+            countA != 2 || coarseA[0] != 2.5 || coarseA[1] != 5.5 || countOdd != 0) {
+            std::cerr << VERMELHO << "[FALHA] Registros da camada grossa incorretos." << RESET << std::endl;
+            success = false;
+        }
+
+        std::cout << "[TESTE] Limite inferior..." << std::endl;
+        // Consulta {0, 0, 10, 10} na resolução 1 = {0, 10} na resolução 2;
+        // distância real até a: 1 + 4 + 1 + 8 = 14, limite: 2 * (2.5 + 4.5) = 14
+        const double query[2] = {0.0, 10.0};
+        const double bound = tier.LowerBound(0, query, std::numeric_limits<double>::infinity());
+        if (bound != 14.0 || tier.LowerBound(2, query, 0.0) != 0.0 || !(tier.LowerBound(0, query, 1.0) > 1.0)) {
+            std::cerr << VERMELHO << "[FALHA] Limite inferior incorreto: " << bound << RESET << std::endl;
+            success = false;
+        }
+    }
+    std::remove(filename.c_str());
+    if (success) {
+        std::cout << "[INFO] Camada grossa OK." << std::endl;
+    }
+
+    std::cout << "--- Teste Camada grossa Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
+bool testResultSink() {
+    std::cout << "\n--- Iniciando Teste: Destinos de resultados ---" << std::endl;
+    bool success = true;
+
+    std::cout << "[TESTE] Contagem e pares com junção de resultados parciais..." << std::endl;
+    TCountResultSink counter;
+    TPairResultSink pairs;
+    counter.Add(7, 1.5);
+    pairs.Add(7, 1.5);
+    std::unique_ptr<TResultSink> partialCounter = counter.CreateEmpty();
+    std::unique_ptr<TResultSink> partialPairs = pairs.CreateEmpty();
+    partialCounter->Add(3, 0.5);
+    partialCounter->Add(4, 2.0);
+    partialPairs->Add(3, 0.5);
+    counter.Merge(*partialCounter);
+    pairs.Merge(*partialPairs);
+    if (counter.GetCount() != 3 || pairs.GetCount() != 2 || pairs.GetPairs()[0].ObjectID != 7 ||
+        pairs.GetPairs()[1].ObjectID != 3 || pairs.GetPairs()[1].Distance != 0.5) {
+        std::cerr << VERMELHO << "[FALHA] Resultados contados ou juntados incorretamente." << RESET << std::endl;
+        success = false;
+    }
+    // Empates na distância são ordenados pelo ID
+    if (!(TResultPair{2, 1.0} < TResultPair{1, 2.0}) || !(TResultPair{1, 1.0} < TResultPair{2, 1.0})) {
+        std::cerr << VERMELHO << "[FALHA] Ordem dos pares incorreta." << RESET << std::endl;
+        success = false;
+    }
+
+    std::cout << "--- Teste Destinos de resultados Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
 // --- Função Principal ---
+bool testScanSearch() {
+    std::cout << "\n--- Iniciando Teste: Buscas do scan sequencial ---" << std::endl;
+    bool success = true;
+    const std::string textFile = "scan_search_test.txt";
+    const std::string plainFile = "scan_search_test.dat";
+    const std::string slottedFile = "scan_search_slotted_test.dat";
+    const std::string labelFile = "scan_search_labels_test.dat";
+    const size_t pageSize = 512;
+    {
+        std::ofstream out(textFile, std::ios::binary);
+        for (int i = 0; i < 90; ++i) {
+            out << "obj_" << i << " 0";
+            for (int j = 0; j < 16; ++j) {
+                out << " " << (i * 7 + j * j * 3) % 23;
+            }
+            out << "\n";
+        }
+    }
+    TLabelStore labels;
+    labels.Open(labelFile, true);
+    writeComplexObjectsToPagedFile(textFile, plainFile, pageSize, &labels);
+    labels.Close();
+    labels.Open(labelFile, true);
+    writeComplexObjectsToPagedFile(textFile, slottedFile, pageSize, &labels, true, 4);
+    labels.Close();
+
+    // Referência: laço simples sobre os objetos do arquivo, distância completa
+    int pages = 0;
+    std::vector<TComplexObject> dataset = readComplexObjectsFromPagedFile(plainFile, pageSize, pages);
+    std::vector<TComplexObject> queryData(dataset.begin(), dataset.begin() + 4);
+    std::vector<TComplexObject*> queries;
+    for (TComplexObject& query : queryData) {
+        queries.push_back(&query);
+    }
+    long long counter = 0;
+    std::vector<std::vector<TResultPair>> all(queries.size());
+    for (size_t q = 0; q < queries.size(); ++q) {
+        for (TComplexObject& obj : dataset) {
+            all[q].push_back(TResultPair{obj.GetObjectID(), calculateComplexObjectDistance(*queries[q], obj, counter)});
+        }
+    }
+    std::vector<double> distances;
+    for (const TResultPair& pair : all[0]) {
+        distances.push_back(pair.Distance);
+    }
+    std::sort(distances.begin(), distances.end());
+    const double radius = distances[distances.size() / 3];
+    const size_t k = 5;
+    std::vector<std::vector<TResultPair>> expectedRange(queries.size()), expectedNearest(queries.size());
+    for (size_t q = 0; q < queries.size(); ++q) {
+        for (const TResultPair& pair : all[q]) {
+            if (pair.Distance <= radius) {
+                expectedRange[q].push_back(pair);
+            }
+        }
+        std::vector<TResultPair> sorted = all[q];
+        std::sort(sorted.begin(), sorted.end());
+        expectedNearest[q].assign(sorted.begin(), sorted.begin() + k);
+    }
+    if (dataset.size() != 90 || pages < 3 || expectedRange[0].empty() || expectedRange[0].size() == dataset.size()) {
+        std::cerr << VERMELHO << "[FALHA] Arquivo paginado de teste incorreto." << RESET << std::endl;
+        success = false;
+    }
+
+    auto samePairs = [&](const std::vector<TPairResultSink>& results, const std::vector<std::vector<TResultPair>>& expected) {
+        for (size_t q = 0; q < expected.size(); ++q) {
+            const std::vector<TResultPair>& pairs = results[q].GetPairs();
+            if (pairs.size() != expected[q].size()) {
+                return false;
+            }
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                if (pairs[i].ObjectID != expected[q][i].ObjectID || pairs[i].Distance != expected[q][i].Distance) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    std::vector<PageZone> zones = loadPageZones(slottedFile, pageSize);
+    PageReaderOptions stream, mapped, async;
+    mapped.mode = PageReaderOptions::READER_MMAP;
+    async.mode = PageReaderOptions::READER_ASYNC;
+    async.queueDepth = 4;
+    struct ScanCase {
+        const char* name;
+        const std::string* file;
+        const PageReaderOptions* reader;
+        size_t threads;
+        const std::vector<PageZone>* zones;
+    };
+    const ScanCase cases[] = {
+        {"stream", &plainFile, &stream, 1, nullptr},
+        {"mmap", &plainFile, &mapped, 1, nullptr},
+        {"async, 3 threads", &plainFile, &async, 3, nullptr},
+        {"mmap, 3 threads", &plainFile, &mapped, 3, nullptr},
+        {"páginas slotted, zone maps, 3 threads", &slottedFile, &stream, 3, &zones},
+        {"páginas slotted, mmap, zone maps", &slottedFile, &mapped, 1, &zones},
+    };
+    if (zones.size() < 3) {
+        std::cerr << VERMELHO << "[FALHA] Zone maps das páginas slotted não carregados." << RESET << std::endl;
+        success = false;
+    }
+    for (const ScanCase& scan : cases) {
+        std::cout << "[TESTE] Faixa e kNN (" << scan.name << ")..." << std::endl;
+        std::vector<TPairResultSink> rangeResults(queries.size()), nearestResults(queries.size());
+        std::vector<TResultSink*> rangeSinks, nearestSinks;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            rangeSinks.push_back(&rangeResults[q]);
+            nearestSinks.push_back(&nearestResults[q]);
+        }
+        int pagesRead = 0;
+        if (scan.threads == 1) {
+            batchedRangeSearch(*scan.file, pageSize, queries, radius, rangeSinks, counter, pagesRead, *scan.reader,
+                               0, SIZE_MAX, scan.zones);
+        } else {
+            parallelRangeSearch(*scan.file, pageSize, queries, radius, rangeSinks, counter, pagesRead, *scan.reader,
+                                scan.threads, scan.zones);
+        }
+        parallelNearestSearch(*scan.file, pageSize, queries, k, nearestSinks, counter, pagesRead, *scan.reader,
+                              scan.threads, scan.zones);
+        if (!samePairs(rangeResults, expectedRange)) {
+            std::cerr << VERMELHO << "[FALHA] Busca por faixa difere do laço simples (" << scan.name << ")." << RESET << std::endl;
+            success = false;
+        }
+        if (!samePairs(nearestResults, expectedNearest)) {
+            std::cerr << VERMELHO << "[FALHA] Busca kNN difere do laço simples (" << scan.name << ")." << RESET << std::endl;
+            success = false;
+        }
+    }
+
+    std::cout << "[TESTE] Busca sequencial em memória..." << std::endl;
+    for (size_t q = 0; q < queries.size(); ++q) {
+        TPairResultSink sink;
+        sequentialRangeSearch(dataset, *queries[q], radius, sink, counter);
+        if (sink.GetPairs().size() != expectedRange[q].size() ||
+            !std::equal(sink.GetPairs().begin(), sink.GetPairs().end(), expectedRange[q].begin(),
+                        [](const TResultPair& a, const TResultPair& b) {
+                            return a.ObjectID == b.ObjectID && a.Distance == b.Distance;
+                        })) {
+            std::cerr << VERMELHO << "[FALHA] sequentialRangeSearch difere do laço simples." << RESET << std::endl;
+            success = false;
+        }
+    }
+
+    std::remove(textFile.c_str());
+    std::remove(plainFile.c_str());
+    std::remove(slottedFile.c_str());
+    std::remove(labelFile.c_str());
+    if (success) {
+        std::cout << "[INFO] Buscas do scan sequencial OK." << std::endl;
+    }
+
+    std::cout << "--- Teste Buscas do scan sequencial Concluído: " << (success ? VERDE "SUCESSO" : VERMELHO "FALHA") << RESET << " ---" << std::endl;
+    return success;
+}
+
 int main() {
     std::cout << "========= INICIANDO SUÍTE DE TESTES UNITÁRIOS =========" << std::endl;
 
@@ -332,12 +1523,42 @@ int main() {
     if (!testVectorFileReader()) {
         all_tests_passed = false;
     }
+    if (!testVectorFileReaderParser()) {
+        all_tests_passed = false;
+    }
+    if (!testVectorFileReaderStreaming()) {
+        all_tests_passed = false;
+    }
+    if (!testIngestPipeline()) {
+        all_tests_passed = false;
+    }
+    if (!testBinaryDataset()) {
+        all_tests_passed = false;
+    }
     if (!testComplexObject()) {
         all_tests_passed = false;
     }
     if (!testDistanceCalculator()) {
         all_tests_passed = false;
     }
+    if (!testLabelStore()) {
+        all_tests_passed = false;
+    }
+    if (!testSlottedPage()) {
+        all_tests_passed = false;
+    }
+    if (!testAsyncPageReader()) {
+        all_tests_passed = false;
+    }
+    if (!testCoarseTier()) {
+        all_tests_passed = false;
+    }
+    if (!testResultSink()) {
+        all_tests_passed = false;
+    }
+    if (!testScanSearch()) {
+        all_tests_passed = false;
+    }
 
     std::cout << "\n========= RESULTADO FINAL DA SUÍTE DE TESTES =========" << std::endl;
     if (all_tests_passed) {